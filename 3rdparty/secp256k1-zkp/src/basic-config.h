@@ -21,12 +21,21 @@
 #undef USE_SCALAR_8X32
 #undef USE_SCALAR_INV_BUILTIN
 #undef USE_SCALAR_INV_NUM
+#undef HAVE___INT128
 
 #define USE_NUM_NONE 1
 #define USE_FIELD_INV_BUILTIN 1
 #define USE_SCALAR_INV_BUILTIN 1
+
+#if defined(__SIZEOF_INT128__) && defined(__LP64__)
+// 64-bit limbs (with 128-bit intermediate products) roughly halve the number of limb multiplications
+#define HAVE___INT128 1
+#define USE_FIELD_5X52 1
+#define USE_SCALAR_4X64 1
+#else
 #define USE_FIELD_10X26 1
 #define USE_SCALAR_8X32 1
+#endif
 
 #endif // USE_BASIC_CONFIG
 #endif // _SECP256K1_BASIC_CONFIG_
@@ -372,6 +372,9 @@ int main_impl(int argc, char* argv[])
 					}
 
 					node.m_Cfg.m_VerificationThreads = vm[cli::VERIFICATION_THREADS].as<int>();
+					node.m_Cfg.m_HdrSync.m_MaxPacks = vm[cli::HDR_SYNC_PACKS].as<uint32_t>();
+					node.m_Cfg.m_CompactBlocks = vm[cli::COMPACT_BLOCKS].as<bool>();
+					node.m_Cfg.m_ListenThreads = vm[cli::LISTEN_THREADS].as<uint32_t>();
 
 					node.m_Cfg.m_LogEvents = vm[cli::LOG_UTXOS].as<bool>();
 
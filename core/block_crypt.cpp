@@ -301,6 +301,11 @@ namespace beam
 		m_Cid.get_Hash(hv);
 		kdf.DeriveKey(sk, hv);
 
+		CreateInternal2(sk, comm, bComm);
+	}
+
+	void CoinID::Worker::CreateInternal2(ECC::Scalar::Native& sk, ECC::Point::Native& comm, bool bComm) const
+	{
 		comm = ECC::Context::get().G * sk;
 		AddValue(comm);
 
@@ -332,6 +337,11 @@ namespace beam
 		comm = comm2;
 	}
 
+	void CoinID::Worker::CreateFromKey(ECC::Scalar::Native& sk, ECC::Point::Native& comm) const
+	{
+		CreateInternal2(sk, comm, true);
+	}
+
 	void CoinID::Worker::Recover(ECC::Point::Native& res, Key::IPKdf& pkdf) const
 	{
 		ECC::Hash::Value hv;
@@ -457,6 +467,11 @@ namespace beam
 #pragma pack (pop)
 
 	void Output::Create(Height hScheme, ECC::Scalar::Native& sk, Key::IKdf& coinKdf, const CoinID& cid, Key::IPKdf& tagKdf, OpCode::Enum eOp, const User* pUser)
+	{
+		CreateInternal(hScheme, sk, &coinKdf, cid, tagKdf, eOp, pUser);
+	}
+
+	void Output::CreateInternal(Height hScheme, ECC::Scalar::Native& sk, Key::IKdf* pCoinKdf, const CoinID& cid, Key::IPKdf& tagKdf, OpCode::Enum eOp, const User* pUser)
 	{
 		CoinID::Worker wrk(cid);
 
@@ -469,7 +484,14 @@ namespace beam
 			break;
 
 		default:
-			wrk.Create(sk, m_Commitment, coinKdf);
+			if (pCoinKdf)
+				wrk.Create(sk, m_Commitment, *pCoinKdf);
+			else
+			{
+				ECC::Point::Native comm;
+				wrk.CreateFromKey(sk, comm);
+				m_Commitment = comm;
+			}
 		}
 
 		ECC::Scalar::Native skSign = sk;
@@ -543,6 +565,60 @@ namespace beam
 		}
 	}
 
+	void Output::CreateBatch(Height hScheme, const Ptr* pOutputs, ECC::Scalar::Native* pSk, Key::IKdf& coinKdf, const CoinID* pCid, uint32_t nCount, Key::IPKdf& tagKdf)
+	{
+		struct MyTask
+			:public Executor::TaskSync
+		{
+			Height m_hScheme;
+			const Ptr* m_pOutputs;
+			ECC::Scalar::Native* m_pSk;
+			Key::IKdf* m_pCoinKdf;
+			const CoinID* m_pCid;
+			Key::IPKdf* m_pTagKdf;
+			uint32_t m_Count;
+
+			void Create(uint32_t i0, uint32_t nPortion)
+			{
+				// the coin keys are derived in chunks, via the batch kdf call
+				const uint32_t nChunk = 64;
+				ECC::Hash::Value pHv[nChunk];
+
+				for (uint32_t iEnd = i0 + nPortion; i0 < iEnd; )
+				{
+					uint32_t n = std::min(nChunk, iEnd - i0);
+					for (uint32_t j = 0; j < n; j++)
+						m_pCid[i0 + j].get_Hash(pHv[j]);
+
+					m_pCoinKdf->DeriveKeyBatch(m_pSk + i0, pHv, n);
+
+					for (uint32_t j = 0; j < n; j++, i0++)
+						m_pOutputs[i0]->CreateInternal(m_hScheme, m_pSk[i0], nullptr, m_pCid[i0], *m_pTagKdf, OpCode::Standard, nullptr);
+				}
+			}
+
+			virtual void Exec(Executor::Context& ctx) override
+			{
+				uint32_t i0, nPortion;
+				ctx.get_Portion(i0, nPortion, m_Count);
+				Create(i0, nPortion);
+			}
+		} t;
+
+		t.m_hScheme = hScheme;
+		t.m_pOutputs = pOutputs;
+		t.m_pSk = pSk;
+		t.m_pCoinKdf = &coinKdf;
+		t.m_pCid = pCid;
+		t.m_pTagKdf = &tagKdf;
+		t.m_Count = nCount;
+
+		if (Executor::s_pInstance && (nCount > 1))
+			Executor::s_pInstance->ExecAll(t);
+		else
+			t.Create(0, nCount);
+	}
+
 	void Output::GenerateSeedKid(ECC::uintBig& seed, const ECC::Point& commitment, Key::IPKdf& tagKdf)
 	{
 		ECC::Hash::Processor() << commitment >> seed;
@@ -550,7 +626,12 @@ namespace beam
 		ECC::Scalar::Native sk;
 		tagKdf.DerivePKey(sk, seed);
 
-		ECC::Hash::Processor() << sk >> seed;
+		SeedKidFromKey(seed, sk);
+	}
+
+	void Output::SeedKidFromKey(ECC::uintBig& seed, const ECC::Scalar::Native& skTag)
+	{
+		ECC::Hash::Processor() << skTag >> seed;
 	}
 
 	void Output::Prepare(ECC::Oracle& oracle, Height hScheme) const
@@ -565,9 +646,20 @@ namespace beam
 	}
 
 	bool Output::Recover(Height hScheme, Key::IPKdf& tagKdf, CoinID& cid, User* pUser) const
+	{
+		if (!m_pConfidential && !m_pPublic)
+			return false; // don't bother with the key derivation
+
+		ECC::uintBig seed;
+		GenerateSeedKid(seed, m_Commitment, tagKdf);
+
+		return RecoverFromSeed(hScheme, seed, cid, pUser);
+	}
+
+	bool Output::RecoverFromSeed(Height hScheme, const ECC::uintBig& seed, CoinID& cid, User* pUser) const
 	{
 		ECC::RangeProof::CreatorParams cp;
-		GenerateSeedKid(cp.m_Seed.V, m_Commitment, tagKdf);
+		cp.m_Seed.V = seed;
 
 		ECC::Oracle oracle;
 		Prepare(oracle, hScheme);
@@ -596,9 +688,6 @@ namespace beam
 		}
 		else
 		{
-			if (!m_pPublic)
-				return false;
-
 			Key::ID::Packed kid;
 			cp.m_Blob.p = &kid;
 			cp.m_Blob.n = sizeof(kid);
@@ -620,6 +709,76 @@ namespace beam
 		return true;
 	}
 
+	void Output::RecoverBatch(Height hScheme, Key::IPKdf& tagKdf, const Ptr* pOutputs, uint32_t nCount, Recovered* pRes)
+	{
+		struct MyTask
+			:public Executor::TaskSync
+		{
+			Height m_hScheme;
+			Key::IPKdf* m_pKdf;
+			const Ptr* m_pOutputs;
+			Recovered* m_pRes;
+			uint32_t m_Count;
+
+			void Recover(uint32_t i0, uint32_t nPortion)
+			{
+				// the tag keys are derived in chunks, via the batch kdf call
+				const uint32_t nChunk = 64;
+				ECC::Hash::Value pHv[nChunk];
+				ECC::Scalar::Native pSk[nChunk];
+				uint32_t pIdx[nChunk];
+
+				for (uint32_t iEnd = i0 + nPortion; i0 < iEnd; )
+				{
+					uint32_t n = 0;
+					for ( ; (i0 < iEnd) && (n < nChunk); i0++)
+					{
+						const Output& outp = *m_pOutputs[i0];
+						m_pRes[i0].m_Valid = false;
+
+						if (outp.m_pConfidential || outp.m_pPublic)
+						{
+							ECC::Hash::Processor() << outp.m_Commitment >> pHv[n];
+							pIdx[n++] = i0;
+						}
+					}
+
+					if (!n)
+						continue;
+
+					m_pKdf->DerivePKeyBatch(pSk, pHv, n);
+
+					for (uint32_t j = 0; j < n; j++)
+					{
+						ECC::uintBig seed;
+						SeedKidFromKey(seed, pSk[j]);
+
+						Recovered& r = m_pRes[pIdx[j]];
+						r.m_Valid = m_pOutputs[pIdx[j]]->RecoverFromSeed(m_hScheme, seed, r.m_Cid, &r.m_User);
+					}
+				}
+			}
+
+			virtual void Exec(Executor::Context& ctx) override
+			{
+				uint32_t i0, nPortion;
+				ctx.get_Portion(i0, nPortion, m_Count);
+				Recover(i0, nPortion);
+			}
+		} t;
+
+		t.m_hScheme = hScheme;
+		t.m_pKdf = &tagKdf;
+		t.m_pOutputs = pOutputs;
+		t.m_pRes = pRes;
+		t.m_Count = nCount;
+
+		if (Executor::s_pInstance && (nCount > 1))
+			Executor::s_pInstance->ExecAll(t);
+		else
+			t.Recover(0, nCount);
+	}
+
 	bool Output::VerifyRecovered(Key::IPKdf& coinKdf, const CoinID& cid) const
 	{
 		// reconstruct the commitment
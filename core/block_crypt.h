@@ -347,7 +347,8 @@ namespace beam
         virtual void StartThread(MyThread&, uint32_t iThread) override;
         void RunThreadInternal(uint32_t iThread, const Rules&);
         virtual void RunThread(uint32_t iThread);
-
+    public:
+        ~ExecutorMT_R() { Stop(); } // while RunThread is still dispatched to this class
     };
 
     struct CoinID
@@ -432,6 +433,7 @@ namespace beam
         {
             static void get_sk1(ECC::Scalar::Native& res, const ECC::Point::Native& comm0, const ECC::Point::Native& sk0_J);
             void CreateInternal(ECC::Scalar::Native&, ECC::Point::Native&, bool bComm, Key::IKdf& kdf) const;
+            void CreateInternal2(ECC::Scalar::Native&, ECC::Point::Native&, bool bComm) const;
 
         public:
             const CoinID& m_Cid;
@@ -443,6 +445,7 @@ namespace beam
             void Create(ECC::Scalar::Native& sk, Key::IKdf&) const;
             void Create(ECC::Scalar::Native& sk, ECC::Point::Native& comm, Key::IKdf&) const;
             void Create(ECC::Scalar::Native& sk, ECC::Point& comm, Key::IKdf&) const;
+            void CreateFromKey(ECC::Scalar::Native& sk, ECC::Point::Native& comm) const; // sk: in - the derived key (see Key::IKdf::DeriveKeyBatch), out - the blinding factor
 
             void Recover(ECC::Point::Native& comm, Key::IPKdf&) const;
             void Recover(ECC::Point::Native& pkG_in_res_out, const ECC::Point::Native& pkJ) const;
@@ -619,7 +622,22 @@ namespace beam
 
         void Create(Height hScheme, ECC::Scalar::Native&, Key::IKdf& coinKdf, const CoinID&, Key::IPKdf& tagKdf, OpCode::Enum = OpCode::Standard, const User* = nullptr);
 
+        // Create multiple standard outputs (allocated by the caller) at once. If an Executor is installed - the work is split across its threads,
+        // hence the kdfs must be safe to use concurrently
+        static void CreateBatch(Height hScheme, const Ptr* pOutputs, ECC::Scalar::Native* pSk, Key::IKdf& coinKdf, const CoinID* pCid, uint32_t nCount, Key::IPKdf& tagKdf);
+
         bool Recover(Height hScheme, Key::IPKdf& tagKdf, CoinID&, User* = nullptr) const;
+
+        struct Recovered
+        {
+            CoinID m_Cid;
+            User m_User;
+            bool m_Valid;
+        };
+
+        // Recover multiple outputs (i.e. all the block outputs) at once. If an Executor is installed - the work is split across its threads,
+        // hence the tagKdf must be safe to use concurrently (which is the case for the standard HKdf/HKdfPub)
+        static void RecoverBatch(Height hScheme, Key::IPKdf& tagKdf, const Ptr* pOutputs, uint32_t nCount, Recovered* pRes);
         bool VerifyRecovered(Key::IPKdf& coinKdf, const CoinID&) const;
 
         bool IsValid(Height hScheme, ECC::Point::Native& comm) const;
@@ -637,6 +655,9 @@ namespace beam
     private:
         struct PackedKA; // Key::ID + Asset::ID
         bool IsValid2(Height hScheme, ECC::Point::Native& comm, const ECC::Point::Native* pGen) const;
+        void CreateInternal(Height hScheme, ECC::Scalar::Native&, Key::IKdf* pCoinKdf, const CoinID&, Key::IPKdf& tagKdf, OpCode::Enum, const User*); // if no coinKdf - sk is already derived
+        bool RecoverFromSeed(Height hScheme, const ECC::uintBig& seed, CoinID&, User*) const;
+        static void SeedKidFromKey(ECC::uintBig&, const ECC::Scalar::Native& skTag);
     };
 
     inline bool operator < (const Output::Ptr& a, const Output::Ptr& b) { return *a < *b; }
@@ -1570,12 +1591,17 @@ namespace beam
 
         void Reset();
 
+        // If no InnerProduct::BatchContext is in scope - signatures and range proofs are verified in a local batch, settled at the end.
+        // Otherwise they're accumulated in the caller's batch, and the caller is responsible to flush it.
         bool ValidateAndSummarize(const TxBase&, IReader&&);
         bool Merge(const Context&);
 
         // hi-level functions, should be used after all parts were validated and merged
         bool IsValidTransaction();
         bool IsValidBlock();
+
+    private:
+        bool ValidateAndSummarizeInternal(const TxBase&, IReader&&);
     };
 
     struct Block::ChainWorkProof
@@ -66,6 +66,22 @@ namespace beam
 	}
 
 	bool TxBase::Context::ValidateAndSummarize(const TxBase& txb, IReader&& r)
+	{
+		if (ECC::InnerProduct::BatchContext::s_pInstance)
+			return ValidateAndSummarizeInternal(txb, std::move(r));
+
+		// kernel signatures and range proofs are settled in a single multi-exponentiation
+		typedef ECC::InnerProduct::BatchContextEx<4> MyBatch;
+
+		std::unique_ptr<MyBatch> pBc(new MyBatch);
+		MyBatch::Scope scope(*pBc);
+
+		return
+			ValidateAndSummarizeInternal(txb, std::move(r)) &&
+			pBc->Flush();
+	}
+
+	bool TxBase::Context::ValidateAndSummarizeInternal(const TxBase& txb, IReader&& r)
 	{
 		if (m_Height.IsEmpty())
 			return false;
@@ -602,6 +602,111 @@ namespace ECC {
 		return true;
 	}
 
+	void Point::Native::ImportBatch(secp256k1_ge* pTrg, const Storage* pSrc, uint32_t nCount)
+	{
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			secp256k1_ge& ge = pTrg[i];
+			const Storage& v = pSrc[i];
+
+			ge.infinity = memis0(&v, sizeof(v));
+			if (!ge.infinity)
+			{
+				secp256k1_fe_set_b32(&ge.x, v.m_X.m_pData);
+				secp256k1_fe_set_b32(&ge.y, v.m_Y.m_pData);
+			}
+		}
+	}
+
+	struct BatchNormalizer_Nnz
+		:public Point::Native::BatchNormalizer_Arr
+	{
+		// zero points are skipped
+		std::vector<secp256k1_fe> m_vFes;
+
+		BatchNormalizer_Nnz(Point::Native* pPts, uint32_t nCount)
+			:m_vFes(nCount)
+		{
+			m_pPts = pPts;
+			m_pFes = m_vFes.data();
+			m_Size = nCount;
+		}
+
+		bool FindPrev(uint32_t& iIdx) const
+		{
+			while (iIdx)
+				if (m_pPts[--iIdx] != Zero)
+					return true;
+			return false;
+		}
+
+		virtual bool MoveNext(Element& el) override
+		{
+			for (; m_iIdx < m_Size; m_iIdx++)
+			{
+				if (m_pPts[m_iIdx] != Zero)
+				{
+					get_At(el, m_iIdx++);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		virtual bool MovePrev(Element& el) override
+		{
+			uint32_t i1 = m_iIdx, i2;
+			if (!FindPrev(i1))
+				return false;
+
+			i2 = i1;
+			if (!FindPrev(i2))
+				return false;
+
+			m_iIdx = i1;
+			get_At(el, i2);
+			return true;
+		}
+	};
+
+	void Point::Native::ExportBatch(Point* pTrg, Native* pSrc, uint32_t nCount)
+	{
+		BatchNormalizer_Nnz bn(pSrc, nCount);
+		bn.Normalize();
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			if (pSrc[i] == Zero)
+				ZeroObject(pTrg[i]);
+			else
+			{
+				secp256k1_ge ge;
+				BatchNormalizer::get_As(ge, pSrc[i]);
+				secp256k1_fe_normalize(&ge.x);
+				secp256k1_fe_normalize(&ge.y);
+				ExportEx(pTrg[i], ge);
+			}
+		}
+	}
+
+	void Point::Native::ExportBatch(Storage* pTrg, Native* pSrc, uint32_t nCount)
+	{
+		BatchNormalizer_Nnz bn(pSrc, nCount);
+		bn.Normalize();
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			if (pSrc[i] == Zero)
+				ZeroObject(pTrg[i]);
+			else
+			{
+				secp256k1_ge ge;
+				BatchNormalizer::get_As(ge, pSrc[i]);
+				pTrg[i].FromNnz(ge);
+			}
+		}
+	}
+
 	void Point::Native::BatchNormalizer::Normalize()
 	{
 		secp256k1_fe zDenom;
@@ -1006,6 +1111,77 @@ namespace ECC {
 			SetMul(res, bSet, pPts, k.get().d, _countof(k.get().d));
 		}
 
+		std::atomic<bool> Fast::s_Enabled(true);
+
+		bool Fast::ShouldUse(const Fast* p)
+		{
+			return p && s_Enabled.load(std::memory_order_relaxed) && (Mode::Fast == g_Mode);
+		}
+
+		void Fast::Init(const Point::Native& pt, uint32_t nBits_)
+		{
+			assert(!(nBits_ % nBitsPerLevel));
+			m_nLevels = nBits_ / nBitsPerLevel;
+
+			Point::Native dup = pt;
+			Point::Compact::Converter cpc;
+			cpc.set_Deferred(m_Base, dup);
+			cpc.Flush();
+		}
+
+		void Fast::Build()
+		{
+			m_vPts.resize(static_cast<size_t>(m_nLevels) * nPointsPerLevel);
+
+			Point::Compact::Converter cpc;
+			Point::Native pt, ptLevel;
+			m_Base.Assign(ptLevel, true);
+
+			for (uint32_t iLev = 0; iLev < m_nLevels; iLev++)
+			{
+				Point::Compact* pPts = &m_vPts.front() + iLev * nPointsPerLevel;
+				pt = ptLevel;
+
+				for (uint32_t i = 0; i < nPointsPerLevel; i++)
+				{
+					cpc.set_Deferred(pPts[i], pt);
+					pt += ptLevel;
+				}
+
+				ptLevel = pt; // next level base: x256
+			}
+
+			cpc.Flush();
+		}
+
+		void Fast::SetMul(Point::Native& res, bool bSet, const Scalar::Native::uint* p, int nWords)
+		{
+			std::call_once(m_Once, [this]() { Build(); });
+
+			const int nLevelsPerWord = sizeof(Scalar::Native::uint);
+			static_assert(nBitsPerLevel == 8, "");
+			assert(static_cast<uint32_t>(nWords * nLevelsPerWord) <= m_nLevels);
+
+			if (bSet)
+				res = Zero;
+
+			const Point::Compact* pPts = &m_vPts.front();
+
+			for (int iWord = 0; iWord < nWords; iWord++)
+			{
+				Scalar::Native::uint n = p[iWord];
+
+				for (int j = 0; j < nLevelsPerWord; j++, pPts += nPointsPerLevel)
+				{
+					uint32_t nSel = static_cast<uint8_t>(n);
+					n >>= nBitsPerLevel;
+
+					if (nSel)
+						res += pPts[nSel - 1];
+				}
+			}
+		}
+
 		void GeneratePts(const Point::Native& pt, Oracle& oracle, Point::Compact* pPts, uint32_t nLevels, Point::Compact::Converter& cpc)
 		{
 			while (true)
@@ -1047,7 +1223,12 @@ namespace ECC {
 				Generator::SetMul(res, false, m_pPts, kTmp);
 			}
 			else
-				Generator::SetMul(res, bSet, m_pPts, k);
+			{
+				if (Fast::ShouldUse(m_pFast))
+					m_pFast->SetMul(res, bSet, k.get().d, _countof(k.get().d));
+				else
+					Generator::SetMul(res, bSet, m_pPts, k);
+			}
 		}
 
 		template <>
@@ -1442,6 +1623,46 @@ namespace ECC {
 		return true;
 	}
 
+	void MultiMac::Casual::GenerateBatch(Casual* pArr, uint32_t nCount)
+	{
+		if (Mode::Fast != g_Mode)
+			return; // in secure mode everything is already calculated by Init()
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			Fast& f = pArr[i].U.F.get();
+
+			Point::Native& pt = f.m_pPt[0];
+			if (pt == Zero)
+			{
+				f.m_nNeeded = 0;
+				continue;
+			}
+
+			f.m_nNeeded = Fast::nCount;
+
+			Point::Native ptX2 = pt * Two;
+			for (uint32_t nPrepared = 1; nPrepared < f.m_nNeeded; nPrepared++)
+				f.m_pPt[nPrepared] = f.m_pPt[nPrepared - 1] + ptX2;
+		}
+
+		MultiMac mm;
+		mm.m_pCasual = pArr;
+		mm.m_Casual = static_cast<int>(nCount);
+
+		secp256k1_fe zDenom;
+		Normalizer nrm(mm);
+		nrm.ToCommonDenominator(zDenom);
+
+		// Calculate() with Reuse::UseGenerated takes the denominator from the 1st used element, assign it to all
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			Fast& f = pArr[i].U.F.get();
+			if (f.m_nNeeded)
+				f.m_pPt[0].get_Raw().z = zDenom;
+		}
+	}
+
 	void MultiMac::Calculate(Point::Native& res) const
 	{
 		const unsigned int nBitsPerWord = sizeof(Scalar::Native::uint) << 3;
@@ -1683,6 +1904,189 @@ namespace ECC {
 		}
 	}
 
+	struct MultiMac_Dyn::Normalizer
+		:public Point::Native::BatchNormalizer
+	{
+		// casual points (1st element only), zero points are skipped
+		MultiMac_Dyn& m_This;
+		int m_iIdx;
+
+		Normalizer(MultiMac_Dyn& mm) :m_This(mm) {}
+
+		bool IsZero(int iIdx) const
+		{
+			return m_This.m_pCasual[iIdx].U.F.get().m_pPt[0] == Zero;
+		}
+
+		bool FindPrev(int& iIdx) const
+		{
+			while (iIdx)
+				if (!IsZero(--iIdx))
+					return true;
+			return false;
+		}
+
+		void get_At(Element& el, int iIdx)
+		{
+			Casual::Fast& f = m_This.m_pCasual[iIdx].U.F.get();
+			el.m_pPoint = f.m_pPt;
+			el.m_pFe = f.m_pFe;
+		}
+
+		virtual void Reset() override
+		{
+			m_iIdx = 0;
+		}
+
+		virtual bool MoveNext(Element& el) override
+		{
+			for (; m_iIdx < m_This.m_Casual; m_iIdx++)
+			{
+				if (!IsZero(m_iIdx))
+				{
+					get_At(el, m_iIdx++);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		virtual bool MovePrev(Element& el) override
+		{
+			int i1 = m_iIdx, i2;
+			if (!FindPrev(i1))
+				return false;
+
+			i2 = i1;
+			if (!FindPrev(i2))
+				return false;
+
+			m_iIdx = i1;
+			get_At(el, i2);
+			return true;
+		}
+	};
+
+	void MultiMac_Dyn::Calculate(Point::Native& res)
+	{
+		if ((Mode::Fast != g_Mode) || (Reuse::None != m_ReuseFlag) || (static_cast<uint32_t>(m_Casual) < MultiMac_Pippenger::s_Threshold))
+		{
+			MultiMac::Calculate(res);
+			return;
+		}
+
+		Normalizer nrm(*this);
+		nrm.Normalize();
+
+		std::vector<secp256k1_ge> vPts(m_Casual);
+		for (int i = 0; i < m_Casual; i++)
+		{
+			const Point::Native& pt = m_pCasual[i].U.F.get().m_pPt[0];
+			Point::Native::BatchNormalizer::get_As(vPts[i], pt);
+		}
+
+		MultiMac_Pippenger mmp;
+		mmp.m_pPts = &vPts.front();
+		mmp.m_pK = m_pKCasual;
+		mmp.m_Count = m_Casual;
+		mmp.Calculate(res);
+
+		if (m_Prepared)
+		{
+			int nCasual = m_Casual;
+			m_Casual = 0;
+
+			Point::Native pt;
+			MultiMac::Calculate(pt);
+			res += pt;
+
+			m_Casual = nCasual;
+		}
+	}
+
+	uint32_t MultiMac_Pippenger::get_WndBits(uint32_t nCount)
+	{
+		// per window: nCount mixed additions into the buckets, and 2 (full) additions per bucket to sum them
+		uint32_t nRet = 1;
+		uint64_t nCostMin = static_cast<uint64_t>(-1);
+
+		for (uint32_t nWndBits = 1; nWndBits <= s_MaxWndBits; nWndBits++)
+		{
+			uint32_t nWnds = (nBits + nWndBits - 1) / nWndBits;
+			uint64_t nCost = static_cast<uint64_t>(nWnds) * (nCount + (uint64_t(3) << nWndBits));
+
+			if (nCost < nCostMin)
+			{
+				nCostMin = nCost;
+				nRet = nWndBits;
+			}
+		}
+
+		return nRet;
+	}
+
+	void MultiMac_Pippenger::Calculate(Point::Native& res, uint32_t iWorker /* = 0 */, uint32_t nWorkers /* = 1 */) const
+	{
+		assert(iWorker < nWorkers);
+		res = Zero;
+
+		const uint32_t nWndBits = get_WndBits(m_Count);
+		const uint32_t nWnds = (nBits + nWndBits - 1) / nWndBits;
+		if (iWorker >= nWnds)
+			return;
+
+		// this worker handles windows iWorker + k * nWorkers, processed from the highest
+		uint32_t iWnd = iWorker + (nWnds - 1 - iWorker) / nWorkers * nWorkers;
+
+		std::vector<secp256k1_gej> vBuckets((size_t(1) << nWndBits) - 1);
+		secp256k1_gej& acc = res.get_Raw();
+		secp256k1_gej sumRunning, sumWnd;
+
+		while (true)
+		{
+			if (res != Zero)
+				for (uint32_t i = 0; i < nWndBits * nWorkers; i++)
+					secp256k1_gej_double_var(&acc, &acc, nullptr);
+
+			for (size_t i = 0; i < vBuckets.size(); i++)
+				secp256k1_gej_set_infinity(&vBuckets[i]);
+
+			uint32_t iBit = iWnd * nWndBits;
+			uint32_t nBitsWnd = std::min(nWndBits, nBits - iBit);
+
+			for (uint32_t i = 0; i < m_Count; i++)
+			{
+				unsigned int nDigit = secp256k1_scalar_get_bits_var(&m_pK[i].get(), iBit, nBitsWnd);
+				if (nDigit && !m_pPts[i].infinity)
+				{
+					secp256k1_gej& b = vBuckets[nDigit - 1];
+					secp256k1_gej_add_ge_var(&b, &b, m_pPts + i, nullptr);
+				}
+			}
+
+			// sum(Digit * Bucket) by the running sums, from the highest bucket
+			secp256k1_gej_set_infinity(&sumRunning);
+			secp256k1_gej_set_infinity(&sumWnd);
+
+			for (size_t i = vBuckets.size(); i--; )
+			{
+				secp256k1_gej_add_var(&sumRunning, &sumRunning, &vBuckets[i], nullptr);
+				secp256k1_gej_add_var(&sumWnd, &sumWnd, &sumRunning, nullptr);
+			}
+
+			secp256k1_gej_add_var(&acc, &acc, &sumWnd, nullptr);
+
+			if (iWnd < nWorkers)
+				break;
+			iWnd -= nWorkers;
+		}
+
+		// shift to the position of the lowest window of this worker
+		if (res != Zero)
+			for (uint32_t i = 0; i < nWndBits * iWorker; i++)
+				secp256k1_gej_double_var(&acc, &acc, nullptr);
+	}
+
 
 	/////////////////////
 	// ScalarGenerator
@@ -1737,6 +2141,7 @@ namespace ECC {
 	/////////////////////
 	// Context
 	AlignedBuf<Context> g_ContextBuf;
+	Generator::Fast g_pFastGen[3]; // G, H, J
 
 	// Currently - auto-init in global obj c'tor
 	Initializer g_Initializer;
@@ -1781,6 +2186,11 @@ namespace ECC {
 		ctx.H_Big.Initialize(H_raw, oracle, cpc);
 		ctx.J.Initialize(J_raw, oracle, cpc);
 
+		// fast-mode tables are built on-demand
+		g_pFastGen[0].Init(G_raw, nBits);
+		g_pFastGen[1].Init(H_raw, sizeof(Amount) << 3);
+		g_pFastGen[2].Init(J_raw, nBits);
+
 		cpc.Flush();
 
 		Point::Native pt, ptAux2(Zero);
@@ -1883,6 +2293,11 @@ namespace ECC {
 		ctx.m_Sig.m_CfgGH2.m_nG = 2;
 		ctx.m_Sig.m_CfgGH2.m_pG = ctx.m_Sig.m_pGenGH;
 
+		ctx.G.m_pFast = g_pFastGen;
+		ctx.H.m_pFast = g_pFastGen + 1;
+		ctx.H_Big.m_pFast = nullptr;
+		ctx.J.m_pFast = g_pFastGen + 2;
+
 #ifndef NDEBUG
 		g_bContextInitialized = true;
 #endif // NDEBUG
@@ -2050,6 +2465,20 @@ namespace ECC {
 			>> out;
 	}
 
+	void HKdf::Generator::GenerateBatch(Scalar::Native* pOut, const Hash::Value* pHv, uint32_t nCount) const
+	{
+		NonceGenerator ng0("beam-Key");
+		ng0 << m_Secret.V;
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			NonceGenerator ng = ng0;
+			ng
+				<< pHv[i]
+				>> pOut[i];
+		}
+	}
+
 	HKdf::HKdf()
 	{
 		m_kCoFactor = 1U; // by default
@@ -2116,6 +2545,42 @@ namespace ECC {
 		m_Generator.Generate(out, hv);
 	}
 
+	void HKdf::DeriveKeyBatch(Scalar::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		m_Generator.GenerateBatch(pOut, pHv, nCount);
+		for (uint32_t i = 0; i < nCount; i++)
+			pOut[i] *= m_kCoFactor;
+	}
+
+	void HKdf::DerivePKeyBatch(Scalar::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		m_Generator.GenerateBatch(pOut, pHv, nCount);
+	}
+
+	void Key::IPKdf::DerivePKeyBatch(Scalar::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		for (uint32_t i = 0; i < nCount; i++)
+			DerivePKey(pOut[i], pHv[i]);
+	}
+
+	void Key::IPKdf::DerivePKeyGBatch(Point::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		for (uint32_t i = 0; i < nCount; i++)
+			DerivePKeyG(pOut[i], pHv[i]);
+	}
+
+	void Key::IPKdf::DerivePKeyJBatch(Point::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		for (uint32_t i = 0; i < nCount; i++)
+			DerivePKeyJ(pOut[i], pHv[i]);
+	}
+
+	void Key::IKdf::DeriveKeyBatch(Scalar::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		for (uint32_t i = 0; i < nCount; i++)
+			DeriveKey(pOut[i], pHv[i]);
+	}
+
 	void Key::IKdf::DerivePKeyG(Point::Native& out, const Hash::Value& hv)
 	{
 		Scalar::Native sk;
@@ -2130,6 +2595,30 @@ namespace ECC {
 		out = Context::get().J * sk;
 	}
 
+	void Key::IKdf::DerivePKeyGBatch(Point::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		if (!nCount)
+			return;
+
+		std::vector<Scalar::Native> vSk(nCount);
+		DeriveKeyBatch(&vSk.front(), pHv, nCount);
+
+		for (uint32_t i = 0; i < nCount; i++)
+			pOut[i] = Context::get().G * vSk[i];
+	}
+
+	void Key::IKdf::DerivePKeyJBatch(Point::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		if (!nCount)
+			return;
+
+		std::vector<Scalar::Native> vSk(nCount);
+		DeriveKeyBatch(&vSk.front(), pHv, nCount);
+
+		for (uint32_t i = 0; i < nCount; i++)
+			pOut[i] = Context::get().J * vSk[i];
+	}
+
 	HKdfPub::HKdfPub()
 	{
 	}
@@ -2157,6 +2646,46 @@ namespace ECC {
 		out = m_PkJ * sk;
 	}
 
+	void HKdfPub::DerivePKeyBatch(Scalar::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		m_Generator.GenerateBatch(pOut, pHv, nCount);
+	}
+
+	void HKdfPub::MulBatch(Point::Native* pOut, const Point::Native& pk, const Hash::Value* pHv, uint32_t nCount)
+	{
+		if (!nCount)
+			return;
+
+		std::vector<Scalar::Native> vSk(nCount);
+		m_Generator.GenerateBatch(&vSk.front(), pHv, nCount);
+
+		// the point precalculated multiples are evaluated once, and reused for all the multiplications
+		MultiMac::Casual mc;
+		mc.Init(pk);
+
+		MultiMac mm;
+		mm.m_pCasual = &mc;
+		mm.m_Casual = 1;
+		mm.m_ReuseFlag = MultiMac::Reuse::Generate;
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			mm.m_pKCasual = &vSk[i];
+			mm.Calculate(pOut[i]);
+			mm.m_ReuseFlag = MultiMac::Reuse::UseGenerated;
+		}
+	}
+
+	void HKdfPub::DerivePKeyGBatch(Point::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		MulBatch(pOut, m_PkG, pHv, nCount);
+	}
+
+	void HKdfPub::DerivePKeyJBatch(Point::Native* pOut, const Hash::Value* pHv, uint32_t nCount)
+	{
+		MulBatch(pOut, m_PkJ, pHv, nCount);
+	}
+
 	uint32_t HKdf::ExportP(void* p) const
 	{
 		HKdfPub pkdf;
@@ -286,6 +286,11 @@ namespace ECC
 			virtual void DerivePKeyG(Point::Native&, const Hash::Value&) = 0;
 			virtual void DerivePKeyJ(Point::Native&, const Hash::Value&) = 0;
 
+			// batch variants. By default the keys are just derived one-by-one
+			virtual void DerivePKeyBatch(Scalar::Native*, const Hash::Value*, uint32_t nCount);
+			virtual void DerivePKeyGBatch(Point::Native*, const Hash::Value*, uint32_t nCount);
+			virtual void DerivePKeyJBatch(Point::Native*, const Hash::Value*, uint32_t nCount);
+
 			bool IsSame(IPKdf&);
 
 			virtual uint32_t ExportP(void*) const { return 0; } // returns the size, ptr is optional
@@ -298,9 +303,12 @@ namespace ECC
 
 			void DeriveKey(Scalar::Native&, const Key::ID&);
 			virtual void DeriveKey(Scalar::Native&, const Hash::Value&) = 0;
+			virtual void DeriveKeyBatch(Scalar::Native*, const Hash::Value*, uint32_t nCount);
 
 			virtual void DerivePKeyG(Point::Native&, const Hash::Value&) override;
 			virtual void DerivePKeyJ(Point::Native&, const Hash::Value&) override;
+			virtual void DerivePKeyGBatch(Point::Native*, const Hash::Value*, uint32_t nCount) override;
+			virtual void DerivePKeyJBatch(Point::Native*, const Hash::Value*, uint32_t nCount) override;
 
 			virtual uint32_t ExportS(void*) const { return 0; } // returns the size, ptr is optional
 		};
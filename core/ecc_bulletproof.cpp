@@ -233,7 +233,10 @@ namespace ECC {
 
 		static const uint32_t s_iCycle0 = 2; // condense source generators into points (after 3 iterations, 8 points)
 
-		Point::Native m_pGen[2][nDim >> (1 + s_iCycle0)];
+		static const uint32_t s_nGen = nDim >> (1 + s_iCycle0);
+
+		// condensed generators (both sides in one array), used in all the remaining cycles. Their odd multiples are calculated once, with the common denominator
+		MultiMac::Casual m_pGen[2 * s_nGen];
 
 		const Modifier& m_Mod;
 
@@ -265,24 +268,24 @@ namespace ECC {
 			return;
 		}
 
+		Point::Native g0;
+
 		for (int j = 0; j < 2; j++)
 			for (uint32_t i = 0; i < m_n; i++)
 			{
 				m_Mm.Reset();
 
-				Point::Native& g0 = m_pGen[j][i];
-
 				Aggregator aggr(m_Mm, &m_Cs.m_pX[0], &m_Cs.m_pX[1], m_Mod, j, nCycles - m_iCycle - 1);
 
-				if (m_iCycle > s_iCycle0)
-					aggr.m_pCalc = this;
-
 				aggr.Proceed(i, m_GenOrder, 1U);
 
 				m_Mm.Calculate(g0);
+				m_pGen[j * s_nGen + i].Init(g0);
 			}
 
 		m_GenOrder = nCycles - m_iCycle - 1;
+
+		MultiMac::Casual::GenerateBatch(m_pGen, _countof(m_pGen));
 	}
 
 	void InnerProduct::Calculator::ExtractLR(int j)
@@ -313,7 +316,10 @@ namespace ECC {
 				Aggregator aggr(m_Mm, &m_Cs.m_pX[0], &m_Cs.m_pX[1], m_Mod, jSrc, nCycles - m_iCycle);
 
 				if (m_iCycle > s_iCycle0)
+				{
 					aggr.m_pCalc = this;
+					m_Mm.m_ReuseFlag = MultiMac::Reuse::UseGenerated;
+				}
 
 				aggr.Proceed(i + off1, m_GenOrder, v);
 			}
@@ -347,9 +353,9 @@ namespace ECC {
 		{
 			if (m_pCalc)
 			{
-				assert(iPos < _countof(m_pCalc->m_pGen[m_j]));
+				assert(iPos < s_nGen);
 				m_Mm.m_pKCasual[m_Mm.m_Casual] = k;
-				m_Mm.m_pCasual[m_Mm.m_Casual++].Init(m_pCalc->m_pGen[m_j][iPos]);
+				m_Mm.m_pCasual[m_Mm.m_Casual++] = m_pCalc->m_pGen[m_j * s_nGen + iPos];
 			}
 			else
 			{
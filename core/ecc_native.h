@@ -15,6 +15,8 @@
 #pragma once
 #include "ecc.h"
 #include <assert.h>
+#include <mutex>
+#include <atomic>
 
 #define USE_BASIC_CONFIG
 
@@ -183,6 +185,12 @@ namespace ECC
 		bool Import(const Storage&, bool bVerify);
 		void Export(Storage&) const;
 
+		// Bulk import/export. Imported points are already affine, hence converted directly (no normalization needed later).
+		// Export normalizes all the points with a single inversion, the source points are spoiled.
+		static void ImportBatch(secp256k1_ge*, const Storage*, uint32_t nCount); // no verification
+		static void ExportBatch(Point*, Native*, uint32_t nCount);
+		static void ExportBatch(Storage*, Native*, uint32_t nCount);
+
 		struct BatchNormalizer
 		{
 			struct Element
@@ -354,6 +362,10 @@ namespace ECC
 			} U;
 
 			void Init(const Point::Native&);
+
+			// In fast mode: calculates all the odd multiples of all the elements, brought to the same denominator.
+			// Then any subset of them can be used (in any order) with Reuse::UseGenerated
+			static void GenerateBatch(Casual*, uint32_t nCount);
 		};
 
 		struct Prepared
@@ -454,6 +466,30 @@ namespace ECC
 		std::vector<Prepared::Fast::Wnaf> m_vWnafPrepared;
 
 		void Prepare(uint32_t nMaxCasual, uint32_t nMaxPrepared);
+
+		// In fast mode large number of casual points is evaluated by MultiMac_Pippenger (the points are spoiled after this)
+		void Calculate(Point::Native&);
+
+	private:
+		struct Normalizer;
+	};
+
+	struct MultiMac_Pippenger
+	{
+		// Bucket method for very large multi-exponentiations of casual (affine) points.
+		// Implementation is *NOT* secure (var-time). Should be used for verification only.
+		// The work can be split by windows between several workers, the results should be summed.
+
+		const secp256k1_ge* m_pPts;
+		const Scalar::Native* m_pK;
+		uint32_t m_Count;
+
+		static const uint32_t s_Threshold = 256; // below it the MultiMac is faster
+		static const uint32_t s_MaxWndBits = 16;
+
+		static uint32_t get_WndBits(uint32_t nCount);
+
+		void Calculate(Point::Native&, uint32_t iWorker = 0, uint32_t nWorkers = 1) const;
 	};
 
 	struct ScalarGenerator
@@ -482,6 +518,29 @@ namespace ECC
 		static const uint32_t nBitsPerLevel = 4;
 		static const uint32_t nPointsPerLevel = 1 << nBitsPerLevel; // 16
 
+		class Fast
+		{
+			// Bigger table for the fast (var-time) mode: 8-bit levels instead of 4, i.e. half the additions, no obscuring.
+			// ~0.5MB for 256-bit generator. Built on-demand, on the 1st use.
+			std::vector<Point::Compact> m_vPts;
+			std::once_flag m_Once;
+			Point::Compact m_Base;
+			uint32_t m_nLevels = 0;
+
+			void Build();
+
+		public:
+			static const uint32_t nBitsPerLevel = 8;
+			static const uint32_t nPointsPerLevel = (1 << nBitsPerLevel) - 1; // zero is omitted
+
+			static std::atomic<bool> s_Enabled; // can be turned-off to save memory. Read by the worker threads
+
+			void Init(const Point::Native&, uint32_t nBits_);
+			void SetMul(Point::Native& res, bool bSet, const Scalar::Native::uint* p, int nWords);
+
+			static bool ShouldUse(const Fast*); // only in fast mode
+		};
+
 		template <uint32_t nBits_>
 		class Base
 		{
@@ -490,6 +549,9 @@ namespace ECC
 			static_assert(nLevels * nBitsPerLevel == nBits_, "");
 
 			Point::Compact m_pPts[nLevels * nPointsPerLevel];
+
+		public:
+			Fast* m_pFast = nullptr; // optional
 		};
 
 		void GeneratePts(const Point::Native&, Oracle&, Point::Compact* pPts, uint32_t nLevels, Point::Compact::Converter&);
@@ -523,7 +585,10 @@ namespace ECC
 					for (int i = nWordsSrc; i < nWords; i++)
 						p[i] = 0;
 
-					Generator::SetMul(res, bSet, me.m_pPts, p, nWords);
+					if (Fast::ShouldUse(me.m_pFast))
+						me.m_pFast->SetMul(res, bSet, p, nWords);
+					else
+						Generator::SetMul(res, bSet, me.m_pPts, p, nWords);
 
 					SecureErase(p, sizeof(Scalar::Native::uint) * nWordsSrc);
 				}
@@ -696,6 +761,7 @@ namespace ECC
 			// according to rfc5869
 			NoLeak<uintBig> m_Secret;
 			void Generate(Scalar::Native&, const Hash::Value&) const;
+			void GenerateBatch(Scalar::Native*, const Hash::Value*, uint32_t nCount) const; // the HMAC setup is shared
 
 		} m_Generator;
 
@@ -705,9 +771,11 @@ namespace ECC
 		virtual ~HKdf();
 		// IPKdf
 		virtual void DerivePKey(Scalar::Native&, const Hash::Value&) override;
+		virtual void DerivePKeyBatch(Scalar::Native*, const Hash::Value*, uint32_t nCount) override;
 		virtual uint32_t ExportP(void*) const override;
 		// IKdf
 		virtual void DeriveKey(Scalar::Native&, const Hash::Value&) override;
+		virtual void DeriveKeyBatch(Scalar::Native*, const Hash::Value*, uint32_t nCount) override;
 		virtual uint32_t ExportS(void*) const override;
 
 #pragma pack (push, 1)
@@ -740,6 +808,8 @@ namespace ECC
 		Point::Native m_PkG;
 		Point::Native m_PkJ;
 
+		void MulBatch(Point::Native*, const Point::Native& pk, const Hash::Value*, uint32_t nCount);
+
 	public:
 		HKdfPub();
 		virtual ~HKdfPub();
@@ -748,6 +818,9 @@ namespace ECC
 		virtual void DerivePKey(Scalar::Native&, const Hash::Value&) override;
 		virtual void DerivePKeyG(Point::Native&, const Hash::Value&) override;
 		virtual void DerivePKeyJ(Point::Native&, const Hash::Value&) override;
+		virtual void DerivePKeyBatch(Scalar::Native*, const Hash::Value*, uint32_t nCount) override;
+		virtual void DerivePKeyGBatch(Point::Native*, const Hash::Value*, uint32_t nCount) override;
+		virtual void DerivePKeyJBatch(Point::Native*, const Hash::Value*, uint32_t nCount) override;
 		virtual uint32_t ExportP(void*) const override;
 
 #pragma pack (push, 1)
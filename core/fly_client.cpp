@@ -730,6 +730,80 @@ void FlyClient::NetworkStd::Connection::OnRequestData(RequestAsset& req)
             ThrowUnexpected();
 }
 
+bool FlyClient::NetworkStd::Connection::IsSupported(RequestUtxoMulti& req)
+{
+    return (LoginFlags::Extension::get(m_LoginFlags) >= 10) && IsAtTip();
+}
+
+void FlyClient::NetworkStd::Connection::OnRequestData(RequestUtxoMulti& req)
+{
+    if (req.m_Res.m_Proofs.size() > req.m_Msg.m_Utxos.size())
+        ThrowUnexpected();
+
+    Input::Proof proof;
+    for (size_t i = 0; i < req.m_Res.m_Proofs.size(); i++)
+    {
+        for (size_t j = 0; j < req.m_Res.m_Proofs[i].size(); j++)
+        {
+            const Input::Proof& src = req.m_Res.m_Proofs[i][j];
+            proof.m_State = src.m_State;
+            proof.m_Proof = src.m_Proof;
+            proof.m_Proof.insert(proof.m_Proof.end(), req.m_Res.m_Tail.begin(), req.m_Res.m_Tail.end());
+
+            if (!m_Tip.IsValidProofUtxo(req.m_Msg.m_Utxos[i], proof))
+                ThrowUnexpected();
+        }
+    }
+}
+
+bool FlyClient::NetworkStd::Connection::IsSupported(RequestKernelMulti& req)
+{
+    return (Flags::Node & m_Flags) && (LoginFlags::Extension::get(m_LoginFlags) >= 10) && IsAtTip();
+}
+
+void FlyClient::NetworkStd::Connection::OnRequestData(RequestKernelMulti& req)
+{
+    const std::vector<Merkle::Hash>& vIDs = req.m_Msg.m_IDs;
+    const std::vector<Height>& vHeights = req.m_Res.m_Heights;
+    if (vHeights.empty())
+        return; // not supported by the node at this moment
+
+    if (vHeights.size() != vIDs.size())
+        ThrowUnexpected();
+
+    // Blocks are in ascending order, each one lists the requested kernels at its height in the request order.
+    // Verify those for which we have the header
+    std::vector<Merkle::Hash> vKrns;
+    size_t nTotal = 0;
+
+    for (size_t iBlock = 0; iBlock < req.m_Res.m_Blocks.size(); iBlock++)
+    {
+        const proto::KernelsProof& kp = req.m_Res.m_Blocks[iBlock];
+        if (iBlock && (kp.m_Height <= req.m_Res.m_Blocks[iBlock - 1].m_Height))
+            ThrowUnexpected();
+
+        vKrns.clear();
+        for (size_t i = 0; i < vIDs.size(); i++)
+            if (vHeights[i] == kp.m_Height)
+                vKrns.push_back(vIDs[i]);
+
+        if (vKrns.empty() || (vKrns.size() != kp.m_vIdx.size()))
+            ThrowUnexpected();
+        nTotal += vKrns.size();
+
+        Block::SystemState::Full s;
+        if (m_This.m_Client.get_History().get_At(s, kp.m_Height) && !kp.IsValid(s, &vKrns.front()))
+            ThrowUnexpected();
+    }
+
+    for (size_t i = 0; i < vHeights.size(); i++)
+        if (!vHeights[i])
+            nTotal++;
+
+    if (nTotal != vIDs.size())
+        ThrowUnexpected();
+}
+
 bool FlyClient::NetworkStd::Connection::IsSupported(RequestAsset& req)
 {
     return (Flags::Node & m_Flags) && IsAtTip();
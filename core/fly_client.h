@@ -40,6 +40,8 @@ namespace proto {
 		macro(Utxo,              GetProofUtxo,         ProofUtxo) \
 		macro(Kernel,            GetProofKernel,       ProofKernel) \
 		macro(Kernel2,           GetProofKernel2,      ProofKernel2) \
+		macro(UtxoMulti,         GetProofUtxoMulti,    ProofUtxoMulti) \
+		macro(KernelMulti,       GetProofKernelMulti,  ProofKernelMulti) \
 		macro(Events,            GetEvents,            Events) \
 		macro(Transaction,       NewTransaction,       Status) \
 		macro(ShieldedList,      GetShieldedList,      ShieldedList) \
@@ -117,10 +117,38 @@ void CmList::Import(MultiMac& mm, uint32_t iPos, uint32_t nCount)
 	}
 }
 
+uint32_t CmList::Import(secp256k1_ge* pPts, uint32_t iPos, uint32_t nCount)
+{
+	std::vector<Point::Storage> vStorage(nCount);
+
+	uint32_t i = 0;
+	for (; i < nCount; i++)
+		if (!get_At(vStorage[i], iPos + i))
+			break;
+
+	Point::Native::ImportBatch(pPts, vStorage.data(), i);
+	return i;
+}
+
 void CmList::Calculate(Point::Native& res, uint32_t iPos, uint32_t nCount, const Scalar::Native* pKs)
 {
 	Mode::Scope scope(Mode::Fast);
 
+	if (nCount >= MultiMac_Pippenger::s_Threshold)
+	{
+		std::vector<secp256k1_ge> vPts(nCount);
+
+		MultiMac_Pippenger mmp;
+		mmp.m_pPts = &vPts.front();
+		mmp.m_pK = pKs + iPos;
+		mmp.m_Count = Import(&vPts.front(), iPos, nCount);
+
+		Point::Native comm;
+		mmp.Calculate(comm);
+		res += comm;
+		return;
+	}
+
 	const uint32_t nSizeNaggle = 128;
 	MultiMac_WithBufs<nSizeNaggle, 1> mm;
 
@@ -673,10 +701,11 @@ void Prover::ExtractG(const Point::Native& ptBias)
 	mm.m_Casual = 1;
 	mm.m_ReuseFlag = MultiMac::Reuse::Generate;
 
-	ECC::Point::Native comm;
+	std::vector<Point::Native> vG(m_Cfg.M);
 	for (uint32_t k = 0; k < m_Cfg.M; k++)
 	{
 		GB& gb = t.m_vGB[k];
+		Point::Native& comm = vG[k];
 
 		mm.m_pKPrep = m_Tau + k;
 		mm.m_pKCasual = &gb.m_kBias;
@@ -692,9 +721,9 @@ void Prover::ExtractG(const Point::Native& ptBias)
 			mm.m_ReuseFlag = MultiMac::Reuse::UseGenerated;
 			mm.m_Prepared = 1;
 		}
-
-		m_Proof.m_Part1.m_vG[k] = comm;
 	}
+
+	Point::Native::ExportBatch(&m_Proof.m_Part1.m_vG.front(), &vG.front(), m_Cfg.M);
 }
 
 void Prover::ExtractBlinded(Scalar& out, const Scalar::Native& sk, const Scalar::Native& challenge, const Scalar::Native& nonce)
@@ -23,6 +23,7 @@ namespace Sigma {
 		virtual bool get_At(ECC::Point::Storage&, uint32_t iIdx) = 0;
 
 		void Import(ECC::MultiMac&, uint32_t iPos, uint32_t nCount);
+		virtual uint32_t Import(secp256k1_ge*, uint32_t iPos, uint32_t nCount); // returns the number of imported points
 		void Calculate(ECC::Point::Native&, uint32_t iPos, uint32_t nCount, const ECC::Scalar::Native* pKs);
 	};
 
@@ -38,6 +39,18 @@ namespace Sigma {
 			res = m_vec[iIdx];
 			return true;
 		}
+
+		using CmList::Import;
+
+		virtual uint32_t Import(secp256k1_ge* pPts, uint32_t iPos, uint32_t nCount) override
+		{
+			if (iPos >= m_vec.size())
+				return 0;
+
+			std::setmin(nCount, static_cast<uint32_t>(m_vec.size()) - iPos);
+			ECC::Point::Native::ImportBatch(pPts, &m_vec.front() + iPos, nCount);
+			return nCount;
+		}
 	};
 
 	struct Cfg
@@ -375,7 +375,6 @@ bool MultiTx::BuildTxPart(Transaction& tx, bool bIsSender, ECC::Scalar::Native&
 		return false;
 
 	offs = -offs; // initially contains kernel offset
-	ECC::Scalar::Native sk;
 
 	// inputs
 	std::vector<CoinID> vec;
@@ -402,14 +401,18 @@ bool MultiTx::BuildTxPart(Transaction& tx, bool bIsSender, ECC::Scalar::Native&
 
 	// outputs
 	offs = -offs;
-	if (Get(vec, Codes::OutpCids))
+	if (Get(vec, Codes::OutpCids) && !vec.empty())
 	{
+		size_t iOut0 = tx.m_vOutputs.size();
 		for (size_t i = 0; i < vec.size(); i++)
-		{
 			tx.m_vOutputs.emplace_back(new Output);
-			tx.m_vOutputs.back()->Create(hScheme, sk, *m_pKdf, vec[i], *m_pKdf);
-			offs += sk;
-		}
+
+		std::vector<ECC::Scalar::Native> vSk(vec.size());
+		Output::CreateBatch(hScheme, &tx.m_vOutputs[iOut0], &vSk.front(), *m_pKdf, &vec.front(), static_cast<uint32_t>(vec.size()), *m_pKdf);
+
+		for (size_t i = 0; i < vSk.size(); i++)
+			offs += vSk[i];
+
 		vec.clear();
 	}
 
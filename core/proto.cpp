@@ -76,18 +76,30 @@ void ProtocolPlus::get_HMac(ECC::Hash::Mac& hm, MacValue& res)
 
 void ProtocolPlus::Encrypt(SerializedMsg& sm, MsgSerializer& ser)
 {
-    MacValue hmac;
-
-    if (Mode::Plaintext != m_Mode)
+    if (Mode::Plaintext == m_Mode)
+        ser.finalize(sm);
+    else
     {
-        // 1. append dummy of the needed size
-        hmac = Zero;
-        ser & hmac;
+        FinalizeWithMac(sm, ser);
+        Seal(sm);
     }
+}
+
+void ProtocolPlus::FinalizeWithMac(SerializedMsg& sm, MsgSerializer& ser)
+{
+    // 1. append dummy of the needed size
+    MacValue hmac = Zero;
+    ser & hmac;
 
     ser.finalize(sm);
+}
+
+void ProtocolPlus::Seal(SerializedMsg& sm)
+{
+    assert(Mode::Plaintext != m_Mode);
+
+    MacValue hmac;
 
-    if (Mode::Plaintext != m_Mode)
     {
         // 2. get size
         size_t n = 0;
@@ -272,6 +284,72 @@ bool Bbs::IsHashValid(const ECC::Hash::Value& hv)
 	return nHigh < (1 << 10); // upper 22 bits should be zero, probability ~ 1 / 4mln
 }
 
+void BodyBuffers::get_Checksum(ECC::Hash::Value& hv) const
+{
+	ECC::Hash::Processor()
+		<< "body.cs"
+		<< m_Perishable.size()
+		<< Blob(m_Perishable)
+		<< m_Eternal.size()
+		<< Blob(m_Eternal)
+		>> hv;
+}
+
+bool KernelsProof::IsValid(const Block::SystemState::Full& s, const Merkle::Hash* pIDs) const
+{
+	if ((s.m_Height != m_Height) || m_vIdx.empty())
+		return false;
+
+	// the proof is built for sorted positions
+	typedef std::pair<uint64_t, const Merkle::Hash*> Entry;
+	std::vector<Entry> v;
+	v.reserve(m_vIdx.size());
+
+	for (size_t i = 0; i < m_vIdx.size(); i++)
+		v.emplace_back(m_vIdx[i], pIDs + i);
+
+	std::sort(v.begin(), v.end(), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+
+	struct MyVerifier
+		:public Merkle::MultiProof::Verifier
+	{
+		const KernelsProof& m_This;
+		const Block::SystemState::Full& m_State;
+
+		MyVerifier(const KernelsProof& x, const Block::SystemState::Full& s)
+			:Verifier(x.m_Proof, x.m_Count)
+			,m_This(x)
+			,m_State(s)
+		{
+		}
+
+		virtual bool IsRootValid(const Merkle::Hash& hv) override
+		{
+			return m_State.IsValidProofKernel(hv, m_This.m_Tail);
+		}
+	};
+
+	MyVerifier ver(*this, s);
+
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		if (i && (v[i].first == v[i - 1].first))
+		{
+			if (*v[i].second != *v[i - 1].second)
+				return false; // different kernels at the same position
+			continue;
+		}
+
+		ver.m_hvPos = *v[i].second;
+		ver.Process(v[i].first);
+
+		if (!ver.m_bVerify)
+			return false;
+	}
+
+	return (ver.get_Pos() == m_Proof.m_vData.end()); // all the proof must be consumed
+}
+
 union HighestMsgCode
 {
 #define THE_MACRO(code, msg) uint8_t m_pBuf_##msg[code + 1];
@@ -294,10 +372,13 @@ bool NotCalled_VerifyNoDuplicatedIDs(uint32_t id)
 
 /////////////////////////
 // NodeConnection
+const uint8_t s_pProtoVer[] = { 'B', 'm', 10 };
+
 NodeConnection::NodeConnection()
-    :m_Protocol('B', 'm', 10, sizeof(HighestMsgCode), *this, 20000)
+    :m_Protocol(s_pProtoVer[0], s_pProtoVer[1], s_pProtoVer[2], sizeof(HighestMsgCode), *this, 20000)
     ,m_ConnectPending(false)
 	,m_RulesCfgSent(false)
+	,m_ReadPaused(false)
 {
 #define THE_MACRO(code, msg) \
     m_Protocol.add_message_handler<NodeConnection, msg##_NoInit, &NodeConnection::OnMsgInternal>(uint8_t(code), this, 0, 1024*1024*10);
@@ -320,8 +401,16 @@ void NodeConnection::Reset()
     }
 
 	m_RulesCfgSent = false;
+	m_ReadPaused = false;
     m_Connection = NULL;
+
+    if (m_pRelay)
+    {
+        m_pRelay->Close();
+        m_pRelay.reset();
+    }
     m_pAsyncFail = NULL;
+    m_pAsyncResume = NULL;
 
     m_Protocol.ResetVars();
 }
@@ -347,7 +436,7 @@ void NodeConnection::TestIoResultAsync(const io::Result& res)
 
 void NodeConnection::TestNotDrown()
 {
-	if (!m_pAsyncFail && m_UnsentHiMark && (get_Unsent() > m_UnsentHiMark))
+	if (!m_pAsyncFail && m_UnsentHiMark && !m_UnsentDrop && (get_Unsent() > m_UnsentHiMark))
 	{
 		io::AsyncEvent::Callback cb = [this]()
 		{
@@ -361,6 +450,38 @@ void NodeConnection::TestNotDrown()
 	}
 }
 
+void NodeConnection::TestReadPause()
+{
+	if (m_ReadPaused || !m_UnsentPauseMark || !m_Connection || !IsLive() || (get_Unsent() <= m_UnsentPauseMark))
+		return; // in relay mode the transport controls the reading
+
+	m_ReadPaused = true;
+	m_Connection->pause_read(true);
+	m_Connection->notify_drained(m_UnsentResumeMark, [this]() { OnDrained(); });
+
+	OnReadPaused(true);
+}
+
+void NodeConnection::OnDrained()
+{
+	// invoked from within the write completion, resume asynchronously
+	io::AsyncEvent::Callback cb = [this]() { ResumeRead(); };
+
+	m_pAsyncResume = io::AsyncEvent::create(io::Reactor::get_Current(), std::move(cb));
+	m_pAsyncResume->get_trigger()();
+}
+
+void NodeConnection::ResumeRead()
+{
+	if (!m_ReadPaused || !m_Connection || !IsLive())
+		return;
+
+	m_ReadPaused = false;
+	OnReadPaused(false);
+
+	m_Connection->pause_read(false); // process the retained data. At this moment the *this* may be deleted
+}
+
 void NodeConnection::OnConnectInternal(uint64_t tag, io::TcpStream::Ptr&& newStream, io::ErrorCode status)
 {
     NodeConnection* pThis = (NodeConnection*)tag;
@@ -419,7 +540,10 @@ void NodeConnection::OnIoErr(io::ErrorCode err)
 
 size_t NodeConnection::get_Unsent() const
 {
-	return m_Connection ? m_Connection->get_Unsent() : 0;
+	if (m_Connection)
+		return m_Connection->get_Unsent();
+
+	return m_pRelay ? m_pRelay->get_Unsent() : 0;
 }
 
 void NodeConnection::on_protocol_error(uint64_t, ProtocolError error)
@@ -513,27 +637,155 @@ void NodeConnection::Accept(io::TcpStream::Ptr&& newStream)
         );
 }
 
+void NodeConnection::Accept(IRelay::Ptr&& pRelay)
+{
+    assert(!m_Connection && !m_ConnectPending && !m_pRelay);
+    m_pRelay = std::move(pRelay);
+}
+
+void NodeConnection::SetSecureRelayed(const ECC::Scalar::Native& myNonce, const PeerID& remoteNonce)
+{
+    assert(m_pRelay);
+
+    // the cipher is not initialized, it's used by the transport. The nonces are needed to prove/verify IDs
+    m_Protocol.m_MyNonce = myNonce;
+    m_Protocol.m_RemoteNonce = remoteNonce;
+    m_Protocol.m_Mode = ProtocolPlus::Mode::Duplex;
+}
+
+void NodeConnection::get_SChannelNonces(ECC::Scalar::Native& myNonce, PeerID& remoteNonce) const
+{
+    myNonce = m_Protocol.m_MyNonce;
+    remoteNonce = m_Protocol.m_RemoteNonce;
+}
+
+void NodeConnection::WriteFinalized(SerializedMsg& sm)
+{
+    if (!m_Connection || !IsLive())
+        return;
+
+    m_Protocol.Seal(sm);
+    io::Result res = m_Connection->write_msg(sm);
+
+    TestIoResultAsync(res);
+    TestNotDrown();
+    TestReadPause();
+}
+
 bool NodeConnection::IsLive() const
 {
-    return m_Connection && !m_pAsyncFail;
+    return (m_Connection || m_pRelay) && !m_pAsyncFail;
+}
+
+bool NodeConnection::ShouldSend()
+{
+    if (!IsLive())
+        return false;
+
+    if (m_UnsentDrop && m_UnsentHiMark && (get_Unsent() > m_UnsentHiMark))
+    {
+        m_UnsentDropped++;
+        return false;
+    }
+
+    if (m_pRelay && !IsSecureOut())
+        return false; // the secure channel is established by the transport, nothing should be sent before
+
+    return true;
+}
+
+void NodeConnection::OnSent(const io::Result& res)
+{
+    TestIoResultAsync(res);
+    TestNotDrown();
+    TestReadPause();
+}
+
+MsgSerializer& NodeConnection::SharedMsg::Begin(uint8_t nCode)
+{
+    static thread_local MsgSerializer s_Ser(20000, MsgHeader(s_pProtoVer[0], s_pProtoVer[1], s_pProtoVer[2]));
+    s_Ser.new_message(nCode);
+    return s_Ser;
+}
+
+void NodeConnection::SharedMsg::End(MsgSerializer& ser)
+{
+    SerializedMsg sm;
+    ProtocolPlus::FinalizeWithMac(sm, ser);
+    m_Buf = io::normalize(sm, false);
+}
+
+void NodeConnection::SendShared(const SharedMsg& msg)
+{
+    if (!ShouldSend())
+        return;
+
+    const io::SharedBuffer& buf = msg.m_Buf;
+    assert(buf.size >= MsgHeader::SIZE + ProtocolPlus::MacValue::nBytes);
+
+    m_SerializeCache.clear();
+
+    bool bPlaintext = !m_pRelay && (ProtocolPlus::Mode::Plaintext == m_Protocol.m_Mode);
+    if (bPlaintext)
+    {
+        // no mac. Send the patched header, and the shared body without the mac placeholder
+        MsgHeader hdr(buf.data);
+        hdr.size -= ProtocolPlus::MacValue::nBytes;
+
+        uint8_t pHdr[MsgHeader::SIZE];
+        hdr.write(pHdr);
+
+        m_SerializeCache.emplace_back(pHdr, sizeof(pHdr));
+        m_SerializeCache.emplace_back(buf.data + MsgHeader::SIZE, buf.size - MsgHeader::SIZE - ProtocolPlus::MacValue::nBytes, buf.guard);
+    }
+    else
+        m_SerializeCache.emplace_back(buf.data, buf.size); // private copy, to be sealed in-place
+
+    if (m_pRelay)
+    {
+        m_pRelay->Write(std::move(m_SerializeCache));
+        m_SerializeCache.clear();
+        TestNotDrown();
+        return;
+    }
+
+    if (!bPlaintext)
+        m_Protocol.Seal(m_SerializeCache);
+
+    io::Result res = m_Connection->write_msg(m_SerializeCache);
+    m_SerializeCache.clear();
+
+    OnSent(res);
 }
 
 #define THE_MACRO(code, msg) \
 void NodeConnection::Send(const msg& v) \
 { \
-    if (!IsLive()) \
+    if (!ShouldSend()) \
         return; \
     m_SerializeCache.clear(); \
     MsgSerializer& ser = m_Protocol.serializeNoFinalize(m_SerializeCache, uint8_t(code), v); \
+    if (m_pRelay) \
+    { \
+        ProtocolPlus::FinalizeWithMac(m_SerializeCache, ser); \
+        m_pRelay->Write(std::move(m_SerializeCache)); \
+        m_SerializeCache.clear(); \
+        TestNotDrown(); \
+        return; \
+    } \
     m_Protocol.Encrypt(m_SerializeCache, ser); \
     io::Result res = m_Connection->write_msg(m_SerializeCache); \
     m_SerializeCache.clear(); \
 \
-    TestIoResultAsync(res); \
-    TestNotDrown(); \
+    OnSent(res); \
 } \
 \
 bool NodeConnection::OnMsgInternal(uint64_t, msg##_NoInit&& v) \
+{ \
+    return OnMsgSafe(std::move(v)); \
+} \
+\
+bool NodeConnection::OnMsgSafe(msg&& v) \
 { \
     try { \
         /* checkpoint */ \
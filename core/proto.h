@@ -71,6 +71,23 @@ namespace proto {
 #define BeamNodeMsg_BodyPack(macro) \
     macro(std::vector<BodyBuffers>, Bodies)
 
+#define BeamNodeMsg_GetBodyCompact(macro) \
+    macro(Block::SystemState::ID, ID)
+
+#define BeamNodeMsg_BodyCompact(macro) \
+    macro(std::vector<ECC::Hash::Value>, Outputs) /* keys of all the outputs, see TxPool::Fluff::get_OutputKey() */ \
+    macro(std::vector<Merkle::Hash>, Kernels) /* IDs of all the kernels */ \
+    macro(Transaction::Ptr, Included) /* offset, all the inputs, and the outputs/kernels the peer is unlikely to have */ \
+    macro(ECC::Hash::Value, Checksum) /* of the full body, see BodyBuffers::get_Checksum() */
+
+#define BeamNodeMsg_GetBodyParts(macro) \
+    macro(Block::SystemState::ID, ID) \
+    macro(std::vector<uint32_t>, Outputs) /* indices */ \
+    macro(std::vector<uint32_t>, Kernels)
+
+#define BeamNodeMsg_BodyParts(macro) \
+    macro(Transaction::Ptr, Value)
+
 #define BeamNodeMsg_GetProofState(macro) \
     macro(Height, Height)
 
@@ -88,6 +105,12 @@ namespace proto {
     macro(ECC::Point, Utxo) \
     macro(Height, MaturityMin) /* set to non-zero in case the result is too big, and should be retrieved within multiple queries */
 
+#define BeamNodeMsg_GetProofUtxoMulti(macro) \
+    macro(std::vector<ECC::Point>, Utxos) /* up to g_ProofMultiMax */
+
+#define BeamNodeMsg_GetProofKernelMulti(macro) \
+    macro(std::vector<Merkle::Hash>, IDs) /* up to g_ProofMultiMax */
+
 #define BeamNodeMsg_GetProofShieldedOutp(macro) \
     macro(ECC::Point, SerialPub)
 
@@ -116,6 +139,14 @@ namespace proto {
 #define BeamNodeMsg_ProofUtxo(macro) \
     macro(std::vector<Input::Proof>, Proofs)
 
+#define BeamNodeMsg_ProofUtxoMulti(macro) \
+    macro(std::vector<std::vector<Input::Proof> >, Proofs) /* for each requested UTXO, paths within the UTXO tree only */ \
+    macro(Merkle::Proof, Tail) /* common for all, from the UTXO tree root to the system state */
+
+#define BeamNodeMsg_ProofKernelMulti(macro) \
+    macro(std::vector<Height>, Heights) /* for each requested kernel, 0 if not found */ \
+    macro(std::vector<KernelsProof>, Blocks) /* one per distinct height, ascending */
+
 #define BeamNodeMsg_ProofShieldedOutp(macro) \
     macro(ECC::Point, Commitment) \
     macro(TxoID, ID) \
@@ -354,7 +385,17 @@ namespace proto {
     macro(0x45, GetStateSummary) \
     macro(0x46, StateSummary) \
     macro(0x47, GetShieldedOutputsAt) \
-    macro(0x48, ShieldedOutputsAt)
+    macro(0x48, ShieldedOutputsAt) \
+    /* compact block relay */ \
+    macro(0x49, GetBodyCompact) \
+    macro(0x4a, BodyCompact) \
+    macro(0x4b, GetBodyParts) \
+    macro(0x4c, BodyParts) \
+    /* batched proofs */ \
+    macro(0x4d, GetProofUtxoMulti) \
+    macro(0x4e, ProofUtxoMulti) \
+    macro(0x4f, GetProofKernelMulti) \
+    macro(0x50, ProofKernelMulti)
 
 
     struct LoginFlags {
@@ -379,9 +420,11 @@ namespace proto {
             // 6 - Newer Event::AssetCtl, newer Utxo events
             // 7 - GetShieldedOutputsAt
             // 8 - Contract vars and logs, flexible hdr request, newer ShieldedList, Status
+            // 9 - Compact block bodies (GetBodyCompact, GetBodyParts)
+            // 10 - Batched proofs (GetProofUtxoMulti, GetProofKernelMulti)
 
             static const uint32_t Minimum = 8;
-            static const uint32_t Maximum = 8;
+            static const uint32_t Maximum = 10;
 
             static void set(uint32_t& nFlags, uint32_t nExt);
             static uint32_t get(uint32_t nFlags);
@@ -396,6 +439,7 @@ namespace proto {
     };
 
 	static const uint32_t g_HdrPackMaxSize = 2048; // about 400K
+	static const uint32_t g_ProofMultiMax = 256; // max elements in a batched proof request
 
     struct Event
     {
@@ -517,6 +561,31 @@ namespace proto {
 		static const uint8_t None = 1;
 		static const uint8_t Recovery1 = 2; // part suitable for recovery (version 1). Suitable for Outputs
 
+		void get_Checksum(ECC::Hash::Value&) const; // used to verify the bodies restored from the compact form
+	};
+
+	struct KernelsProof
+	{
+		// Proof for several kernels of the same block. Paths within the block kernels MMR are merged.
+		Height m_Height;
+		uint64_t m_Count; // total kernels in the block
+		std::vector<uint64_t> m_vIdx; // positions of the requested kernels in the block, in the order of the request
+		Merkle::MultiProof m_Proof; // built for the sorted (unique) positions
+		Merkle::Proof m_Tail; // from the block kernels root to the system state. Empty before Fork3
+
+	    template <typename Archive>
+	    void serialize(Archive& ar)
+	    {
+	        ar
+				& m_Height
+				& m_Count
+				& m_vIdx
+				& m_Proof
+				& m_Tail;
+	    }
+
+		// pIDs should correspond to m_vIdx
+		bool IsValid(const Block::SystemState::Full&, const Merkle::Hash* pIDs) const;
 	};
 
     enum Unused_ { Unused };
@@ -672,6 +741,10 @@ namespace proto {
         virtual bool VerifyMsg(const uint8_t*, uint32_t nSize) override;
 
         void Encrypt(SerializedMsg&, MsgSerializer&);
+
+        // Encrypt, split in 2 phases. Used when the cipher is handled by another thread
+        static void FinalizeWithMac(SerializedMsg&, MsgSerializer&); // append the mac placeholder, finalize
+        void Seal(SerializedMsg&); // calculate the mac, encrypt
     };
 
     struct INodeMsgHandler
@@ -713,16 +786,40 @@ namespace proto {
     class NodeConnection
         :public INodeMsgHandler
     {
+    public:
+
+        // Relay: the transport (secure channel, framing, cipher, deserialization) is handled elsewhere, typically on another thread.
+        // The messages to send are serialized and finalized with the mac placeholder, the transport seals them.
+        struct IRelay
+        {
+            typedef std::shared_ptr<IRelay> Ptr;
+            virtual ~IRelay() {}
+
+            virtual void Write(SerializedMsg&&) = 0;
+            virtual size_t get_Unsent() const = 0;
+            virtual void Close() = 0; // no more events should be delivered
+        };
+
+    private:
+
         ProtocolPlus m_Protocol;
         std::unique_ptr<Connection> m_Connection;
+        IRelay::Ptr m_pRelay;
         io::AsyncEvent::Ptr m_pAsyncFail;
+        io::AsyncEvent::Ptr m_pAsyncResume;
         bool m_ConnectPending;
 		bool m_RulesCfgSent;
+		bool m_ReadPaused;
 
         SerializedMsg m_SerializeCache;
 
         void TestIoResultAsync(const io::Result& res);
         void TestInputMsgContext(uint8_t);
+        bool ShouldSend();
+        void OnSent(const io::Result&);
+		void TestReadPause();
+		void OnDrained();
+		void ResumeRead();
 
         static void OnConnectInternal(uint64_t tag, io::TcpStream::Ptr&& newStream, io::ErrorCode);
         void OnConnectInternal2(io::TcpStream::Ptr&& newStream, io::ErrorCode);
@@ -749,6 +846,12 @@ namespace proto {
         void Connect(const io::Address& addr, const boost::optional<io::Address> proxyAddr = boost::none);
         void Accept(io::TcpStream::Ptr&& newStream);
 
+        // Relay-specific. The incoming messages are delivered via OnMsgSafe()
+        void Accept(IRelay::Ptr&&);
+        void SetSecureRelayed(const ECC::Scalar::Native& myNonce, const PeerID& remoteNonce); // the transport has established the secure channel
+        void get_SChannelNonces(ECC::Scalar::Native& myNonce, PeerID& remoteNonce) const; // on the transport side
+        void WriteFinalized(SerializedMsg&); // seal and send the message that was finalized by the relay
+
         // Secure-channel-specific
         void SecureConnect(); // must be connected already
 
@@ -826,17 +929,51 @@ namespace proto {
         virtual void OnDisconnect(const DisconnectReason&) {}
 
 		size_t get_Unsent() const;
-		size_t m_UnsentHiMark = 0;
+		size_t m_UnsentHiMark = 0; // hard limit
+		bool m_UnsentDrop = false; // drop messages above the hard limit, instead of disconnecting
+		uint64_t m_UnsentDropped = 0; // num of messages dropped
+
+		// Backpressure: stop reading (i.e. processing requests) from the peer while the unsent data is above the pause mark, until it drops to the resume mark
+		size_t m_UnsentPauseMark = 0;
+		size_t m_UnsentResumeMark = 0;
+		bool IsReadPaused() const { return m_ReadPaused; }
+		virtual void OnReadPaused(bool) {}
+
 		void TestNotDrown();
 
         void OnIoErr(io::ErrorCode);
         void OnExc(const std::exception&);
         void OnProcessingExc(const NodeProcessingException& exception);
 
-#define THE_MACRO(code, msg) void Send(const msg& v);
+#define THE_MACRO(code, msg) \
+        void Send(const msg& v); \
+        bool OnMsgSafe(msg&& v); /* handle the exceptions */
         BeamNodeMsgsAll(THE_MACRO)
 #undef THE_MACRO
 
+        // Message serialized once, to be sent to many peers (broadcast). The buffer is immutable, finalized with the mac placeholder.
+        // Each connection copies it only if it needs to seal (encrypt) it, plaintext connections send it as-is.
+        struct SharedMsg
+        {
+            io::SharedBuffer m_Buf;
+
+            template <typename TMsg>
+            void Set(const TMsg& v)
+            {
+                MsgSerializer& ser = Begin(TMsg::s_Code);
+                ser & v;
+                End(ser);
+            }
+
+            bool IsEmpty() const { return m_Buf.empty(); }
+
+        private:
+            static MsgSerializer& Begin(uint8_t nCode);
+            void End(MsgSerializer&);
+        };
+
+        void SendShared(const SharedMsg&);
+
         struct Server
         {
             io::TcpServer::Ptr m_pServer; // just delete it to stop listening
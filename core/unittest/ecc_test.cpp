@@ -570,6 +570,217 @@ void TestPoints()
 	p0 = -p0;
 	p0 += p1;
 	verify_test(p0 == Zero);
+
+	// Pippenger (large casual MultiMac)
+	{
+		Mode::Scope scope(Mode::Fast);
+
+		const uint32_t nCount = MultiMac_Pippenger::s_Threshold + 11;
+
+		MultiMac_Dyn mm;
+		mm.Prepare(nCount, 1);
+
+		std::vector<secp256k1_ge> vPts(nCount);
+		std::vector<Scalar::Native> vK(nCount);
+
+		p1 = Zero;
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			if (i == 5)
+				p0 = Zero; // zero point should be handled too
+			else
+			{
+				SetRandom(p0);
+				if (i & 1)
+					p0 = p0 * Two; // not normalized
+			}
+
+			SetRandom(vK[i]);
+			p1 += p0 * vK[i];
+
+			mm.m_pCasual[mm.m_Casual].Init(p0);
+			mm.m_pKCasual[mm.m_Casual++] = vK[i];
+
+			Point::Storage pt_s;
+			p0.Export(pt_s);
+			p0.Import(pt_s, false);
+			Point::Native::BatchNormalizer::get_As(vPts[i], p0);
+		}
+
+		Scalar::Native k;
+		SetRandom(k);
+		mm.m_ppPrepared[mm.m_Prepared] = &Context::get().m_Ipp.G_;
+		mm.m_pKPrep[mm.m_Prepared++] = k;
+
+		mm.Calculate(p0);
+		p0 -= Context::get().G * k;
+		verify_test(p0 == p1);
+
+		// split by windows between workers
+		MultiMac_Pippenger mmp;
+		mmp.m_pPts = &vPts.front();
+		mmp.m_pK = &vK.front();
+		mmp.m_Count = nCount;
+
+		for (uint32_t nWorkers = 1; nWorkers <= 4; nWorkers += 3)
+		{
+			p0 = Zero;
+			for (uint32_t iWorker = 0; iWorker < nWorkers; iWorker++)
+			{
+				Point::Native pt;
+				mmp.Calculate(pt, iWorker, nWorkers);
+				p0 += pt;
+			}
+
+			verify_test(p0 == p1);
+		}
+	}
+
+	// casual odd multiples generated at once, then used in different subsets and order
+	{
+		Mode::Scope scope(Mode::Fast);
+
+		const uint32_t nCount = 6;
+		MultiMac::Casual pCasual[nCount];
+		Point::Native pPt[nCount];
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			if (i == 2)
+				pPt[i] = Zero;
+			else
+			{
+				SetRandom(pPt[i]);
+				if (i & 1)
+					pPt[i] = pPt[i] * Two; // not normalized
+			}
+
+			pCasual[i].Init(pPt[i]);
+		}
+
+		MultiMac::Casual::GenerateBatch(pCasual, nCount);
+
+		for (uint32_t iStart = 0; iStart < nCount; iStart++)
+		{
+			MultiMac_WithBufs<nCount, 1> mm;
+			mm.m_ReuseFlag = MultiMac::Reuse::UseGenerated;
+
+			p1 = Zero;
+			for (uint32_t i = nCount; i-- > iStart; )
+			{
+				Scalar::Native& k = mm.m_pKCasual[mm.m_Casual];
+				SetRandom(k);
+				p1 += pPt[i] * k;
+
+				mm.m_pCasual[mm.m_Casual++] = pCasual[i];
+			}
+
+			mm.Calculate(p0);
+			verify_test(p0 == p1);
+		}
+	}
+
+	// bulk import/export
+	{
+		const uint32_t nCount = 20;
+		Point::Native pPts[nCount], pDup[nCount];
+		Point pPt[nCount];
+		Point::Storage pPtS[nCount];
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			if (i == 3)
+				pPts[i] = Zero;
+			else
+			{
+				SetRandom(pPts[i]);
+				pPts[i] = pPts[i] * Two; // not normalized
+			}
+		}
+
+		memcpy(reinterpret_cast<void*>(pDup), pPts, sizeof(pPts));
+		Point::Native::ExportBatch(pPt, pDup, nCount);
+		memcpy(reinterpret_cast<void*>(pDup), pPts, sizeof(pPts));
+		Point::Native::ExportBatch(pPtS, pDup, nCount);
+
+		secp256k1_ge pGe[nCount];
+		Point::Native::ImportBatch(pGe, pPtS, nCount);
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			verify_test(pPts[i] == pPt[i]);
+
+			Point::Storage pt_s;
+			pPts[i].Export(pt_s);
+			verify_test(!memcmp(&pt_s, pPtS + i, sizeof(pt_s)));
+
+			verify_test(!pGe[i].infinity == (pPts[i] != Zero));
+
+			if (pPts[i] != Zero)
+			{
+				p0 = -pPts[i];
+				secp256k1_gej_add_ge(&p0.get_Raw(), &p0.get_Raw(), pGe + i);
+				verify_test(p0 == Zero);
+			}
+		}
+
+		// generic list, the range is fetched via get_At
+		struct MyList
+			:public beam::Sigma::CmList
+		{
+			const Point::Storage* m_p;
+			uint32_t m_Count;
+
+			virtual bool get_At(Point::Storage& res, uint32_t iIdx) override
+			{
+				if (iIdx >= m_Count)
+					return false;
+
+				res = m_p[iIdx];
+				return true;
+			}
+
+		} lst;
+
+		lst.m_p = pPtS;
+		lst.m_Count = nCount;
+
+		secp256k1_ge pGe2[nCount];
+		verify_test(lst.Import(pGe2, 2, nCount) == nCount - 2);
+
+		for (uint32_t i = 2; i < nCount; i++)
+		{
+			const secp256k1_ge& ge = pGe2[i - 2];
+			verify_test(ge.infinity == pGe[i].infinity);
+
+			if (!ge.infinity)
+				verify_test(!memcmp(&ge.x, &pGe[i].x, sizeof(ge.x)) && !memcmp(&ge.y, &pGe[i].y, sizeof(ge.y)));
+		}
+	}
+
+	// fast-mode generator tables should give the same results
+	for (int i = 0; i < 5; i++)
+	{
+		Scalar::Native k;
+		SetRandom(k);
+		if (!i)
+			k = Zero;
+
+		Amount v;
+		GenRandom(&v, sizeof(v));
+
+		p0 = Context::get().G * k;
+		p0 += Context::get().H * v;
+		p0 += Context::get().J * k;
+
+		Mode::Scope scope(Mode::Fast);
+
+		p1 = Context::get().G * k;
+		p1 += Context::get().H * v;
+		p1 += Context::get().J * k;
+
+		verify_test(p0 == p1);
+	}
 }
 
 void TestSigning()
@@ -1008,6 +1219,70 @@ void TestRangeProof(bool bCustomTag)
 
 		for (size_t i = 0; i < _countof(user.m_pExtra); i++)
 			verify_test(user.m_pExtra[i] == user2.m_pExtra[i]);
+
+		// batch recovery, mixed with foreign outputs
+		HKdf kdf2;
+		SetRandom(seed);
+		kdf2.Generate(seed);
+
+		std::vector<beam::Output::Ptr> vOuts(5);
+		for (size_t i = 0; i < vOuts.size(); i++)
+		{
+			vOuts[i] = std::make_unique<beam::Output>();
+			vOuts[i]->Create(g_hFork, sk, (i & 1) ? kdf2 : kdf, cid, (i & 1) ? kdf2 : kdf, beam::Output::OpCode::Standard, &user);
+		}
+
+		for (uint32_t nThreads = 0; nThreads <= 2; nThreads += 2)
+		{
+			beam::ExecutorMT_R ex;
+			std::unique_ptr<beam::Executor::Scope> pScope;
+			if (nThreads)
+			{
+				ex.set_Threads(nThreads);
+				pScope = std::make_unique<beam::Executor::Scope>(ex);
+			}
+
+			std::vector<beam::Output::Recovered> vRes(vOuts.size());
+			beam::Output::RecoverBatch(g_hFork, kdf, &vOuts.front(), static_cast<uint32_t>(vOuts.size()), &vRes.front());
+
+			for (size_t i = 0; i < vOuts.size(); i++)
+			{
+				verify_test(vRes[i].m_Valid == !(i & 1));
+				if (vRes[i].m_Valid)
+				{
+					verify_test(vRes[i].m_Cid == cid);
+					verify_test(vRes[i].m_User.m_pExtra[0] == user.m_pExtra[0]);
+				}
+			}
+		}
+
+		// batch creation
+		std::vector<CoinID> vCids(vOuts.size());
+		std::vector<Scalar::Native> vSk(vOuts.size());
+		for (size_t i = 0; i < vOuts.size(); i++)
+		{
+			vCids[i] = CoinID(100 + i, 2 + i, Key::Type::Regular);
+			vOuts[i] = std::make_unique<beam::Output>();
+		}
+
+		{
+			beam::ExecutorMT_R ex;
+			ex.set_Threads(2);
+			beam::Executor::Scope scope(ex);
+
+			beam::Output::CreateBatch(g_hFork, &vOuts.front(), &vSk.front(), kdf, &vCids.front(), static_cast<uint32_t>(vOuts.size()), kdf);
+		}
+
+		for (size_t i = 0; i < vOuts.size(); i++)
+		{
+			verify_test(vOuts[i]->IsValid(g_hFork, comm));
+			Point::Native comm2 = Commitment(vSk[i], vCids[i].m_Value);
+			verify_test(comm == comm2);
+
+			CoinID cid2;
+			verify_test(vOuts[i]->Recover(g_hFork, kdf, cid2));
+			verify_test(vCids[i] == cid2);
+		}
 	}
 
 	WriteSizeSerialized("In-Utxo", beam::Input());
@@ -1411,6 +1686,16 @@ void TestTransaction()
 	ctx.m_Height.m_Min = g_hFork;
 	verify_test(tm.m_Trans.IsValid(ctx));
 	verify_test(ctx.m_Stats.m_Fee == beam::AmountBig::Type(fee1 + fee2));
+
+	// signatures are verified in a batch, make sure the tampered one is detected
+	beam::TxKernelStd& krn = Cast::Up<beam::TxKernelStd>(*tm.m_Trans.m_vKernels.front());
+	Scalar::Native k = krn.m_Signature.m_k;
+	k += Scalar::Native(1U);
+	krn.m_Signature.m_k = k;
+
+	ctx.Reset();
+	ctx.m_Height.m_Min = g_hFork;
+	verify_test(!tm.m_Trans.IsValid(ctx));
 }
 
 void TestCutThrough()
@@ -1514,6 +1799,42 @@ void TestKdfPair(Key::IKdf& skdf, Key::IPKdf& pkdf)
 		pk0 += pk1;
 		verify_test(pk0 == Zero);
 	}
+
+	// batch derivation
+	const uint32_t nBatch = 5;
+	Hash::Value pHv[nBatch];
+	for (uint32_t i = 0; i < nBatch; i++)
+		Hash::Processor() << "test_kdf_batch" << i >> pHv[i];
+
+	for (int iMode = 0; iMode < 2; iMode++)
+	{
+		ECC::Mode::Scope scope(iMode ? ECC::Mode::Fast : ECC::Mode::Secure);
+
+		Scalar::Native pSk0[nBatch], pSk1[nBatch];
+		skdf.DeriveKeyBatch(pSk0, pHv, nBatch);
+		pkdf.DerivePKeyBatch(pSk1, pHv, nBatch);
+
+		Point::Native pPkG[nBatch], pPkJ[nBatch];
+		pkdf.DerivePKeyGBatch(pPkG, pHv, nBatch);
+		pkdf.DerivePKeyJBatch(pPkJ, pHv, nBatch);
+
+		for (uint32_t i = 0; i < nBatch; i++)
+		{
+			Scalar::Native sk;
+			skdf.DeriveKey(sk, pHv[i]);
+			verify_test(Scalar(sk) == Scalar(pSk0[i]));
+
+			pkdf.DerivePKey(sk, pHv[i]);
+			verify_test(Scalar(sk) == Scalar(pSk1[i]));
+
+			Point::Native pk;
+			skdf.DerivePKeyG(pk, pHv[i]);
+			verify_test(Point(pk) == Point(pPkG[i]));
+
+			skdf.DerivePKeyJ(pk, pHv[i]);
+			verify_test(Point(pk) == Point(pPkJ[i]));
+		}
+	}
 }
 
 void TestKdf()
@@ -2540,6 +2861,19 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		Mode::Scope scope(Mode::Fast);
+		SetRandom(k1);
+
+		BenchmarkMeter bm("G.Multiply.Fast");
+		do
+		{
+			for (uint32_t i = 0; i < bm.N; i++)
+				p0 = Context::get().G * k1;
+
+		} while (bm.ShouldContinue());
+	}
+
 	{
 		BenchmarkMeter bm("Commit");
 		do
@@ -2569,6 +2903,38 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		HKdf skdf;
+		HKdfPub pkdf;
+		SetRandom(hv);
+		skdf.Generate(hv);
+		pkdf.GenerateFrom(skdf);
+
+		const uint32_t nBatch = 64;
+		Hash::Value pHv[nBatch];
+		for (uint32_t i = 0; i < nBatch; i++)
+			Hash::Processor() << "kdf" << i >> pHv[i];
+
+		Point::Native pPk[nBatch];
+
+		BenchmarkMeter bm("HKdfPub.DerivePKeyG.x64");
+		do
+		{
+			for (uint32_t i = 0; i < bm.N; i++)
+				for (uint32_t j = 0; j < nBatch; j++)
+					pkdf.DerivePKeyG(pPk[j], pHv[j]);
+
+		} while (bm.ShouldContinue());
+
+		BenchmarkMeter bm2("HKdfPub.DerivePKeyG.Batch.x64");
+		do
+		{
+			for (uint32_t i = 0; i < bm2.N; i++)
+				pkdf.DerivePKeyGBatch(pPk, pHv, nBatch);
+
+		} while (bm2.ShouldContinue());
+	}
+
 	Hash::Processor() << "abcd" >> hv;
 
 	Signature sig;
@@ -29,6 +29,66 @@ namespace beam::wallet
     {
     }
 
+    LocalPrivateKeyKeeper2::~LocalPrivateKeyKeeper2()
+    {
+        // Stop the threads before the base is destroyed. The running jobs are completed, the queued ones are discarded.
+        // The jobs don't access this object, hence it's ok that the derived classes are already destroyed.
+        m_pExecutor.reset();
+    }
+
+    void LocalPrivateKeyKeeper2::set_ProofThreads(uint32_t nThreads)
+    {
+        m_ProofThreads = nThreads;
+
+        if (m_pExecutor)
+        {
+            m_pExecutor->Flush(0); // complete the pending tasks
+            m_pExecutor.reset();
+        }
+    }
+
+    Executor* LocalPrivateKeyKeeper2::get_Executor()
+    {
+        if (Executor::s_pInstance)
+            return Executor::s_pInstance; // installed by the caller
+
+        return get_OwnExecutor();
+    }
+
+    Executor* LocalPrivateKeyKeeper2::get_ParallelJob(Method::CreateOutput& x, ParallelJob& job)
+    {
+        // Only own executor may be used, the caller's one may outlive this object.
+        ExecutorMT_R* pExec = get_OwnExecutor();
+        if (!pExec)
+            return nullptr;
+
+        if (IsTrustless() && (x.m_hScheme < Rules::get().pForks[1].m_Height))
+            return nullptr; // would be rejected synchronously
+
+        job = [&x, pKdf = m_pKdf]()
+        {
+            CreateOutputRaw(x, pKdf);
+            return Status::Success;
+        };
+
+        return pExec;
+    }
+
+    ExecutorMT_R* LocalPrivateKeyKeeper2::get_OwnExecutor()
+    {
+        if (1 == m_ProofThreads)
+            return nullptr;
+
+        if (!m_pExecutor)
+        {
+            m_pExecutor = std::make_unique<ExecutorMT_R>();
+            if (m_ProofThreads)
+                m_pExecutor->set_Threads(m_ProofThreads);
+        }
+
+        return m_pExecutor.get();
+    }
+
     IPrivateKeyKeeper2::Status::Type LocalPrivateKeyKeeper2::ToImage(Point::Native& res, uint32_t iGen, const Scalar::Native& sk)
     {
         const Generator::Obscured* pGen;
@@ -275,12 +335,16 @@ namespace beam::wallet
                 return Status::Unspecified; // blinding factor can be tampered without user permission
         }
 
+        CreateOutputRaw(x, m_pKdf);
+        return Status::Success;
+    }
+
+    void LocalPrivateKeyKeeper2::CreateOutputRaw(Method::CreateOutput& x, const Key::IKdf::Ptr& pKdf)
+    {
         x.m_pResult.reset(new Output);
 
         Scalar::Native sk;
-        x.m_pResult->Create(x.m_hScheme, sk, *x.m_Cid.get_ChildKdf(m_pKdf), x.m_Cid, *m_pKdf, Output::OpCode::Standard, &x.m_User);
-
-        return Status::Success;
+        x.m_pResult->Create(x.m_hScheme, sk, *x.m_Cid.get_ChildKdf(pKdf), x.m_Cid, *pKdf, Output::OpCode::Standard, &x.m_User);
     }
 
     IPrivateKeyKeeper2::Status::Type LocalPrivateKeyKeeper2::InvokeSync(Method::CreateInputShielded& x)
@@ -304,9 +368,14 @@ namespace beam::wallet
         x.m_pKernel->UpdateMsg();
         x.get_SkOut(prover.m_Witness.m_R_Output, x.m_pKernel->m_Fee, *m_pKdf);
 
-        ExecutorMT_R exec;
-        Executor::Scope scope(exec);
-        x.m_pKernel->Sign(prover, x.m_AssetID);
+        Executor* pExec = get_Executor();
+        if (pExec)
+        {
+            Executor::Scope scope(*pExec);
+            x.m_pKernel->Sign(prover, x.m_AssetID);
+        }
+        else
+            x.m_pKernel->Sign(prover, x.m_AssetID);
 
         return Status::Success;
     }
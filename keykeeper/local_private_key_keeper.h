@@ -28,12 +28,14 @@ namespace beam::wallet
     {
         static Status::Type ToImage(ECC::Point::Native& res, uint32_t iGen, const ECC::Scalar::Native& sk);
         static void UpdateOffset(Method::TxCommon&, const ECC::Scalar::Native& kDiff, const ECC::Scalar::Native& kKrn);
+        static void CreateOutputRaw(Method::CreateOutput&, const ECC::Key::IKdf::Ptr&);
 
         struct Aggregation;
 
     public:
 
         LocalPrivateKeyKeeper2(const ECC::Key::IKdf::Ptr&);
+        ~LocalPrivateKeyKeeper2();
 
 #define THE_MACRO(method) \
         virtual Status::Type InvokeSync(Method::method& m) override;
@@ -41,10 +43,17 @@ namespace beam::wallet
         KEY_KEEPER_METHODS(THE_MACRO)
 #undef THE_MACRO
 
+        // Threads used for the proofs generation: Lelantus spend proofs, and outputs created in parallel.
+        // 0 - number of cores (default), 1 - no extra threads. Ignored if the caller has its own executor in scope.
+        void set_ProofThreads(uint32_t);
+
     protected:
 
         ECC::Key::IKdf::Ptr m_pKdf;
 
+        Executor* get_Executor(); // caller's (if installed), or own
+        Executor* get_ParallelJob(Method::CreateOutput&, ParallelJob&) override;
+
         // make nonce generation abstract, to enable testing the code with predefined nonces
         virtual Slot::Type get_NumSlots() = 0;
         virtual void get_Nonce(ECC::Scalar::Native&, Slot::Type) = 0;
@@ -54,6 +63,12 @@ namespace beam::wallet
         virtual bool IsTrustless() { return false; }
         virtual Status::Type ConfirmSpend(Amount, Asset::ID, const PeerID&, const TxKernel&, Amount totalFee, bool bFinal) { return Status::Success; }
 
+    private:
+
+        uint32_t m_ProofThreads = 0;
+        std::unique_ptr<ExecutorMT_R> m_pExecutor; // created on demand
+
+        ExecutorMT_R* get_OwnExecutor();
     };
 
     class LocalPrivateKeyKeeperStd
@@ -0,0 +1,459 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bbs_store.h"
+#include "../core/proto.h"
+#include "../utility/logger.h"
+#include <boost/filesystem.hpp>
+
+namespace beam {
+
+namespace
+{
+	boost::filesystem::path PathFromStr(const std::string& s)
+	{
+#ifdef WIN32
+		return boost::filesystem::path(Utf8toUtf16(s.c_str()));
+#else // WIN32
+		return boost::filesystem::path(s);
+#endif // WIN32
+	}
+
+#pragma pack (push, 1)
+	struct RecordHdr
+	{
+		BbsStore::Key m_Key;
+		uintBigFor<BbsChannel>::Type m_Channel;
+		uintBigFor<Timestamp>::Type m_Time;
+		uintBigFor<uint32_t>::Type m_Nonce;
+		uintBigFor<uint32_t>::Type m_Size;
+	};
+#pragma pack (pop)
+
+	const char s_szSegmentExt[] = ".bbs";
+
+} // namespace
+
+size_t BbsStore::KeyHash::operator()(const Key& k) const
+{
+	// the key is a hash already
+	size_t ret;
+	memcpy(&ret, k.m_pData, sizeof(ret));
+	return ret;
+}
+
+std::string BbsStore::get_SegmentPath(uint64_t id0) const
+{
+	char sz[sizeof(id0) * 2 + 1];
+	uintBigFor<uint64_t>::Type(id0).Print(sz);
+
+	return m_sDir + "/" + sz + s_szSegmentExt;
+}
+
+void BbsStore::Open(const char* szDir)
+{
+	Close();
+
+	m_sDir = szDir;
+	boost::filesystem::path pathDir = PathFromStr(m_sDir);
+	boost::filesystem::create_directories(pathDir);
+
+	// segments are named by the ID of their 1st message
+	std::vector<std::pair<uint64_t, std::string> > vFiles;
+
+	for (boost::filesystem::directory_iterator endIt, it(pathDir); endIt != it; ++it)
+	{
+		const boost::filesystem::path& p = it->path();
+		if ((p.extension().string() != s_szSegmentExt) || !boost::filesystem::is_regular_file(p))
+			continue;
+
+		std::string sName = p.stem().string();
+
+		uintBigFor<uint64_t>::Type val;
+		if ((sName.size() != val.nTxtLen) || (val.Scan(sName.c_str()) != val.nTxtLen))
+			continue;
+
+		vFiles.emplace_back();
+		val.Export(vFiles.back().first);
+		vFiles.back().second = get_SegmentPath(vFiles.back().first);
+	}
+
+	std::sort(vFiles.begin(), vFiles.end());
+
+	for (size_t i = 0; i < vFiles.size(); i++)
+	{
+		if (vFiles[i].first <= m_LastID)
+		{
+			// overlaps the previous one. Shouldn't happen
+			LOG_WARNING() << "Bbs segment " << vFiles[i].second << " overlaps, deleting";
+			boost::system::error_code ec;
+			boost::filesystem::remove(PathFromStr(vFiles[i].second), ec);
+			continue;
+		}
+
+		m_Segments.emplace_back(new Segment);
+		Segment& s = *m_Segments.back();
+		s.m_ID0 = vFiles[i].first;
+		s.m_sPath = std::move(vFiles[i].second);
+
+		LoadSegment(s);
+
+		if (s.m_vEntries.empty())
+		{
+			boost::system::error_code ec;
+			boost::filesystem::remove(PathFromStr(s.m_sPath), ec);
+			m_Segments.pop_back();
+		}
+		else
+			m_LastID = s.m_ID0 + s.m_vEntries.size() - 1;
+	}
+
+	LOG_INFO() << "Bbs store: " << m_Segments.size() << " segments, " << m_Totals.m_Count << " messages, " << m_Totals.m_Size << " bytes";
+}
+
+void BbsStore::LoadSegment(Segment& s)
+{
+	std::FStream fs;
+	if (!fs.Open(s.m_sPath.c_str(), true))
+		return;
+
+	uint64_t nSize = fs.get_Remaining();
+
+	while (true)
+	{
+		uint64_t nRemaining = fs.get_Remaining();
+		if (nRemaining < sizeof(RecordHdr))
+			break;
+
+		RecordHdr hdr;
+		fs.read(&hdr, sizeof(hdr));
+
+		Entry e;
+		e.m_Key = hdr.m_Key;
+		hdr.m_Channel.Export(e.m_Channel);
+		hdr.m_Time.Export(e.m_Time);
+		hdr.m_Size.Export(e.m_Size);
+		e.m_Offset = static_cast<uint32_t>(s.m_FileSize);
+
+		if ((e.m_Size > proto::Bbs::s_MaxMsgSize) || (fs.get_Remaining() < e.m_Size))
+			break; // incomplete, or corrupted
+
+		fs.Seek(s.m_FileSize + sizeof(hdr) + e.m_Size);
+
+		if (m_mapKeys.end() != m_mapKeys.find(e.m_Key))
+			break; // duplicate? Shouldn't happen
+
+		AddEntry(s, e);
+	}
+
+	fs.Close();
+
+	if (s.m_FileSize < nSize)
+	{
+		LOG_WARNING() << "Bbs segment " << s.m_sPath << " truncated to " << s.m_FileSize;
+
+		boost::system::error_code ec;
+		boost::filesystem::resize_file(PathFromStr(s.m_sPath), s.m_FileSize, ec);
+	}
+}
+
+void BbsStore::AddEntry(Segment& s, Entry& e)
+{
+	uint64_t id = s.m_ID0 + s.m_vEntries.size();
+
+	if (s.m_vEntries.empty())
+		s.m_TimeFirst = e.m_Time;
+	std::setmax(s.m_TimeMax, e.m_Time);
+	std::setmax(m_TimeMax, e.m_Time);
+	e.m_TimeMax = s.m_TimeMax;
+
+	s.m_vEntries.push_back(e);
+	s.m_FileSize += sizeof(RecordHdr) + e.m_Size;
+
+	m_mapKeys[e.m_Key] = id;
+	m_mapChannels[e.m_Channel].push_back(id);
+
+	m_Totals.m_Count++;
+	m_Totals.m_Size += e.m_Size;
+}
+
+void BbsStore::Close()
+{
+	m_Writer.Close();
+	m_bWriterOpen = false;
+	m_bWriterDirty = false;
+
+	m_Segments.clear();
+	m_mapKeys.clear();
+	m_mapChannels.clear();
+
+	ZeroObject(m_Totals);
+	m_LastID = 0;
+	m_TimeMax = 0;
+}
+
+BbsStore::Segment& BbsStore::get_WriteSegment(Timestamp t)
+{
+	if (m_bWriterOpen)
+	{
+		Segment& s = *m_Segments.back();
+		if ((t < s.m_TimeFirst + m_Params.m_SegmentDuration_s) && (s.m_FileSize < m_Params.m_SegmentMaxSize))
+			return s;
+
+		m_Writer.Close();
+		m_bWriterOpen = false;
+		m_bWriterDirty = false;
+	}
+
+	m_Segments.emplace_back(new Segment);
+	Segment& s = *m_Segments.back();
+	s.m_ID0 = m_LastID + 1;
+	s.m_sPath = get_SegmentPath(s.m_ID0);
+
+	m_Writer.Open(s.m_sPath.c_str(), false, true);
+	m_bWriterOpen = true;
+
+	return s;
+}
+
+uint64_t BbsStore::Insert(const Data& d)
+{
+	assert(m_mapKeys.end() == m_mapKeys.find(d.m_Key));
+
+	Segment& s = get_WriteSegment(d.m_TimePosted);
+
+	Entry e;
+	e.m_Key = d.m_Key;
+	e.m_Channel = d.m_Channel;
+	e.m_Time = d.m_TimePosted;
+	e.m_Size = d.m_Message.n;
+	e.m_Offset = static_cast<uint32_t>(s.m_FileSize);
+
+	RecordHdr hdr;
+	hdr.m_Key = d.m_Key;
+	hdr.m_Channel = d.m_Channel;
+	hdr.m_Time = d.m_TimePosted;
+	hdr.m_Nonce = d.m_Nonce;
+	hdr.m_Size = d.m_Message.n;
+
+	m_Writer.write(&hdr, sizeof(hdr));
+	m_Writer.write(d.m_Message.p, d.m_Message.n);
+	m_bWriterDirty = true;
+
+	AddEntry(s, e);
+
+	m_LastID = s.m_ID0 + s.m_vEntries.size() - 1;
+	return m_LastID;
+}
+
+void BbsStore::Flush()
+{
+	if (m_bWriterDirty)
+	{
+		m_Writer.Flush();
+		m_bWriterDirty = false;
+	}
+}
+
+uint64_t BbsStore::Find(const Key& key) const
+{
+	auto it = m_mapKeys.find(key);
+	return (m_mapKeys.end() == it) ? 0 : it->second;
+}
+
+bool BbsStore::Find(const Key& key, Data& d, ByteBuffer& buf)
+{
+	uint64_t id = Find(key);
+	if (!id)
+		return false;
+
+	Segment* pSeg;
+	const Entry* pE = FindEntry(id, false, &pSeg);
+	assert(pE);
+
+	ReadMsg(*pSeg, *pE, d, buf);
+	return true;
+}
+
+const BbsStore::Entry* BbsStore::FindEntry(uint64_t& id, bool bNext, Segment** ppSeg) const
+{
+	// the last segment with ID0 <= id
+	auto it = std::upper_bound(m_Segments.begin(), m_Segments.end(), id, [](uint64_t id_, const std::unique_ptr<Segment>& p) {
+		return id_ < p->m_ID0;
+	});
+
+	if (m_Segments.begin() != it)
+	{
+		const Segment& s = **(it - 1);
+		uint64_t n = id - s.m_ID0;
+		if (n < s.m_vEntries.size())
+		{
+			if (ppSeg)
+				*ppSeg = (it - 1)->get();
+			return &s.m_vEntries[n];
+		}
+	}
+
+	if (!bNext || (m_Segments.end() == it))
+		return nullptr;
+
+	// in the gap, jump to the next segment
+	Segment& s = **it;
+	assert(!s.m_vEntries.empty());
+
+	id = s.m_ID0;
+	if (ppSeg)
+		*ppSeg = &s;
+	return &s.m_vEntries.front();
+}
+
+void BbsStore::ReadMsg(Segment& s, const Entry& e, Data& d, ByteBuffer& buf)
+{
+	if (m_bWriterOpen && (&s == m_Segments.back().get()))
+		Flush(); // the message may still be in the writer buffer
+
+	if (!s.m_Reader.IsOpen())
+		s.m_Reader.Open(s.m_sPath.c_str(), true, true);
+
+	RecordHdr hdr;
+	s.m_Reader.Seek(e.m_Offset);
+	s.m_Reader.read(&hdr, sizeof(hdr));
+
+	buf.resize(e.m_Size);
+	if (e.m_Size)
+		s.m_Reader.read(&buf.front(), e.m_Size);
+
+	d.m_Key = e.m_Key;
+	d.m_Channel = e.m_Channel;
+	d.m_TimePosted = e.m_Time;
+	hdr.m_Nonce.Export(d.m_Nonce);
+	d.m_Message = Blob(buf);
+}
+
+uint64_t BbsStore::FindCursor(Timestamp t) const
+{
+	for (size_t i = 0; i < m_Segments.size(); i++)
+	{
+		const Segment& s = *m_Segments[i];
+		if (s.m_TimeMax < t)
+			continue;
+
+		// the 1st entry that reaches t is where the running max reaches it
+		auto it = std::lower_bound(s.m_vEntries.begin(), s.m_vEntries.end(), t, [](const Entry& e, Timestamp t_) {
+			return e.m_TimeMax < t_;
+		});
+
+		assert(s.m_vEntries.end() != it);
+		return s.m_ID0 + (it - s.m_vEntries.begin());
+	}
+
+	return m_LastID + 1;
+}
+
+void BbsStore::DropOldest()
+{
+	assert(!m_Segments.empty());
+	Segment& s = *m_Segments.front();
+
+	for (size_t i = 0; i < s.m_vEntries.size(); i++)
+	{
+		const Entry& e = s.m_vEntries[i];
+		m_mapKeys.erase(e.m_Key);
+
+		auto it = m_mapChannels.find(e.m_Channel);
+		assert((m_mapChannels.end() != it) && (it->second.front() == s.m_ID0 + i));
+		it->second.pop_front();
+		if (it->second.empty())
+			m_mapChannels.erase(it);
+
+		m_Totals.m_Count--;
+		m_Totals.m_Size -= e.m_Size;
+	}
+
+	if (1 == m_Segments.size())
+	{
+		m_Writer.Close();
+		m_bWriterOpen = false;
+		m_bWriterDirty = false;
+	}
+
+	s.m_Reader.Close();
+
+	boost::system::error_code ec;
+	boost::filesystem::remove(PathFromStr(s.m_sPath), ec);
+
+	m_Segments.pop_front();
+}
+
+void BbsStore::Cleanup(Timestamp tsMin, const Totals& lim)
+{
+	while (!m_Segments.empty())
+	{
+		bool bOverLimit =
+			(m_Totals.m_Count > lim.m_Count) ||
+			(m_Totals.m_Size > lim.m_Size);
+
+		if (!bOverLimit && (m_Segments.front()->m_TimeMax >= tsMin))
+			break;
+
+		DropOldest();
+	}
+}
+
+void BbsStore::EnumAllSeq(WalkerSeq& wlk)
+{
+	wlk.m_pStore = this;
+}
+
+bool BbsStore::WalkerSeq::MoveNext()
+{
+	uint64_t id = m_ID + 1;
+	const Entry* pE = m_pStore->FindEntry(id, true);
+	if (!pE)
+		return false;
+
+	m_ID = id;
+	m_Key = pE->m_Key;
+	m_Size = pE->m_Size;
+	return true;
+}
+
+void BbsStore::EnumChannelSeq(WalkerChannel& wlk)
+{
+	wlk.m_pStore = this;
+}
+
+bool BbsStore::WalkerChannel::MoveNext()
+{
+	auto it = m_pStore->m_mapChannels.find(m_Data.m_Channel);
+	if (m_pStore->m_mapChannels.end() == it)
+		return false;
+
+	const std::deque<uint64_t>& v = it->second;
+	auto itID = std::upper_bound(v.begin(), v.end(), m_ID);
+	if (v.end() == itID)
+		return false;
+
+	uint64_t id = *itID;
+
+	Segment* pSeg;
+	const Entry* pE = m_pStore->FindEntry(id, false, &pSeg);
+	assert(pE);
+
+	m_pStore->ReadMsg(*pSeg, *pE, m_Data, m_Buf);
+	m_ID = id;
+	return true;
+}
+
+} // namespace beam
@@ -0,0 +1,155 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "core/block_crypt.h"
+#include <deque>
+#include <unordered_map>
+
+namespace beam {
+
+// BBS messages store. An append-only log, split into segment files by time (and size).
+// Messages are never deleted individually, the expiration drops whole segments, the oldest first.
+// The indexes (by key, and per channel) are kept in memory, and rebuilt from the segments on startup.
+// Message IDs are sequential, hence the enumeration (all, or per channel) is a sequential scan.
+class BbsStore
+{
+public:
+
+	typedef ECC::Hash::Value Key;
+
+	struct Data
+	{
+		Key m_Key;
+		BbsChannel m_Channel;
+		Timestamp m_TimePosted;
+		Blob m_Message;
+		uint32_t m_Nonce;
+	};
+
+	struct Totals
+	{
+		uint32_t m_Count;
+		uint64_t m_Size;
+	};
+
+	struct Params
+	{
+		uint32_t m_SegmentDuration_s = 60 * 10; // new segment is started after this period
+		uint32_t m_SegmentMaxSize = 1024 * 1024 * 64; // or above this size
+	} m_Params;
+
+	BbsStore() { ZeroObject(m_Totals); }
+	~BbsStore() { Close(); }
+
+	void Open(const char* szDir); // throws on error
+	void Close();
+
+	uint64_t Find(const Key&) const; // returns ID, or 0 if not found
+	bool Find(const Key&, Data&, ByteBuffer&); // message is read into the buffer
+	uint64_t Insert(const Data&); // must be unique. Returns the ID. Written lazily, call Flush() after a batch of inserts
+	void Flush();
+
+	uint64_t FindCursor(Timestamp) const; // 1st ID posted not earlier than the given time, or next ID if none
+	Timestamp get_MaxTime() const { return m_TimeMax; }
+	uint64_t get_LastID() const { return m_LastID; }
+	const Totals& get_Totals() const { return m_Totals; }
+
+	// Drop the oldest segments, whose messages are all older than the given time, or while the totals exceed the limit.
+	// The current segment may be dropped as well.
+	void Cleanup(Timestamp tsMin, const Totals& lim);
+
+	struct WalkerSeq
+	{
+		// set the ID before the enumeration (exclusive lower bound)
+		uint64_t m_ID;
+		Key m_Key;
+		uint32_t m_Size;
+
+		bool MoveNext();
+
+	private:
+		friend class BbsStore;
+		const BbsStore* m_pStore;
+	};
+
+	void EnumAllSeq(WalkerSeq&); // ordered by ID
+
+	struct WalkerChannel
+	{
+		// set the channel and the ID before the enumeration (exclusive lower bound)
+		uint64_t m_ID;
+		Data m_Data;
+		ByteBuffer m_Buf;
+
+		bool MoveNext();
+
+	private:
+		friend class BbsStore;
+		BbsStore* m_pStore;
+	};
+
+	void EnumChannelSeq(WalkerChannel&); // ordered by ID
+
+private:
+
+	struct Entry
+	{
+		Key m_Key;
+		BbsChannel m_Channel;
+		Timestamp m_Time;
+		Timestamp m_TimeMax; // of this and all the preceding entries in the segment. Non-decreasing, hence searchable
+		uint32_t m_Offset; // within the segment file
+		uint32_t m_Size; // message size
+	};
+
+	struct Segment
+	{
+		uint64_t m_ID0; // ID of the 1st message
+		uint64_t m_FileSize = 0;
+		Timestamp m_TimeFirst = 0; // of the 1st message, defines when the segment is sealed
+		Timestamp m_TimeMax = 0; // of the contained messages
+		std::string m_sPath;
+		std::vector<Entry> m_vEntries;
+		std::FStream m_Reader; // opened on-demand
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& k) const;
+	};
+
+	std::string m_sDir;
+	std::deque<std::unique_ptr<Segment> > m_Segments; // oldest first
+	std::FStream m_Writer; // for the last segment, if it's not sealed
+	bool m_bWriterOpen = false;
+	bool m_bWriterDirty = false; // not flushed yet
+
+	std::unordered_map<Key, uint64_t, KeyHash> m_mapKeys;
+	std::map<BbsChannel, std::deque<uint64_t> > m_mapChannels;
+
+	Totals m_Totals;
+	uint64_t m_LastID = 0;
+	Timestamp m_TimeMax = 0;
+
+	void LoadSegment(Segment&);
+	void AddEntry(Segment&, Entry&);
+	void DropOldest();
+	Segment& get_WriteSegment(Timestamp);
+	const Entry* FindEntry(uint64_t& id, bool bNext, Segment** ppSeg = nullptr) const; // bNext: the 1st one not lower than the given ID
+	void ReadMsg(Segment&, const Entry&, Data&, ByteBuffer&);
+	std::string get_SegmentPath(uint64_t id0) const;
+};
+
+} // namespace beam
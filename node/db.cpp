@@ -64,19 +64,17 @@ namespace beam {
 #define TblEvents_Body			"Body"
 #define TblEvents_Key			"Key"
 
-#define TblPeer					"Peers"
+#define TblPeer					"PeerBook"
 #define TblPeer_Key				"Key"
 #define TblPeer_Rating			"Rating"
 #define TblPeer_Addr			"Address"
 #define TblPeer_LastSeen		"LastSeen"
+#define TblPeer_Throughput		"Throughput"
+#define TblPeer_Latency			"Latency"
 
-#define TblBbs					"Bbs"
-#define TblBbs_ID				"ID"
-#define TblBbs_Key				"Key"
-#define TblBbs_Channel			"Channel"
-#define TblBbs_Time				"Time"
-#define TblBbs_Msg				"Message"
-#define TblBbs_Nonce			"Nonce"
+#define TblPeerOld				"Peers" // before ver 31, without the primary key
+
+#define TblBbsOld				"Bbs" // before ver 32, the messages are in the BbsStore now
 
 #define TblDummy				"Dummies"
 #define TblDummy_ID				"ID"
@@ -365,7 +363,7 @@ void NodeDB::Open(const char* szPath)
 		bCreate = !rs.Step();
 	}
 
-	const uint64_t nVersionTop = 30;
+	const uint64_t nVersionTop = 32;
 
 
 	Transaction t(*this);
@@ -433,7 +431,15 @@ void NodeDB::Open(const char* szPath)
 		case 29: // Block interpretation nKrnIdx fixed to match KrnWalker's
 			ParamIntSet(ParamID::Flags1, ParamIntGetDef(ParamID::Flags1) | Flags1::PendingRebuildNonStd);
 			CreateTables29();
+			// no break;
 
+		case 30: // Peers table rewritten on each flush, no stats
+			CreateTables30();
+			MigrateFrom30();
+			// no break;
+
+		case 31: // Bbs messages kept in the DB
+			MigrateFrom31();
 			// no break;
 
 			ParamIntSet(ParamID::DbVer, nVersionTop);
@@ -525,24 +531,6 @@ void NodeDB::Create()
 	ExecQuick("CREATE INDEX [Idx" TblEvents "] ON [" TblEvents "] ([" TblEvents_Height "],[" TblEvents_Body "]);");
 	ExecQuick("CREATE INDEX [Idx" TblEvents TblEvents_Key "] ON [" TblEvents "] ([" TblEvents_Key "]);");
 
-	ExecQuick("CREATE TABLE [" TblPeer "] ("
-		"[" TblPeer_Key			"] BLOB NOT NULL,"
-		"[" TblPeer_Rating		"] INTEGER NOT NULL,"
-		"[" TblPeer_Addr		"] INTEGER NOT NULL,"
-		"[" TblPeer_LastSeen	"] INTEGER NOT NULL)");
-
-	ExecQuick("CREATE TABLE [" TblBbs "] ("
-		"[" TblBbs_ID		"] INTEGER PRIMARY KEY AUTOINCREMENT,"
-		"[" TblBbs_Key		"] BLOB NOT NULL,"
-		"[" TblBbs_Channel	"] INTEGER NOT NULL,"
-		"[" TblBbs_Time		"] INTEGER NOT NULL,"
-		"[" TblBbs_Msg		"] BLOB NOT NULL,"
-		"[" TblBbs_Nonce	"] INTEGER)");
-
-	ExecQuick("CREATE INDEX [Idx" TblBbs "CSeq] ON [" TblBbs "] ([" TblBbs_Channel "],[" TblBbs_ID "]);");
-	ExecQuick("CREATE INDEX [Idx" TblBbs "TSeq] ON [" TblBbs "] ([" TblBbs_Time "],[" TblBbs_ID "]);");
-	ExecQuick("CREATE INDEX [Idx" TblBbs "Key] ON [" TblBbs "] ([" TblBbs_Key "]);");
-
 	ExecQuick("CREATE TABLE [" TblDummy "] ("
 		"[" TblDummy_ID				"] BLOB NOT NULL PRIMARY KEY,"
 		"[" TblDummy_SpendHeight	"] INTEGER NOT NULL)");
@@ -561,6 +549,7 @@ void NodeDB::Create()
 	CreateTables27();
 	CreateTables28();
 	CreateTables29();
+	CreateTables30();
 }
 
 void NodeDB::CreateTables20()
@@ -637,6 +626,18 @@ void NodeDB::CreateTables29()
 		"[" TblKrnInfo_Key		"] INTEGER NOT NULL PRIMARY KEY,"
 		"[" TblKrnInfo_Data		"] BLOB NOT NULL)");
 }
+
+void NodeDB::CreateTables30()
+{
+	ExecQuick("CREATE TABLE [" TblPeer "] ("
+		"[" TblPeer_Key			"] BLOB NOT NULL PRIMARY KEY,"
+		"[" TblPeer_Rating		"] INTEGER NOT NULL,"
+		"[" TblPeer_Addr		"] INTEGER NOT NULL,"
+		"[" TblPeer_LastSeen	"] INTEGER NOT NULL,"
+		"[" TblPeer_Throughput	"] INTEGER NOT NULL,"
+		"[" TblPeer_Latency		"] INTEGER NOT NULL"
+		") WITHOUT ROWID");
+}
 
 void NodeDB::Vacuum()
 {
@@ -1894,7 +1895,7 @@ bool NodeDB::WalkerEvent::MoveNext()
 
 void NodeDB::EnumPeers(WalkerPeer& x)
 {
-	x.m_Rs.Reset(*this, Query::PeerEnum, "SELECT " TblPeer_Key "," TblPeer_Rating "," TblPeer_Addr "," TblPeer_LastSeen " FROM " TblPeer);
+	x.m_Rs.Reset(*this, Query::PeerEnum, "SELECT " TblPeer_Key "," TblPeer_Rating "," TblPeer_Addr "," TblPeer_LastSeen "," TblPeer_Throughput "," TblPeer_Latency " FROM " TblPeer " ORDER BY " TblPeer_Rating " DESC");
 }
 
 bool NodeDB::WalkerPeer::MoveNext()
@@ -1905,197 +1906,35 @@ bool NodeDB::WalkerPeer::MoveNext()
 	m_Rs.get(1, m_Data.m_Rating);
 	m_Rs.get(2, m_Data.m_Address);
 	m_Rs.get(3, m_Data.m_LastSeen);
+	m_Rs.get(4, m_Data.m_Throughput_Bps);
+	m_Rs.get(5, m_Data.m_Latency_ms);
 	return true;
 }
 
 void NodeDB::PeersDel()
 {
-	Recordset rs(*this, Query::PeerDel, "DELETE FROM " TblPeer);
-	rs.Step();
-}
-
-void NodeDB::PeerIns(const WalkerPeer::Data& d)
-{
-	Recordset rs(*this, Query::PeerAdd, "INSERT INTO " TblPeer "(" TblPeer_Key "," TblPeer_Rating "," TblPeer_Addr "," TblPeer_LastSeen ") VALUES(?,?,?,?)");
-	rs.put(0, d.m_ID);
-	rs.put(1, d.m_Rating);
-	rs.put(2, d.m_Address);
-	rs.put(3, d.m_LastSeen);
+	Recordset rs(*this, Query::PeerDelAll, "DELETE FROM " TblPeer);
 	rs.Step();
-	TestChanged1Row();
-}
-
-bool NodeDB::EnumBbs(IBbsHistogram& x)
-{
-	Recordset rs(*this, Query::BbsHistogram, "SELECT " TblBbs_Channel ",COUNT(*) FROM " TblBbs " GROUP BY " TblBbs_Channel " ORDER BY " TblBbs_Channel);
-	while (rs.Step())
-	{
-		BbsChannel ch;
-		uint64_t nCount;
-
-		rs.get(0, ch);
-		rs.get(1, nCount);
-
-		if (!x.OnChannel(ch, nCount))
-			return false;
-	}
-
-	return true;
-}
-
-void NodeDB::EnumAllBbsSeq(WalkerBbsLite& x)
-{
-	x.m_Rs.Reset(*this, Query::BbsEnumAllSeq, "SELECT " TblBbs_ID "," TblBbs_Key ",LENGTH(" TblBbs_Msg ") FROM " TblBbs " WHERE " TblBbs_ID ">? ORDER BY " TblBbs_ID);
-	x.m_Rs.put(0, x.m_ID);
-}
-
-bool NodeDB::WalkerBbsLite::MoveNext()
-{
-	if (!m_Rs.Step())
-		return false;
-	m_Rs.get(0, m_ID);
-	m_Rs.get(1, m_Key);
-	m_Rs.get(2, m_Size);
-	return true;
-}
-
-void NodeDB::EnumAllBbs(WalkerBbsTimeLen& x)
-{
-	x.m_Rs.Reset(*this, Query::BbsEnumAll, "SELECT " TblBbs_ID "," TblBbs_Time ",LENGTH(" TblBbs_Msg ") FROM " TblBbs " ORDER BY " TblBbs_ID);
-}
-
-bool NodeDB::WalkerBbsTimeLen::MoveNext()
-{
-	if (!m_Rs.Step())
-		return false;
-	m_Rs.get(0, m_ID);
-	m_Rs.get(1, m_Time);
-	m_Rs.get(2, m_Size);
-	return true;
-}
-
-void NodeDB::get_BbsTotals(BbsTotals& x)
-{
-	Recordset rs(*this, Query::BbsTotals, "SELECT COUNT(*), SUM(Length(" TblBbs_Msg ")) FROM " TblBbs);
-	rs.StepStrict();
-
-	rs.get(0, x.m_Count);
-	rs.get(1, x.m_Size);
-}
-
-#define TblBbs_InsFieldsListed TblBbs_Key "," TblBbs_Channel "," TblBbs_Time "," TblBbs_Msg "," TblBbs_Nonce
-#define TblBbs_AllFieldsListed TblBbs_ID "," TblBbs_InsFieldsListed
-
-void NodeDB::EnumBbsCSeq(WalkerBbs& x)
-{
-	x.m_Rs.Reset(*this, Query::BbsEnumCSeq, "SELECT " TblBbs_AllFieldsListed " FROM " TblBbs " WHERE " TblBbs_Channel "=? AND " TblBbs_ID ">? ORDER BY " TblBbs_ID);
-
-	x.m_Rs.put(0, x.m_Data.m_Channel);
-	x.m_Rs.put(1, x.m_ID);
-}
-
-uint64_t NodeDB::get_AutoincrementID(const char* szTable)
-{
-	Recordset rs(*this, Query::AutoincrementID, "SELECT seq FROM sqlite_sequence WHERE name=?");
-	rs.put(0, szTable);
-	if (!rs.Step())
-		return 0;
-
-	if (rs.IsNull(0))
-		return 0;
-
-	uint64_t id;
-	rs.get(0, id);
-	return id;
-}
-
-uint64_t NodeDB::get_BbsLastID()
-{
-	return get_AutoincrementID(TblBbs);
-}
-
-bool NodeDB::WalkerBbs::MoveNext()
-{
-	if (!m_Rs.Step())
-		return false;
-	m_Rs.get(0, m_ID);
-	m_Rs.get(1, m_Data.m_Key);
-	m_Rs.get(2, m_Data.m_Channel);
-	m_Rs.get(3, m_Data.m_TimePosted);
-	m_Rs.get(4, m_Data.m_Message);
-	m_Rs.get(5, m_Data.m_Nonce); // don't care if NULL, would be 0
-
-	return true;
-}
-
-bool NodeDB::BbsFind(WalkerBbs& x)
-{
-	x.m_Rs.Reset(*this, Query::BbsFind, "SELECT " TblBbs_AllFieldsListed " FROM " TblBbs " WHERE " TblBbs_Key "=?");
-
-	x.m_Rs.put(0, x.m_Data.m_Key);
-	return x.MoveNext();
 }
 
-uint64_t NodeDB::BbsFind(const WalkerBbs::Key& key)
+void NodeDB::PeerDel(const PeerID& id)
 {
-	Recordset rs(*this,Query::BbsFindRaw, "SELECT rowid FROM " TblBbs " WHERE " TblBbs_Key "=?");
-	rs.put(0, key);
-	if (!rs.Step())
-		return 0;
-
-	uint64_t id;
-	rs.get(0, id);
-	return id;
-}
-
-void NodeDB::BbsDel(uint64_t id)
-{
-	Recordset rs(*this, Query::BbsDel, "DELETE FROM " TblBbs " WHERE " TblBbs_ID "=?");
+	Recordset rs(*this, Query::PeerDel, "DELETE FROM " TblPeer " WHERE " TblPeer_Key "=?");
 	rs.put(0, id);
 	rs.Step();
-	TestChanged1Row();
 }
 
-uint64_t NodeDB::BbsIns(const WalkerBbs::Data& d)
+void NodeDB::PeerSave(const WalkerPeer::Data& d)
 {
-	Recordset rs(*this, Query::BbsIns, "INSERT INTO " TblBbs "(" TblBbs_InsFieldsListed ") VALUES(?,?,?,?,?)");
-	rs.put(0, d.m_Key);
-	rs.put(1, d.m_Channel);
-	rs.put(2, d.m_TimePosted);
-	rs.put(3, d.m_Message);
-	rs.put(4, d.m_Nonce);
-
+	Recordset rs(*this, Query::PeerSave, "INSERT OR REPLACE INTO " TblPeer "(" TblPeer_Key "," TblPeer_Rating "," TblPeer_Addr "," TblPeer_LastSeen "," TblPeer_Throughput "," TblPeer_Latency ") VALUES(?,?,?,?,?,?)");
+	rs.put(0, d.m_ID);
+	rs.put(1, d.m_Rating);
+	rs.put(2, d.m_Address);
+	rs.put(3, d.m_LastSeen);
+	rs.put(4, d.m_Throughput_Bps);
+	rs.put(5, d.m_Latency_ms);
 	rs.Step();
 	TestChanged1Row();
-
-	return sqlite3_last_insert_rowid(m_pDb);
-}
-
-uint64_t NodeDB::BbsFindCursor(Timestamp t)
-{
-	Recordset rs(*this, Query::BbsFindCursor, "SELECT " TblBbs_ID " FROM " TblBbs " WHERE " TblBbs_Time ">=? ORDER BY " TblBbs_ID " ASC LIMIT 1");
-	rs.put(0, t);
-
-	if (!rs.Step())
-		return get_BbsLastID() + 1;
-
-	if (rs.IsNull(0))
-		return 0;
-
-	uint64_t id;
-	rs.get(0, id);
-	return id;
-}
-
-Timestamp NodeDB::get_BbsMaxTime()
-{
-	Recordset rs(*this, Query::BbsMaxTime, "SELECT MAX(" TblBbs_Time ") FROM " TblBbs);
-	if (!rs.Step())
-		return 0;
-
-	Timestamp ret;
-	rs.get(0, ret);
-	return ret;
 }
 
 uint64_t NodeDB::FindStateWorkGreater(const Difficulty::Raw& d)
@@ -2842,22 +2681,9 @@ void NodeDB::MigrateFrom18()
 	{
 		LOG_INFO() << "Resetting peer ratings...";
 
-		std::vector<WalkerPeer::Data> v;
-
-		{
-			WalkerPeer wlk;
-			for (EnumPeers(wlk); wlk.MoveNext(); )
-				v.push_back(wlk.m_Data);
-		}
-
-		PeersDel();
-
-		for (size_t i = 0; i < v.size(); i++)
-		{
-			WalkerPeer::Data& d = v[i];
-			d.m_Rating = PeerManager::Rating::Initial;
-			PeerIns(d);
-		}
+		// the old peers table is still in use at this point
+		std::string sSql = "UPDATE " TblPeerOld " SET " TblPeer_Rating "=" + std::to_string(PeerManager::Rating::Initial);
+		ExecQuick(sSql.c_str());
 	}
 
 	LOG_INFO() << "Migrating inputs...";
@@ -2923,6 +2749,21 @@ void NodeDB::MigrateFrom20()
 	}
 }
 
+void NodeDB::MigrateFrom30()
+{
+	// keep the most recent record for each peer (there could be duplicates)
+	ExecQuick("INSERT OR REPLACE INTO " TblPeer "(" TblPeer_Key "," TblPeer_Rating "," TblPeer_Addr "," TblPeer_LastSeen "," TblPeer_Throughput "," TblPeer_Latency ") "
+		"SELECT " TblPeer_Key "," TblPeer_Rating "," TblPeer_Addr "," TblPeer_LastSeen ",0,0 FROM " TblPeerOld " ORDER BY " TblPeer_LastSeen);
+
+	ExecQuick("DROP TABLE " TblPeerOld);
+}
+
+void NodeDB::MigrateFrom31()
+{
+	// BBS messages moved to the BbsStore. They are short-lived, and re-synced from the peers anyway, so just drop them
+	ExecQuick("DROP TABLE " TblBbsOld);
+}
+
 bool NodeDB::WalkerAssetEvt::MoveNext()
 {
 	if (!m_Rs.Step())
@@ -78,7 +78,6 @@ public:
 			Commit,
 			Rollback,
 			Scheme,
-			AutoincrementID,
 			ParamGet,
 			ParamSet,
 			ParamDel,
@@ -130,20 +129,10 @@ public:
 			EventDel,
 			EventEnum,
 			EventFind,
-			PeerAdd,
+			PeerSave,
 			PeerDel,
+			PeerDelAll,
 			PeerEnum,
-			BbsEnumCSeq,
-			BbsHistogram,
-			BbsEnumAllSeq,
-			BbsEnumAll,
-			BbsFindRaw,
-			BbsFind,
-			BbsFindCursor,
-			BbsDel,
-			BbsIns,
-			BbsMaxTime,
-			BbsTotals,
 			DummyIns,
 			DummyFindLowest,
 			DummyFind,
@@ -440,81 +429,18 @@ public:
 			uint32_t m_Rating;
 			uint64_t m_Address;
 			Timestamp m_LastSeen;
+			uint32_t m_Throughput_Bps; // observed, 0 if unknown
+			uint32_t m_Latency_ms; // smoothed RTT, 0 if unknown
 		} m_Data;
 
 		bool MoveNext();
 	};
 
 	void EnumPeers(WalkerPeer&); // highest to lowest
-	void PeerIns(const WalkerPeer::Data&);
+	void PeerSave(const WalkerPeer::Data&); // inserts or updates
+	void PeerDel(const PeerID&);
 	void PeersDel();
 
-	struct WalkerBbs
-	{
-		typedef ECC::Hash::Value Key;
-
-		Recordset m_Rs;
-		uint64_t m_ID;
-
-		struct Data {
-			Key m_Key;
-			BbsChannel m_Channel;
-			Timestamp m_TimePosted;
-			Blob m_Message;
-			uint32_t m_Nonce;
-		} m_Data;
-
-		bool MoveNext();
-	};
-
-	void EnumBbsCSeq(WalkerBbs&); // set channel and ID before invocation
-	uint64_t BbsIns(const WalkerBbs::Data&); // must be unique (if not sure - first try to find it). Returns the ID
-	bool BbsFind(WalkerBbs&); // set Key
-	uint64_t BbsFind(const WalkerBbs::Key&);
-	void BbsDel(uint64_t id);
-	uint64_t BbsFindCursor(Timestamp);
-	Timestamp get_BbsMaxTime();
-	uint64_t get_BbsLastID();
-
-	struct BbsTotals {
-		uint32_t m_Count;
-		uint64_t m_Size;
-	};
-
-	void get_BbsTotals(BbsTotals&);
-
-	struct WalkerBbsLite
-	{
-		typedef WalkerBbs::Key Key;
-
-		Recordset m_Rs;
-		uint64_t m_ID;
-		Key m_Key;
-		uint32_t m_Size;
-
-		bool MoveNext();
-	};
-
-	void EnumAllBbsSeq(WalkerBbsLite&); // ordered by m_ID. Must be initialized to specify the lower bound
-
-	struct WalkerBbsTimeLen
-	{
-		Recordset m_Rs;
-		uint64_t m_ID;
-		Timestamp m_Time;
-		uint32_t m_Size;
-
-		bool MoveNext();
-	};
-
-	void EnumAllBbs(WalkerBbsTimeLen&); // ordered by m_ID.
-
-	struct IBbsHistogram {
-		virtual bool OnChannel(BbsChannel, uint64_t nCount) = 0;
-	};
-	bool EnumBbs(IBbsHistogram&);
-
-
 	void InsertDummy(Height h, const Key::ID&);
 	Height GetLowestDummy(Key::ID&);
 	void DeleteDummy(const Key::ID& kid);
@@ -780,6 +706,7 @@ private:
 	void CreateTables27();
 	void CreateTables28();
 	void CreateTables29();
+	void CreateTables30();
 	void ExecQuick(const char*);
 	std::string ExecTextOut(const char*);
 	bool ExecStep(sqlite3_stmt*);
@@ -788,7 +715,6 @@ private:
 
 	sqlite3_stmt* get_Statement(Query::Enum, const char*);
 
-	uint64_t get_AutoincrementID(const char* szTable);
 	void TipAdd(uint64_t rowid, Height);
 	void TipDel(uint64_t rowid, Height);
 	void TipReachableAdd(uint64_t rowid);
@@ -800,6 +726,8 @@ private:
 
 	void MigrateFrom18();
 	void MigrateFrom20();
+	void MigrateFrom30();
+	void MigrateFrom31();
 
 	static const uint32_t s_StreamBlob;
 
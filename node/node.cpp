@@ -196,7 +196,7 @@ void Node::WantedTx::OnExpired(const KeyType& key)
     }
 }
 
-void Node::Bbs::CalcMsgKey(NodeDB::WalkerBbs::Data& d)
+void Node::Bbs::CalcMsgKey(BbsStore::Data& d)
 {
     ECC::Hash::Processor()
         << d.m_Message
@@ -361,11 +361,13 @@ bool Node::TryAssignTask(Task& t, Peer& p)
         return false;
 
     // check if the peer currently transfers a block
-    uint32_t nBlocks = 0;
+    uint32_t nBlocks = 0, nHdrPacks = 0;
 	for (TaskList::iterator it = p.m_lstTasks.begin(); p.m_lstTasks.end() != it; ++it)
 	{
 		if (it->m_Key.second)
 			nBlocks++;
+		else
+			nHdrPacks++;
 	}
 
 	// assign
@@ -374,6 +376,9 @@ bool Node::TryAssignTask(Task& t, Peer& p)
 		if (m_nTasksPackBody >= m_Cfg.m_MaxConcurrentBlocksRequest)
 			return false; // too many blocks requested
 
+		if (nBlocks >= p.get_PipelineDepth(true))
+			return false; // enough for this peer
+
 		Height hCountExtra = t.m_sidTrg.m_Height - t.m_Key.first.m_Height;
 
 		proto::GetBodyPack msg;
@@ -400,7 +405,18 @@ bool Node::TryAssignTask(Task& t, Peer& p)
 			msg.m_CountExtra = hCountExtra;
 		}
 
-		p.Send(msg);
+		if (!msg.m_CountExtra && !nBlocks && (t.m_Key.first.m_Height > m_Processor.m_SyncData.m_Target.m_Height) &&
+			m_Cfg.m_CompactBlocks && p.IsCompactBodySupported())
+		{
+			// single new block, most of its contents is likely to be in our tx pool
+			proto::GetBodyCompact msgCompact;
+			msgCompact.m_ID = msg.m_Top;
+			p.Send(msgCompact);
+
+			p.m_pCompact.reset(new Peer::CompactBody);
+		}
+		else
+			p.Send(msg);
 
 		t.m_nCount = std::min(static_cast<uint32_t>(msg.m_CountExtra), m_Cfg.m_BandwidthCtl.m_MaxBodyPackCount) + 1; // just an estimate, the actual num of blocks can be smaller
 		m_nTasksPackBody += t.m_nCount;
@@ -410,12 +426,18 @@ bool Node::TryAssignTask(Task& t, Peer& p)
 	}
 	else
 	{
-		if (m_nTasksPackHdr >= proto::g_HdrPackMaxSize)
+		const uint32_t nMaxPacks = std::max(m_Cfg.m_HdrSync.m_MaxPacks, 1U);
+		const uint32_t nMaxHdrs = proto::g_HdrPackMaxSize * nMaxPacks;
+
+		if (m_nTasksPackHdr >= nMaxHdrs)
 			return false; // too many hdrs requested
 
         if (nBlocks)
             return false; // don't requests headers from the peer that transfers a block
 
+		if ((nMaxPacks > 1) && (nHdrPacks >= p.get_PipelineDepth(false)))
+			return false; // parallel mode: spread the packs across different peers, wrt their bandwidth
+
 		uint32_t nPackSize = proto::g_HdrPackMaxSize;
 
 		// make sure we're not dealing with overlaps
@@ -426,7 +448,7 @@ bool Node::TryAssignTask(Task& t, Peer& p)
 		if (nPackSize > dh)
 			nPackSize = (uint32_t) dh;
 
-		std::setmin(nPackSize, proto::g_HdrPackMaxSize - m_nTasksPackHdr);
+		std::setmin(nPackSize, nMaxHdrs - m_nTasksPackHdr);
 
         proto::GetHdrPack msg;
         msg.m_Top = t.m_Key.first;
@@ -458,6 +480,88 @@ bool Node::TryAssignTask(Task& t, Peer& p)
     return true;
 }
 
+uint32_t Node::Peer::get_RequestTimeout_ms(const Task& t) const
+{
+	const Config& cfg = m_This.m_Cfg; // alias
+
+	uint32_t timeout_ms = t.m_Key.second ? cfg.m_Timeout.m_GetBlock_ms : cfg.m_Timeout.m_GetState_ms;
+	if (!m_Quality.m_Srtt_ms || !m_pInfo)
+		return timeout_ms; // not measured yet
+
+	// expected time: RTO + transfer time of the max expected response size, with some margin
+	uint64_t nSize = t.m_Key.second ?
+		std::min<uint64_t>(static_cast<uint64_t>(t.m_nCount) * Rules::get().MaxBodySize, cfg.m_BandwidthCtl.m_MaxBodyPackSize) :
+		static_cast<uint64_t>(t.m_nCount) * sizeof(Block::SystemState::Sequence::Element);
+
+	uint32_t bw = std::max(PeerManager::Rating::ToBps(m_pInfo->m_RawRating.m_Value), 1U);
+	uint64_t t_ms = (m_Quality.get_Rto_ms() + nSize * 1000 / bw) * 4;
+
+	if (t_ms < timeout_ms)
+		timeout_ms = std::max(static_cast<uint32_t>(t_ms), cfg.m_Timeout.m_RequestMin_ms);
+
+	return timeout_ms;
+}
+
+uint32_t Node::Peer::get_PipelineDepth(bool bBody) const
+{
+	const Config::BandwidthCtl& bc = m_This.m_Cfg.m_BandwidthCtl; // alias
+	if (!m_pInfo)
+		return 1;
+
+	uint64_t nUnit = bBody ?
+		bc.m_MaxBodyPackSize :
+		static_cast<uint64_t>(proto::g_HdrPackMaxSize) * sizeof(Block::SystemState::Sequence::Element);
+
+	uint64_t bw = PeerManager::Rating::ToBps(m_pInfo->m_RawRating.m_Value);
+	uint64_t n = 1 + bw * bc.m_PipelineWindow_ms / 1000 / std::max<uint64_t>(nUnit, 1);
+
+	return static_cast<uint32_t>(std::min<uint64_t>(n, std::max(bc.m_PipelineMax, 1U)));
+}
+
+void Node::Peer::Quality::OnRtt(uint32_t rtt_ms)
+{
+	std::setmax(rtt_ms, 1U);
+
+	// standard smoothing (as in TCP)
+	if (m_Srtt_ms)
+	{
+		uint32_t d = (m_Srtt_ms > rtt_ms) ? (m_Srtt_ms - rtt_ms) : (rtt_ms - m_Srtt_ms);
+		m_RttVar_ms = (m_RttVar_ms * 3 + d) / 4;
+		m_Srtt_ms = (m_Srtt_ms * 7 + rtt_ms) / 8;
+	}
+	else
+	{
+		m_Srtt_ms = rtt_ms;
+		m_RttVar_ms = rtt_ms / 2;
+	}
+}
+
+uint32_t Node::Peer::Quality::get_Rto_ms() const
+{
+	return m_Srtt_ms + 4 * m_RttVar_ms;
+}
+
+void Node::Peer::MaybeProbeRtt()
+{
+	if (m_Quality.m_ProbePending)
+		return;
+
+	// Only when idle. Otherwise the pong would come after the responses in transit, and the RTT would include their transfer time
+	if (!m_lstTasks.empty() || (Flags::Chocking & m_Flags))
+		return;
+
+	uint32_t t_ms = GetTime_ms();
+	if (m_Quality.m_Srtt_ms && (t_ms - m_Quality.m_LastProbe_ms < m_This.m_Cfg.m_Timeout.m_RttProbe_ms))
+		return;
+
+	m_Quality.m_ProbePending = true;
+	m_Quality.m_LastProbe_ms = t_ms;
+	m_Quality.m_PingTime_ms = t_ms;
+	m_Quality.m_PingsSent.push_back(true);
+
+	Send(proto::Ping(Zero));
+}
+
 void Node::Peer::SetTimerWrtFirstTask()
 {
 	if (m_lstTasks.empty())
@@ -467,11 +571,7 @@ void Node::Peer::SetTimerWrtFirstTask()
 	}
 	else
 	{
-		// TODO - timer w.r.t. rating, i.e. should not exceed much the best avail peer rating
-
-		uint32_t timeout_ms = m_lstTasks.front().m_Key.second ?
-			m_This.m_Cfg.m_Timeout.m_GetBlock_ms :
-			m_This.m_Cfg.m_Timeout.m_GetState_ms;
+		uint32_t timeout_ms = get_RequestTimeout_ms(m_lstTasks.front());
 
 		if (!m_pTimerRequest)
 			m_pTimerRequest = io::Timer::create(io::Reactor::get_Current());
@@ -554,6 +654,9 @@ void Node::Processor::FlushInsanePeers()
 
 void Node::DeleteOutdated()
 {
+    if (m_TxPool.m_TotalMemSize < (m_Cfg.m_MaxPoolSize >> 1))
+        m_TxPool.DecayMinRate(); // no pressure, halve it with each block
+
     Height h = m_Cfg.m_RollbackLimit.m_Max;
     std::setmin(h, Rules::get().MaxRollback);
 
@@ -624,6 +727,8 @@ void Node::Processor::OnNewState()
     get_ParentObj().DeleteOutdated(); // Better to delete all irrelevant txs explicitly, even if the node is supposed to mine
     // because in practice mining could be OFF (for instance, if miner key isn't defined, and owner wallet is offline).
 
+    get_ParentObj().m_Dandelion.OnNewState();
+
     if (get_ParentObj().m_Miner.IsEnabled())
     {
         get_ParentObj().m_Miner.HardAbortSafe();
@@ -633,6 +738,8 @@ void Node::Processor::OnNewState()
     proto::NewTip msg;
     msg.m_Description = m_Cursor.m_Full;
 
+    proto::NodeConnection::SharedMsg sm; // serialized once for all the peers
+
     for (PeerList::iterator it = get_ParentObj().m_lstPeers.begin(); get_ParentObj().m_lstPeers.end() != it; ++it)
     {
         Peer& peer = *it;
@@ -650,7 +757,10 @@ void Node::Processor::OnNewState()
 				continue;
 		}
 
-        peer.Send(msg);
+        if (sm.IsEmpty())
+            sm.Set(msg);
+
+        peer.SendShared(sm);
     }
 
     get_ParentObj().RefreshCongestions();
@@ -812,6 +922,7 @@ void Node::Processor::OnGoUpTimer()
 void Node::Processor::Stop()
 {
     m_ExecutorMT.Stop();
+    m_ExecutorBg.Stop();
     m_bGoUpPending = false;
     m_bFlushPending = false;
 
@@ -903,6 +1014,9 @@ Node::Peer* Node::AllocPeer(const beam::io::Address& addr)
     m_lstPeers.push_back(*pPeer);
 
 	pPeer->m_UnsentHiMark = m_Cfg.m_BandwidthCtl.m_Drown;
+	pPeer->m_UnsentDrop = m_Cfg.m_BandwidthCtl.m_DrownDrop;
+	pPeer->m_UnsentPauseMark = m_Cfg.m_BandwidthCtl.m_PauseHi;
+	pPeer->m_UnsentResumeMark = m_Cfg.m_BandwidthCtl.m_PauseLo;
     pPeer->m_pInfo = NULL;
     pPeer->m_Flags = 0;
     pPeer->m_Port = 0;
@@ -910,6 +1024,7 @@ Node::Peer* Node::AllocPeer(const beam::io::Address& addr)
     pPeer->m_RemoteAddr = addr;
     pPeer->m_LoginFlags = 0;
 	pPeer->m_CursorBbs = std::numeric_limits<int64_t>::max();
+	pPeer->m_nBbsPending = 0;
 	pPeer->m_pCursorTx = nullptr;
 
     LOG_VERBOSE() << "+Peer " << addr;
@@ -939,6 +1054,7 @@ void Node::Initialize(IExternalPOW* externalPOW)
         m_Cfg.m_VerificationThreads = m_Processor.m_ExecutorMT.get_Threads();
 
     m_Processor.m_ExecutorMT.set_Threads(std::max<uint32_t>(m_Cfg.m_VerificationThreads, 1U));
+    m_Processor.m_ExecutorBg.set_Threads(std::max<uint32_t>(m_Cfg.m_BackgroundThreads, 1U));
 
     m_Processor.m_Horizon = m_Cfg.m_Horizon;
     m_Processor.Initialize(m_Cfg.m_sPathLocal.c_str(), m_Cfg.m_ProcessorParams);
@@ -971,16 +1087,19 @@ void Node::Initialize(IExternalPOW* externalPOW)
 
     if (m_Cfg.m_Listen.port())
     {
-        m_Server.Listen(m_Cfg.m_Listen);
+        if (m_Cfg.m_ListenThreads)
+            m_NetThreads.Initialize();
+        else
+            m_Server.Listen(m_Cfg.m_Listen);
+
         if (m_Cfg.m_BeaconPeriod_ms)
             m_Beacon.Start();
     }
 
     m_PeerMan.Initialize();
     m_Miner.Initialize(externalPOW);
-	m_Processor.get_DB().get_BbsTotals(m_Bbs.m_Totals);
-    m_Bbs.Cleanup();
-	m_Bbs.m_HighestPosted_s = m_Processor.get_DB().get_BbsMaxTime();
+	m_Bbs.Initialize();
+	m_Dandelion.InitDummies();
 }
 
 uint32_t Node::get_AcessiblePeerCount() const
@@ -993,6 +1112,20 @@ const PeerManager::AddrSet& Node::get_AcessiblePeerAddrs() const
     return m_PeerMan.get_Addrs();
 }
 
+bool Node::get_PeerLink(PeerLink& pl, const PeerID& id)
+{
+	bool bCreate = false;
+	PeerManager::PeerInfo* pPi = m_PeerMan.Find(id, bCreate);
+	if (!pPi)
+		return false;
+
+	pl.m_Rating = pPi->m_RawRating.m_Value;
+	const PeerMan::PeerInfoPlus& pip = Cast::Up<PeerMan::PeerInfoPlus>(*pPi);
+	pl.m_Latency_ms = pip.m_Latency_ms;
+	pl.m_Live = !!pip.m_Live.m_p;
+	return true;
+}
+
 void Node::InitKeys()
 {
 	if (m_Keys.m_pOwner)
@@ -1097,31 +1230,39 @@ void Node::RefreshOwnedUtxos()
     }
 }
 
+void Node::Bbs::Initialize()
+{
+	Node& n = get_ParentObj();
+
+	if (!n.m_Cfg.m_Bbs.IsEnabled())
+		return;
+
+	std::string sPath;
+	NodeProcessor::get_DbSiblingPath(sPath, n.m_Cfg.m_sPathLocal.c_str(), "-bbs");
+
+	m_Store.m_Params = n.m_Cfg.m_Bbs.m_Store;
+	m_Store.Open(sPath.c_str());
+
+	m_Verifier.m_pEvtDone = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { m_Verifier.OnDone(); });
+
+	Cleanup();
+	m_HighestPosted_s = m_Store.get_MaxTime();
+}
+
 bool Node::Bbs::IsInLimits() const
 {
-	const NodeDB::BbsTotals& lims = get_ParentObj().m_Cfg.m_Bbs.m_Limit;
+	const BbsStore::Totals& lims = get_ParentObj().m_Cfg.m_Bbs.m_Limit;
+	const BbsStore::Totals& tots = m_Store.get_Totals();
 
 	return
-		(m_Totals.m_Count <= lims.m_Count) &&
-		(m_Totals.m_Size <= lims.m_Size);
+		(tots.m_Count <= lims.m_Count) &&
+		(tots.m_Size <= lims.m_Size);
 }
 
 void Node::Bbs::Cleanup()
 {
-	NodeDB& db = get_ParentObj().m_Processor.get_DB();
-	NodeDB::WalkerBbsTimeLen wlk;
-
 	Timestamp ts = getTimestamp() - get_ParentObj().m_Cfg.m_Bbs.m_MessageTimeout_s;
-
-	for (db.EnumAllBbs(wlk); wlk.MoveNext(); )
-	{
-		if (IsInLimits() && (wlk.m_Time >= ts))
-			break;
-
-		db.BbsDel(wlk.m_ID);
-		m_Totals.m_Count--;
-		m_Totals.m_Size -= wlk.m_Size;
-	}
+	m_Store.Cleanup(ts, get_ParentObj().m_Cfg.m_Bbs.m_Limit); // drops whole segments
 
 	m_LastCleanup_ms = GetTime_ms();
 }
@@ -1162,6 +1303,8 @@ Node::~Node()
     while (!m_lstPeers.empty())
         m_lstPeers.front().DeleteSelf(false, proto::NodeConnection::ByeReason::Stopping);
 
+    m_NetThreads.Stop(); // after the peers are closed
+
     while (!m_lstTasksUnassigned.empty())
         DeleteUnassignedTask(m_lstTasksUnassigned.front());
 
@@ -1188,6 +1331,36 @@ void Node::Peer::OnRequestTimeout()
     DeleteSelf(false, ByeReason::Timeout);
 }
 
+void Node::Peer::OnReadPaused(bool bPaused)
+{
+	if (bPaused)
+	{
+		LOG_VERBOSE() << "Peer " << m_RemoteAddr << " paused, unsent=" << get_Unsent();
+
+		if (!m_pTimerPaused)
+			m_pTimerPaused = io::Timer::create(io::Reactor::get_Current());
+
+		m_pTimerPaused->start(m_This.m_Cfg.m_BandwidthCtl.m_PauseMax_ms, false, [this]() { OnPausedTimeout(); });
+	}
+	else
+	{
+		LOG_VERBOSE() << "Peer " << m_RemoteAddr << " resumed";
+
+		if (m_pTimerPaused)
+			m_pTimerPaused->cancel();
+	}
+}
+
+void Node::Peer::OnPausedTimeout()
+{
+	if (!IsReadPaused())
+		return;
+
+	LOG_WARNING() << "Peer " << m_RemoteAddr << " doesn't drain, unsent=" << get_Unsent() << ", dropped=" << m_UnsentDropped;
+
+	DeleteSelf(false, ByeReason::Timeout);
+}
+
 void Node::Peer::OnResendPeers()
 {
     PeerMan& pm = m_This.m_PeerMan;
@@ -1426,6 +1599,7 @@ void Node::Peer::OnMsg(proto::Authentication&& msg)
         }
     }
 
+    MaybeProbeRtt();
     TakeTasks();
 }
 
@@ -1519,6 +1693,9 @@ void Node::Peer::ReleaseTask(Task& t)
 		t.m_nCount = 0;
     }
 
+    if (t.m_Key.second)
+        m_pCompact.reset();
+
     m_lstTasks.erase(TaskList::s_iterator_to(t));
     m_This.m_lstTasksUnassigned.push_back(t);
 
@@ -1551,8 +1728,16 @@ void Node::Peer::DeleteSelf(bool bIsError, uint8_t nByeReason)
     m_Tip.m_Height = 0; // prevent reassigning the tasks
     m_Flags &= ~Flags::HasTreasury;
 
+    if (Flags::HdrAnchors & m_Flags)
+    {
+        assert(this == m_This.m_HdrAnchors.m_pPeer);
+        m_This.m_HdrAnchors.m_pPeer = nullptr;
+        m_Flags &= ~Flags::HdrAnchors;
+    }
+
     ReleaseTasks();
     Unsubscribe();
+    m_This.m_Bbs.m_Verifier.OnPeerDeleted(*this);
 
     if (m_pInfo)
     {
@@ -1626,6 +1811,27 @@ void Node::Peer::TakeTasks()
 
 void Node::Peer::OnMsg(proto::Pong&&)
 {
+	if (m_Quality.m_PingsSent.empty())
+		ThrowUnexpected();
+
+	bool bProbe = m_Quality.m_PingsSent.front();
+	m_Quality.m_PingsSent.pop_front();
+
+	if (bProbe)
+	{
+		assert(m_Quality.m_ProbePending);
+		m_Quality.m_ProbePending = false;
+
+		uint32_t rtt_ms = GetTime_ms() - m_Quality.m_PingTime_ms;
+		m_Quality.OnRtt(rtt_ms);
+
+		// Don't touch the rating here: probes repeat while the peer is idle. The latency is accounted by the data responses (their time includes it)
+		if (m_pInfo)
+			m_pInfo->m_Latency_ms = m_Quality.m_Srtt_ms;
+
+		return;
+	}
+
 	if (!(Flags::Chocking & m_Flags))
 		ThrowUnexpected();
 
@@ -1677,6 +1883,8 @@ void Node::Peer::OnMsg(proto::NewTip&& msg)
         default:
             break; // suppress warning
         }
+
+        m_This.MaybeRequestHdrAnchors(*this);
     }
 
 	TakeTasks();
@@ -1701,6 +1909,7 @@ void Node::Peer::OnFirstTaskDone()
 {
     ReleaseTask(get_FirstTask());
     SetTimerWrtFirstTask();
+    MaybeProbeRtt();
 
 	// Refrain from using TakeTasks(), it will only try to assign tasks to this peer
 	m_This.RefreshCongestions();
@@ -1710,8 +1919,11 @@ void Node::Peer::OnFirstTaskDone()
 void Node::Peer::ModifyRatingWrtData(size_t nSize)
 {
 	PeerManager::TimePoint tp;
-	uint32_t dt_ms = tp.get() - get_FirstTask().m_TimeAssigned_ms;
+	ModifyRating(nSize, tp.get() - get_FirstTask().m_TimeAssigned_ms);
+}
 
+void Node::Peer::ModifyRating(size_t nSize, uint32_t dt_ms)
+{
 	// Calculate the weighted average of the effective bandwidth.
 	// We assume the "previous" bandwidth bw0 was calculated within "previous" window t0, and the total download amount was v0 = t0 * bw0.
 	// Hence, after accounting for newly-downloaded data, the average bandwidth becomes:
@@ -1729,6 +1941,14 @@ void Node::Peer::ModifyRatingWrtData(size_t nSize)
 
 	uint32_t nRatingAvg = PeerManager::Rating::FromBps(bwAvg);
 
+	if (nSize)
+	{
+		// observed throughput, smoothed. Unlike the rating it's not affected by penalties
+		uint32_t bw = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(nSize) * 1000 / std::max(dt_ms, 1U), static_cast<uint32_t>(-1)));
+		uint32_t& bwObserved = m_pInfo->m_Throughput_Bps;
+		bwObserved = bwObserved ? static_cast<uint32_t>((static_cast<uint64_t>(bwObserved) * 3 + bw) / 4) : bw;
+	}
+
 	m_This.m_PeerMan.m_LiveSet.erase(PeerMan::LiveSet::s_iterator_to(Cast::Up<PeerMan::PeerInfoPlus>(m_pInfo)->m_Live));
 	m_This.m_PeerMan.SetRating(*m_pInfo, nRatingAvg);
 	m_This.m_PeerMan.m_LiveSet.insert(Cast::Up<PeerMan::PeerInfoPlus>(m_pInfo)->m_Live);
@@ -2029,26 +2249,307 @@ void Node::Peer::OnMsg(proto::Body&& msg)
 {
 	Task& t = get_FirstTask();
 
-	if (!t.m_Key.second)
+	if (!t.m_Key.second || m_pCompact)
 		ThrowUnexpected();
 
-	ModifyRatingWrtData(msg.m_Body.m_Eternal.size() + msg.m_Body.m_Perishable.size());
+	OnBody(msg.m_Body);
+}
+
+void Node::Peer::OnBody(const proto::BodyBuffers& bb)
+{
+	ModifyRatingWrtData(bb.m_Eternal.size() + bb.m_Perishable.size());
 
-	const Block::SystemState::ID& id = t.m_Key.first;
+	const Block::SystemState::ID& id = get_FirstTask().m_Key.first;
 	Height h = id.m_Height;
 
 	Processor& p = m_This.m_Processor; // alias
 
 	NodeProcessor::DataStatus::Enum eStatus = h ?
         ShouldAcceptBodyPack() ?
-		    p.OnBlock(id, msg.m_Body.m_Perishable, msg.m_Body.m_Eternal, m_pInfo->m_ID.m_Key) :
+		    p.OnBlock(id, bb.m_Perishable, bb.m_Eternal, m_pInfo->m_ID.m_Key) :
             NodeProcessor::DataStatus::Rejected :
-		p.OnTreasury(msg.m_Body.m_Eternal);
+		p.OnTreasury(bb.m_Eternal);
 
 	p.TryGoUpAsync();
 	OnFirstTaskDone(eStatus);
 }
 
+bool Node::Peer::IsCompactBodySupported() const
+{
+	return proto::LoginFlags::Extension::get(m_LoginFlags) >= 9;
+}
+
+bool Node::Peer::GetBlockBody(Block::Body& block, const Block::SystemState::ID& id, ECC::Hash::Value* pChecksum /* = nullptr */)
+{
+	if (!id.m_Height)
+		return false;
+
+	NodeDB::StateID sid;
+	sid.m_Row = m_This.m_Processor.get_DB().StateFindSafe(id);
+	if (!sid.m_Row)
+		return false;
+	sid.m_Height = id.m_Height;
+
+	proto::GetBodyPack msg(Zero); // full body
+	proto::BodyBuffers bb;
+	if (!GetBlock(bb, sid, msg, false))
+		return false;
+
+	if (pChecksum)
+		bb.get_Checksum(*pChecksum);
+
+	Deserializer der;
+	der.reset(bb.m_Perishable);
+	der & Cast::Down<Block::BodyBase>(block);
+	der & Cast::Down<TxVectors::Perishable>(block);
+
+	der.reset(bb.m_Eternal);
+	der & Cast::Down<TxVectors::Eternal>(block);
+
+	return true;
+}
+
+void Node::Peer::OnMsg(proto::GetBodyCompact&& msg)
+{
+	proto::BodyCompact msgOut;
+
+	Block::Body block;
+	if (!GetBlockBody(block, msg.m_ID, &msgOut.m_Checksum))
+	{
+		proto::DataMissing msgMiss(Zero);
+		Send(msgMiss);
+		return;
+	}
+
+	const TxPool::Fluff& txp = m_This.m_TxPool; // alias
+
+	msgOut.m_Included = std::make_shared<Transaction>();
+	Transaction& tx = *msgOut.m_Included;
+
+	// inputs are always sent. They're small, and not indexed by the pool
+	tx.m_Offset = block.m_Offset;
+	tx.m_vInputs = std::move(block.m_vInputs);
+
+	// If the element is in our pool - the peer is likely to have it too
+	msgOut.m_Outputs.resize(block.m_vOutputs.size());
+	for (size_t i = 0; i < block.m_vOutputs.size(); i++)
+	{
+		TxPool::Fluff::get_OutputKey(msgOut.m_Outputs[i], *block.m_vOutputs[i]);
+		if (!txp.FindOutput(msgOut.m_Outputs[i]))
+			tx.m_vOutputs.push_back(std::move(block.m_vOutputs[i]));
+	}
+
+	msgOut.m_Kernels.resize(block.m_vKernels.size());
+	for (size_t i = 0; i < block.m_vKernels.size(); i++)
+	{
+		msgOut.m_Kernels[i] = block.m_vKernels[i]->m_Internal.m_ID;
+		if (!txp.FindKernel(msgOut.m_Kernels[i]))
+			tx.m_vKernels.push_back(std::move(block.m_vKernels[i]));
+	}
+
+	Send(msgOut);
+}
+
+void Node::Peer::OnMsg(proto::GetBodyParts&& msg)
+{
+	Block::Body block;
+	if (!GetBlockBody(block, msg.m_ID))
+	{
+		proto::DataMissing msgMiss(Zero);
+		Send(msgMiss);
+		return;
+	}
+
+	proto::BodyParts msgOut;
+	msgOut.m_Value = std::make_shared<Transaction>();
+	Transaction& tx = *msgOut.m_Value;
+
+	for (size_t i = 0; i < msg.m_Outputs.size(); i++)
+	{
+		uint32_t iIdx = msg.m_Outputs[i];
+		if ((iIdx >= block.m_vOutputs.size()) || !block.m_vOutputs[iIdx])
+			ThrowUnexpected(); // out of range or duplicated
+
+		tx.m_vOutputs.push_back(std::move(block.m_vOutputs[iIdx]));
+	}
+
+	for (size_t i = 0; i < msg.m_Kernels.size(); i++)
+	{
+		uint32_t iIdx = msg.m_Kernels[i];
+		if ((iIdx >= block.m_vKernels.size()) || !block.m_vKernels[iIdx])
+			ThrowUnexpected();
+
+		tx.m_vKernels.push_back(std::move(block.m_vKernels[iIdx]));
+	}
+
+	Send(msgOut);
+}
+
+void Node::Peer::OnMsg(proto::BodyCompact&& msg)
+{
+	Task& t = get_FirstTask();
+
+	if (!t.m_Key.second || !m_pCompact || !m_pCompact->m_vOutputKeys.empty() || !m_pCompact->m_vKernelKeys.empty() || !msg.m_Included)
+		ThrowUnexpected();
+
+	CompactBody& cb = *m_pCompact;
+	Transaction& tx = *msg.m_Included;
+	const TxPool::Fluff& txp = m_This.m_TxPool; // alias
+
+	cb.m_Checksum = msg.m_Checksum;
+	cb.m_Body.m_Offset = tx.m_Offset;
+	cb.m_Body.m_vInputs = std::move(tx.m_vInputs);
+
+	// Included elements are in the block order, match them sequentially.
+	size_t iIncluded = 0;
+	ECC::Hash::Value hvIncluded;
+	bool bIncluded = false;
+
+	cb.m_Body.m_vOutputs.resize(msg.m_Outputs.size());
+	for (uint32_t i = 0; i < msg.m_Outputs.size(); i++)
+	{
+		const ECC::Hash::Value& hvKey = msg.m_Outputs[i];
+
+		if (!bIncluded && (iIncluded < tx.m_vOutputs.size()))
+		{
+			TxPool::Fluff::get_OutputKey(hvIncluded, *tx.m_vOutputs[iIncluded]);
+			bIncluded = true;
+		}
+
+		if (bIncluded && (hvIncluded == hvKey))
+		{
+			cb.m_Body.m_vOutputs[i] = std::move(tx.m_vOutputs[iIncluded++]);
+			bIncluded = false;
+			continue;
+		}
+
+		const Output* pOutp = txp.FindOutput(hvKey);
+		if (pOutp)
+		{
+			cb.m_Body.m_vOutputs[i].reset(new Output);
+			*cb.m_Body.m_vOutputs[i] = *pOutp;
+		}
+		else
+			cb.m_vOutputs.push_back(i);
+	}
+
+	size_t iIncludedKrn = 0;
+	cb.m_Body.m_vKernels.resize(msg.m_Kernels.size());
+	for (uint32_t i = 0; i < msg.m_Kernels.size(); i++)
+	{
+		const Merkle::Hash& hvKey = msg.m_Kernels[i];
+
+		if ((iIncludedKrn < tx.m_vKernels.size()) && (tx.m_vKernels[iIncludedKrn]->m_Internal.m_ID == hvKey))
+		{
+			cb.m_Body.m_vKernels[i] = std::move(tx.m_vKernels[iIncludedKrn++]);
+			continue;
+		}
+
+		const TxKernel* pKrn = txp.FindKernel(hvKey);
+		if (pKrn)
+			pKrn->Clone(cb.m_Body.m_vKernels[i]);
+		else
+			cb.m_vKernels.push_back(i);
+	}
+
+	if ((iIncluded != tx.m_vOutputs.size()) || (iIncludedKrn != tx.m_vKernels.size()))
+		ThrowUnexpected(); // garbage
+
+	if (cb.m_vOutputs.empty() && cb.m_vKernels.empty())
+	{
+		OnCompactBodyReady();
+		return;
+	}
+
+	proto::GetBodyParts msgOut;
+	msgOut.m_ID = t.m_Key.first;
+	msgOut.m_Outputs = cb.m_vOutputs;
+	msgOut.m_Kernels = cb.m_vKernels;
+	Send(msgOut);
+
+	// remember what to expect
+	cb.m_vOutputKeys.resize(cb.m_vOutputs.size());
+	for (size_t i = 0; i < cb.m_vOutputs.size(); i++)
+		cb.m_vOutputKeys[i] = msg.m_Outputs[cb.m_vOutputs[i]];
+
+	cb.m_vKernelKeys.resize(cb.m_vKernels.size());
+	for (size_t i = 0; i < cb.m_vKernels.size(); i++)
+		cb.m_vKernelKeys[i] = msg.m_Kernels[cb.m_vKernels[i]];
+}
+
+void Node::Peer::OnMsg(proto::BodyParts&& msg)
+{
+	Task& t = get_FirstTask();
+
+	if (!t.m_Key.second || !m_pCompact || (m_pCompact->m_vOutputKeys.empty() && m_pCompact->m_vKernelKeys.empty()) || !msg.m_Value)
+		ThrowUnexpected();
+
+	CompactBody& cb = *m_pCompact;
+	Transaction& tx = *msg.m_Value;
+
+	if ((tx.m_vOutputs.size() != cb.m_vOutputs.size()) || (tx.m_vKernels.size() != cb.m_vKernels.size()))
+		ThrowUnexpected();
+
+	for (size_t i = 0; i < tx.m_vOutputs.size(); i++)
+	{
+		ECC::Hash::Value hv;
+		TxPool::Fluff::get_OutputKey(hv, *tx.m_vOutputs[i]);
+		if (hv != cb.m_vOutputKeys[i])
+			ThrowUnexpected();
+
+		cb.m_Body.m_vOutputs[cb.m_vOutputs[i]] = std::move(tx.m_vOutputs[i]);
+	}
+
+	for (size_t i = 0; i < tx.m_vKernels.size(); i++)
+	{
+		if (tx.m_vKernels[i]->m_Internal.m_ID != cb.m_vKernelKeys[i])
+			ThrowUnexpected();
+
+		cb.m_Body.m_vKernels[cb.m_vKernels[i]] = std::move(tx.m_vKernels[i]);
+	}
+
+	OnCompactBodyReady();
+}
+
+void Node::Peer::OnCompactBodyReady()
+{
+	assert(m_pCompact);
+	const Block::Body& block = m_pCompact->m_Body;
+
+	LOG_INFO() << get_FirstTask().m_Key.first << " Compact body restored, missing outputs/kernels: " << m_pCompact->m_vOutputs.size() << "/" << m_pCompact->m_vKernels.size();
+
+	proto::BodyBuffers bb;
+
+	Serializer ser;
+	ser & Cast::Down<Block::BodyBase>(block);
+	ser & Cast::Down<TxVectors::Perishable>(block);
+	ser.swap_buf(bb.m_Perishable);
+
+	ser.reset();
+	ser & Cast::Down<TxVectors::Eternal>(block);
+	ser.swap_buf(bb.m_Eternal);
+
+	ECC::Hash::Value hv;
+	bb.get_Checksum(hv);
+
+	bool bMatch = (hv == m_pCompact->m_Checksum);
+	m_pCompact.reset();
+
+	if (bMatch)
+	{
+		OnBody(bb);
+		return;
+	}
+
+	// Element IDs don't cover everything (e.g. the kernel signature isn't a part of its ID), our pool version may differ.
+	// Fall back to the full body download. Not the peer's fault.
+	LOG_WARNING() << get_FirstTask().m_Key.first << " Compact body checksum mismatch, requesting the full body";
+
+	proto::GetBodyPack msgOut(Zero);
+	msgOut.m_Top = get_FirstTask().m_Key.first;
+	Send(msgOut);
+}
+
 void Node::Peer::OnMsg(proto::BodyPack&& msg)
 {
 	Task& t = get_FirstTask();
@@ -2222,6 +2723,16 @@ uint8_t Node::ValidateTx(Transaction::Context& ctx, const Transaction& tx, uint3
         return proto::TxStatus::LowFee;
     }
 
+    TxPool::Profit p;
+    p.m_Fee = ctx.m_Stats.m_Fee;
+    p.SetSize(tx, nSizeCorrection);
+
+    if (m_TxPool.IsBelowMinRate(p)) {
+        if (pExtraInfo)
+            *pExtraInfo << "Low fee, the pool is full";
+        return proto::TxStatus::LowFee;
+    }
+
 	return proto::TxStatus::Ok;
 }
 
@@ -2430,6 +2941,8 @@ uint8_t Node::OnTransactionStem(Transaction::Ptr&& ptx, std::ostream* pExtraInfo
         pGuard->m_pValue.swap(ptx);
 		pGuard->m_Height = ctx.m_Height;
         pGuard->m_FeeReserve = feeReserve;
+        pGuard->m_CtxID = m_Processor.m_Cursor.m_ID;
+        pGuard->m_Received_ms = GetTime_ms();
 
         m_Dandelion.InsertKrn(*pGuard);
 
@@ -2461,6 +2974,18 @@ void Node::OnTransactionAggregated(TxPool::Stem::Element& x)
 	m_Dandelion.DeleteAggr(x);
 	LogTxStem(*x.m_pValue, "Aggregation finished");
 
+	DandelionStats& st = m_Dandelion.m_Stats;
+	uint32_t dt_ms = GetTime_ms() - x.m_Received_ms;
+	st.m_Aggregated++;
+	st.m_Latency_ms += dt_ms;
+	std::setmax(st.m_LatencyMax_ms, dt_ms);
+
+	if (m_Cfg.m_LogTxStem)
+	{
+		LOG_INFO() << "Stem aggregation: latency=" << dt_ms << "ms, total=" << st.m_Aggregated << ", avg=" << (st.m_Latency_ms / st.m_Aggregated) << "ms, max=" << st.m_LatencyMax_ms
+			<< "ms, merged=" << st.m_Merged << " (fast " << st.m_MergedFast << "), dummies pooled=" << st.m_DummiesPooled << ", inline=" << st.m_DummiesInline << ", dropped=" << st.m_DummiesDropped;
+	}
+
     // must have at least 1 peer to continue the stem phase
     uint32_t nStemPeers = 0;
 
@@ -2521,7 +3046,8 @@ void Node::PerformAggregation(TxPool::Stem::Element& x)
         TxPool::Stem::Element& src = it->get_ParentObj();
         ++it;
 
-        m_Dandelion.TryMerge(x, src);
+        if (m_Dandelion.TryMerge(x, src))
+            m_Dandelion.m_Stats.m_Merged++;
     }
 
     it = TxPool::Stem::ProfitSet::s_iterator_to(x.m_Profit);
@@ -2536,7 +3062,8 @@ void Node::PerformAggregation(TxPool::Stem::Element& x)
             if (!bEnd)
                 --it;
 
-            m_Dandelion.TryMerge(x, src);
+            if (m_Dandelion.TryMerge(x, src))
+                m_Dandelion.m_Stats.m_Merged++;
 
             if (bEnd)
                 break;
@@ -2658,27 +3185,28 @@ void Node::AddDummyOutputs(Transaction& tx, Amount feeReserve)
         if (feeReserve < fs.m_Output)
             break;
 
-		CoinID cid(Zero);
-		cid.m_Type = Key::Type::Decoy;
-        cid.set_Subkey(m_Keys.m_nMinerSubIndex);
-
-		while (true)
-		{
-			NextNonce().ExportWord<0>(cid.m_Idx);
-			if (MaxHeight == db.GetDummyHeight(cid))
-				break;
-		}
-
         bModified = true;
 
-        auto pOutput = std::make_unique<Output>();
+        Dandelion::DummyOutput d;
         ECC::Scalar::Native sk;
-        pOutput->Create(m_Processor.m_Cursor.m_ID.m_Height + 1, sk, *m_Keys.m_pMiner, cid, *m_Keys.m_pOwner);
+
+        if (m_Dandelion.TakeDummy(d))
+        {
+            sk = d.m_sk;
+            m_Dandelion.m_Stats.m_DummiesPooled++;
+        }
+        else
+        {
+            d.m_Cid = GenerateDummyCid();
+            d.m_pOutput = std::make_unique<Output>();
+            d.m_pOutput->Create(m_Processor.m_Cursor.m_ID.m_Height + 1, sk, *m_Keys.m_pMiner, d.m_Cid, *m_Keys.m_pOwner);
+            m_Dandelion.m_Stats.m_DummiesInline++;
+        }
 
 		Height h = SampleDummySpentHeight();
-        db.InsertDummy(h, cid);
+        db.InsertDummy(h, d.m_Cid);
 
-        tx.m_vOutputs.push_back(std::move(pOutput));
+        tx.m_vOutputs.push_back(std::move(d.m_pOutput));
 
         sk = -sk;
         tx.m_Offset = ECC::Scalar::Native(tx.m_Offset) + sk;
@@ -2690,9 +3218,160 @@ void Node::AddDummyOutputs(Transaction& tx, Amount feeReserve)
     {
         m_Processor.FlushDB();
         tx.Normalize();
+        m_Dandelion.RefillDummies();
     }
 }
 
+CoinID Node::GenerateDummyCid()
+{
+	CoinID cid(Zero);
+	cid.m_Type = Key::Type::Decoy;
+	cid.set_Subkey(m_Keys.m_nMinerSubIndex);
+
+	NodeDB& db = m_Processor.get_DB();
+	while (true)
+	{
+		NextNonce().ExportWord<0>(cid.m_Idx);
+		if (MaxHeight == db.GetDummyHeight(cid))
+			break;
+	}
+
+	return cid;
+}
+
+struct Node::Dandelion::DummyTask
+	:public Executor::TaskAsync
+{
+	Dandelion* m_pThis;
+	Key::IKdf::Ptr m_pMiner;
+	Key::IPKdf::Ptr m_pOwner;
+	DummyOutput m_Res;
+
+	virtual void Exec(Executor::Context&) override
+	{
+		ECC::Scalar::Native sk;
+		m_Res.m_pOutput = std::make_unique<Output>();
+		m_Res.m_pOutput->Create(m_Res.m_hScheme, sk, *m_pMiner, m_Res.m_Cid, *m_pOwner);
+		m_Res.m_sk = sk;
+
+		bool bWasEmpty;
+		{
+			std::unique_lock<std::mutex> scope(m_pThis->m_MutexDummies);
+			bWasEmpty = m_pThis->m_vDummiesDone.empty();
+			m_pThis->m_vDummiesDone.push_back(std::move(m_Res));
+		}
+
+		if (bWasEmpty)
+			m_pThis->m_pEvtDummies->post();
+	}
+};
+
+void Node::Dandelion::InitDummies()
+{
+	m_pEvtDummies = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { OnDummiesReady(); });
+	RefillDummies();
+}
+
+void Node::Dandelion::RefillDummies()
+{
+	Node& n = get_ParentObj();
+	const Config::Dandelion& d = n.m_Cfg.m_Dandelion; // alias
+
+	if (d.m_DummyLifetimeHi && n.m_Keys.m_pMiner && m_pEvtDummies && (m_DummyPool.size() + m_DummiesPending < d.m_DummyPoolSize))
+		m_Refill.start();
+}
+
+void Node::Dandelion::Refill::OnSchedule()
+{
+	cancel();
+
+	Dandelion& dd = get_ParentObj();
+	Node& n = dd.get_ParentObj();
+
+	uint32_t nPoolSize = n.m_Cfg.m_Dandelion.m_DummyPoolSize;
+	Height hScheme = n.m_Processor.m_Cursor.m_ID.m_Height + 1;
+
+	while (dd.m_DummyPool.size() + dd.m_DummiesPending < nPoolSize)
+	{
+		std::unique_ptr<DummyTask> pTask(new DummyTask);
+		pTask->m_pThis = &dd;
+		pTask->m_pMiner = n.m_Keys.m_pMiner;
+		pTask->m_pOwner = n.m_Keys.m_pOwner;
+		pTask->m_Res.m_Cid = n.GenerateDummyCid();
+		pTask->m_Res.m_hScheme = hScheme;
+
+		n.m_Processor.m_ExecutorBg.Push(std::move(pTask));
+		dd.m_DummiesPending++;
+	}
+}
+
+void Node::Dandelion::OnDummiesReady()
+{
+	std::vector<DummyOutput> v;
+	{
+		std::unique_lock<std::mutex> scope(m_MutexDummies);
+		v.swap(m_vDummiesDone);
+	}
+
+	assert(m_DummiesPending >= v.size());
+	m_DummiesPending -= static_cast<uint32_t>(v.size());
+	m_Stats.m_DummiesGenerated += v.size();
+
+	for (size_t i = 0; i < v.size(); i++)
+		m_DummyPool.push_back(std::move(v[i]));
+}
+
+bool Node::Dandelion::TakeDummy(DummyOutput& res)
+{
+	Node& n = get_ParentObj();
+	Height hScheme = n.m_Processor.m_Cursor.m_ID.m_Height + 1;
+	uint32_t iFork = Rules::get().FindFork(hScheme);
+
+	while (!m_DummyPool.empty())
+	{
+		DummyOutput& d = m_DummyPool.front();
+
+		// the output format depends on the fork. Also make sure the ID wasn't taken meanwhile
+		bool bValid =
+			(Rules::get().FindFork(d.m_hScheme) == iFork) &&
+			(MaxHeight == n.m_Processor.get_DB().GetDummyHeight(d.m_Cid));
+
+		if (bValid)
+			res = std::move(d);
+
+		m_DummyPool.pop_front();
+
+		if (bValid)
+			return true;
+	}
+
+	return false;
+}
+
+void Node::Dandelion::OnNewState()
+{
+	if (m_DummyPool.empty())
+		return;
+
+	Node& n = get_ParentObj();
+	uint32_t iFork = Rules::get().FindFork(n.m_Processor.m_Cursor.m_ID.m_Height + 1);
+
+	size_t nSize0 = m_DummyPool.size();
+	for (auto it = m_DummyPool.begin(); m_DummyPool.end() != it; )
+	{
+		if (Rules::get().FindFork(it->m_hScheme) == iFork)
+			++it;
+		else
+			it = m_DummyPool.erase(it);
+	}
+
+	if (m_DummyPool.size() != nSize0)
+	{
+		m_Stats.m_DummiesDropped += nSize0 - m_DummyPool.size();
+		RefillDummies();
+	}
+}
+
 Height Node::SampleDummySpentHeight()
 {
 	const Config::Dandelion& d = m_Cfg.m_Dandelion; // alias
@@ -2783,7 +3462,8 @@ uint8_t Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, std::ostream* pExtra
 
 	TxPool::Fluff::Element* pNewTxElem = m_TxPool.AddValidTx(std::move(ptx), ctx, key.m_Key, nSizeCorrection);
 
-	while (m_TxPool.m_setProfit.size() + m_TxPool.m_setOutdated.size() > m_Cfg.m_MaxPoolTransactions)
+	while ((m_TxPool.m_setProfit.size() + m_TxPool.m_setOutdated.size() > m_Cfg.m_MaxPoolTransactions) ||
+		(m_TxPool.m_TotalMemSize > m_Cfg.m_MaxPoolSize))
 	{
         TxPool::Fluff::Element& txDel = m_TxPool.m_setOutdated.empty() ?
             m_TxPool.m_setProfit.rbegin()->get_ParentObj() :
@@ -2792,6 +3472,9 @@ uint8_t Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, std::ostream* pExtra
 		if (&txDel == pNewTxElem)
 			pNewTxElem = nullptr; // Anti-spam protection: in case the maximum pool capacity is reached - ensure this tx is any better BEFORE broadcasting ti
 
+		if (!txDel.IsOutdated())
+			m_TxPool.RaiseMinRate(txDel.m_Profit); // new txs must be better
+
 		m_TxPool.Delete(txDel);
 	}
 
@@ -2834,6 +3517,70 @@ void Node::Dandelion::OnTimedOut(Element& x)
 	}
 }
 
+bool Node::Dandelion::ValidateMerged(Element& trg, const Element& src, const Transaction& tx, const HeightRange& hr, const AmountBig::Type& fees, Amount& feeReserve)
+{
+    // Fast path: both txs were validated against the current tip, and consist of std kernels only (no shielded, assets, contracts).
+    // Then only the conflicts between them should be tested: inputs spent by both, and duplicated kernels.
+    NodeProcessor& p = get_ParentObj().m_Processor;
+    const Block::SystemState::ID& idTip = p.m_Cursor.m_ID;
+
+    bool bFast =
+        (trg.m_CtxID == idTip) &&
+        (src.m_CtxID == idTip) &&
+        hr.IsInRange(idTip.m_Height + 1);
+
+    std::vector<Merkle::Hash> vKrnIDs;
+    if (bFast)
+    {
+        vKrnIDs.reserve(tx.m_vKernels.size());
+
+        for (size_t i = 0; i < tx.m_vKernels.size(); i++)
+        {
+            const TxKernel& krn = *tx.m_vKernels[i];
+            if ((TxKernel::Subtype::Std != krn.get_Subtype()) || !krn.m_vNested.empty())
+            {
+                bFast = false;
+                break;
+            }
+
+            vKrnIDs.push_back(krn.m_Internal.m_ID);
+        }
+    }
+
+    if (!bFast)
+    {
+        if (!ValidateTxContext(tx, hr, fees, feeReserve))
+            return false;
+
+        trg.m_CtxID = idTip;
+        return true;
+    }
+
+    std::sort(vKrnIDs.begin(), vKrnIDs.end());
+    if (std::adjacent_find(vKrnIDs.begin(), vKrnIDs.end()) != vKrnIDs.end())
+        return false; // duplicated kernel
+
+    // the inputs are sorted. Only the repeating ones need to be re-tested
+    for (size_t i = 0; i < tx.m_vInputs.size(); )
+    {
+        const ECC::Point& comm = tx.m_vInputs[i]->m_Commitment;
+
+        Input::Count nCount = 1;
+        for (i++; (i < tx.m_vInputs.size()) && (tx.m_vInputs[i]->m_Commitment == comm); i++)
+            nCount++;
+
+        if ((nCount > 1) && !p.ValidateInputs(comm, nCount))
+            return false;
+    }
+
+    TxStats s;
+    tx.get_Reader().AddStats(s);
+    CalculateFeeReserve(s, hr, fees, 0, feeReserve);
+
+    m_Stats.m_MergedFast++;
+    return true;
+}
+
 bool Node::Dandelion::ValidateTxContext(const Transaction& tx, const HeightRange& hr, const AmountBig::Type& fees, Amount& feeReserve)
 {
     uint32_t nBvmCharge = 0;
@@ -2913,6 +3660,7 @@ void Node::Peer::OnChocking()
 	if (!(Flags::Chocking & m_Flags))
 	{
 		m_Flags |= Flags::Chocking;
+		m_Quality.m_PingsSent.push_back(false);
 		Send(proto::Ping(Zero));
 	}
 }
@@ -2978,11 +3726,10 @@ void Node::Peer::BroadcastBbs()
 
 	size_t nExtra = 0;
 
-	NodeDB& db = m_This.m_Processor.get_DB();
-	NodeDB::WalkerBbsLite wlk;
+	BbsStore::WalkerSeq wlk;
 
 	wlk.m_ID = m_CursorBbs;
-	for (db.EnumAllBbsSeq(wlk); wlk.MoveNext(); )
+	for (m_This.m_Bbs.m_Store.EnumAllSeq(wlk); wlk.MoveNext(); )
 	{
 		proto::BbsHaveMsg msgOut;
 		msgOut.m_Key = wlk.m_Key;
@@ -3207,6 +3954,92 @@ void Node::Peer::OnMsg(proto::GetProofUtxo&& msg)
     Send(t.m_Msg);
 }
 
+void Node::Peer::OnMsg(proto::GetProofUtxoMulti&& msg)
+{
+	if (msg.m_Utxos.size() > proto::g_ProofMultiMax)
+		ThrowUnexpected();
+
+	struct Traveler :public UtxoTree::ITraveler
+	{
+		std::vector<Input::Proof>* m_pRes;
+		NodeProcessor& m_Proc;
+
+		virtual bool OnLeaf(const RadixTree::Leaf& x) override {
+
+			const UtxoTree::MyLeaf& v = Cast::Up<UtxoTree::MyLeaf>(x);
+			UtxoTree::Key::Data d;
+			d = v.m_Key;
+
+			Input::Proof& ret = m_pRes->emplace_back();
+
+			ret.m_State.m_Count = v.get_Count();
+			ret.m_State.m_Maturity = d.m_Maturity;
+			m_Proc.get_Utxos().get_Proof(ret.m_Proof, *m_pCu); // the common tail is sent once
+
+			return m_pRes->size() < Input::Proof::s_EntriesMax;
+		}
+
+		Traveler(NodeProcessor& np) :m_Proc(np) {}
+	};
+
+	proto::ProofUtxoMulti msgOut;
+
+	Processor& p = m_This.m_Processor;
+	if (!p.IsFastSync())
+	{
+		msgOut.m_Proofs.resize(msg.m_Utxos.size());
+
+		Traveler t(p);
+		UtxoTree::Cursor cu;
+		t.m_pCu = &cu;
+
+		for (size_t i = 0; i < msg.m_Utxos.size(); i++)
+		{
+			t.m_pRes = &msgOut.m_Proofs[i];
+
+			UtxoTree::Key kMin, kMax;
+
+			UtxoTree::Key::Data d;
+			d.m_Commitment = msg.m_Utxos[i];
+			d.m_Maturity = 0;
+			kMin = d;
+			d.m_Maturity = Height(-1);
+			kMax = d;
+
+			t.m_pBound[0] = kMin.V.m_pData;
+			t.m_pBound[1] = kMax.V.m_pData;
+
+			p.get_Utxos().Traverse(t);
+		}
+
+		struct MyProofBuilder
+			:public NodeProcessor::ProofBuilder
+		{
+			using ProofBuilder::ProofBuilder;
+			virtual bool get_Utxos(Merkle::Hash&) override { return false; }
+		};
+
+		MyProofBuilder pb(p, msgOut.m_Tail);
+		pb.GenerateProof();
+	}
+
+	Send(msgOut);
+}
+
+void Node::Peer::OnMsg(proto::GetProofKernelMulti&& msg)
+{
+	if (msg.m_IDs.size() > proto::g_ProofMultiMax)
+		ThrowUnexpected();
+
+	proto::ProofKernelMulti msgOut;
+
+	Processor& p = m_This.m_Processor;
+	if (!p.IsFastSync())
+		p.get_ProofKernels(msgOut.m_Heights, msgOut.m_Blocks, msg.m_IDs);
+
+	Send(msgOut);
+}
+
 void Node::Processor::GenerateProofShielded(Merkle::Proof& p, const uintBigFor<TxoID>::Type& mmrIdx)
 {
     TxoID nIdx;
@@ -3387,6 +4220,68 @@ void Node::Peer::OnMsg(proto::GetProofChainWork&& msg)
     Send(msgOut);
 }
 
+void Node::MaybeRequestHdrAnchors(Peer& p)
+{
+    if ((m_Cfg.m_HdrSync.m_MaxPacks <= 1) || m_HdrAnchors.m_pPeer || !m_Processor.IsTreasuryHandled())
+        return;
+
+    Height h0 = std::max(m_Processor.m_Cursor.m_ID.m_Height, m_HdrAnchors.m_hDone);
+    if (p.m_Tip.m_Height < h0 + m_Cfg.m_HdrSync.m_MinGap)
+        return;
+
+    proto::GetProofChainWork msg;
+    msg.m_LowerBound = m_Processor.m_Cursor.m_Full.m_ChainWork; // states below are irrelevant
+    p.Send(msg);
+
+    p.m_Flags |= Peer::Flags::HdrAnchors;
+    m_HdrAnchors.m_pPeer = &p;
+
+    LOG_INFO() << "Requesting hdr anchors from " << p.m_RemoteAddr;
+}
+
+void Node::Peer::OnMsg(proto::ProofChainWork&& msg)
+{
+    if (!(Flags::HdrAnchors & m_Flags))
+        ThrowUnexpected();
+
+    assert(this == m_This.m_HdrAnchors.m_pPeer);
+    m_This.m_HdrAnchors.m_pPeer = nullptr;
+    m_Flags &= ~Flags::HdrAnchors;
+
+    if (msg.m_Proof.IsEmpty())
+        return; // the peer can't provide it atm (i.e. it's in fast-sync mode)
+
+    if (!msg.m_Proof.IsValid())
+        ThrowUnexpected();
+
+    if (m_pInfo)
+        m_This.OnHdrAnchors(msg.m_Proof, *this);
+}
+
+void Node::OnHdrAnchors(const Block::ChainWorkProof& cwp, Peer& p)
+{
+    // All the embedded states are already verified (PoW and the MMR inclusion wrt the tip).
+    // Each accepted state without the known predecessor becomes a separate congestion tip, and the gap below it is requested independently.
+    std::vector<Block::SystemState::Full> v;
+    cwp.UnpackStates(v);
+
+    uint32_t nAccepted = 0;
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        Block::SystemState::ID id;
+        if (NodeProcessor::DataStatus::Accepted == m_Processor.OnStateSilent(v[i], p.m_pInfo->m_ID.m_Key, id, true))
+            nAccepted++;
+    }
+
+    if (!v.empty())
+        std::setmax(m_HdrAnchors.m_hDone, v.back().m_Height);
+
+    LOG_INFO() << "Hdr anchors received from " << p.m_RemoteAddr << ": " << v.size() << ", new: " << nAccepted;
+
+    if (nAccepted)
+        RefreshCongestions();
+}
+
 void Node::Peer::OnMsg(proto::PeerInfoSelf&& msg)
 {
     m_Port = msg.m_Port;
@@ -3407,16 +4302,6 @@ void Node::Peer::OnMsg(proto::GetExternalAddr&& msg)
 
 void Node::Peer::OnMsg(proto::BbsMsg&& msg)
 {
-	if ((m_This.m_Processor.m_Cursor.m_ID.m_Height >= Rules::get().pForks[1].m_Height) && !Rules::get().FakePoW)
-	{
-		// test the hash
-		ECC::Hash::Value hv;
-		proto::Bbs::get_Hash(hv, msg);
-
-        if (!proto::Bbs::IsHashValid(hv))
-			return; // drop
-    }
-
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
@@ -3434,60 +4319,208 @@ void Node::Peer::OnMsg(proto::BbsMsg&& msg)
     if (msg.m_TimePosted + Rules::get().DA.MaxAhead_s < m_This.m_Bbs.m_HighestPosted_s)
         return; // don't allow too much out-of-order messages
 
-    NodeDB& db = m_This.m_Processor.get_DB();
-    NodeDB::WalkerBbs wlk;
+    m_This.m_Bbs.m_Verifier.Push(std::move(msg), *this);
+}
+
+bool Node::Bbs::Verifier::Pending::operator < (const Pending& x) const
+{
+    if (m_Msg.m_Channel != x.m_Msg.m_Channel)
+        return (m_Msg.m_Channel < x.m_Msg.m_Channel);
+    if (m_Msg.m_TimePosted != x.m_Msg.m_TimePosted)
+        return (m_Msg.m_TimePosted < x.m_Msg.m_TimePosted);
+
+    int n = m_Msg.m_Nonce.cmp(x.m_Msg.m_Nonce);
+    if (n)
+        return (n < 0);
+
+    return (m_Msg.m_Message.size() < x.m_Msg.m_Message.size());
+}
+
+struct Node::Bbs::Verifier::Task
+    :public Executor::TaskAsync
+{
+    Verifier* m_pThis;
+    Pending* m_pPending;
+
+    virtual void Exec(Executor::Context&) override
+    {
+        Pending& p = *m_pPending;
+        const proto::BbsMsg& msg = p.m_Msg;
+
+        p.m_bValid = true;
+        if (p.m_bCheckPoW)
+        {
+            ECC::Hash::Value hv;
+            proto::Bbs::get_Hash(hv, msg);
+            p.m_bValid = proto::Bbs::IsHashValid(hv);
+        }
+
+        if (p.m_bValid)
+        {
+            BbsStore::Data d;
+            d.m_Channel = msg.m_Channel;
+            d.m_Message = Blob(msg.m_Message);
+
+            CalcMsgKey(d);
+            p.m_Key = d.m_Key;
+        }
+
+        bool bWasEmpty;
+        {
+            std::unique_lock<std::mutex> scope(m_pThis->m_MutexDone);
+            bWasEmpty = m_pThis->m_vDone.empty();
+            m_pThis->m_vDone.push_back(m_pPending);
+        }
+
+        if (bWasEmpty)
+            m_pThis->m_pEvtDone->post();
+    }
+};
+
+Node::Bbs::Verifier::~Verifier()
+{
+    // the worker threads are stopped by now
+    m_setPending.clear_and_dispose([](Pending* p) { delete p; });
+}
+
+void Node::Bbs::Verifier::Push(proto::BbsMsg&& msg, Peer& src)
+{
+    Node& n = get_ParentObj().get_ParentObj();
+    if (src.m_nBbsPending >= n.m_Cfg.m_Bbs.m_MaxPendingVerifyPerPeer)
+        return; // this peer floods
+
+    if (m_setPending.size() >= n.m_Cfg.m_Bbs.m_MaxPendingVerify)
+        return; // flood
+
+    std::unique_ptr<Pending> pGuard(new Pending);
+    Pending& p = *pGuard;
+    p.m_Msg = std::move(msg);
+
+    // drop an identical copy that is already being verified
+    for (auto range = m_setPending.equal_range(p); range.first != range.second; ++range.first)
+        if (range.first->m_Msg.m_Message == p.m_Msg.m_Message)
+            return;
+
+    p.m_pPeer = &src;
+    p.m_bCheckPoW = (n.m_Processor.m_Cursor.m_ID.m_Height >= Rules::get().pForks[1].m_Height) && !Rules::get().FakePoW;
+    p.m_bValid = false;
+    p.m_bDone = false;
+
+    std::unique_ptr<Task> pTask(new Task);
+    pTask->m_pThis = this;
+    pTask->m_pPending = &p;
+
+    m_setPending.insert(*pGuard.release());
+    m_queOrder.push_back(&p);
+    src.m_nBbsPending++;
+
+    n.m_Processor.m_ExecutorBg.Push(std::move(pTask));
+}
+
+void Node::Bbs::Verifier::OnPeerDeleted(Peer& peer)
+{
+    if (!peer.m_nBbsPending)
+        return;
+
+    for (PendingSet::iterator it = m_setPending.begin(); m_setPending.end() != it; ++it)
+        if (&peer == it->m_pPeer)
+            it->m_pPeer = nullptr;
+
+    peer.m_nBbsPending = 0;
+}
+
+void Node::Bbs::Verifier::OnDone()
+{
+    std::vector<Pending*> v;
+    {
+        std::unique_lock<std::mutex> scope(m_MutexDone);
+        v.swap(m_vDone);
+    }
+
+    for (size_t i = 0; i < v.size(); i++)
+        v[i]->m_bDone = true;
+
+    while (!m_queOrder.empty() && m_queOrder.front()->m_bDone)
+    {
+        std::unique_ptr<Pending> pGuard(m_queOrder.front());
+        m_queOrder.pop_front();
+        Pending& p = *pGuard;
+
+        m_setPending.erase(PendingSet::s_iterator_to(p));
+        if (p.m_pPeer)
+            p.m_pPeer->m_nBbsPending--;
 
-    wlk.m_Data.m_Channel = msg.m_Channel;
-    wlk.m_Data.m_TimePosted = msg.m_TimePosted;
-    wlk.m_Data.m_Message = Blob(msg.m_Message);
-	msg.m_Nonce.Export(wlk.m_Data.m_Nonce);
+        if (p.m_bValid)
+            get_ParentObj().OnMsgVerified(p.m_Msg, p.m_Key, p.m_pPeer);
+    }
 
-    Bbs::CalcMsgKey(wlk.m_Data);
+    get_ParentObj().m_Store.Flush(); // once per batch
+}
 
-    if (db.BbsFind(wlk.m_Data.m_Key))
+void Node::Bbs::OnMsgVerified(const proto::BbsMsg& msg, const BbsStore::Key& key, Peer* pSrc)
+{
+    Node& n = get_ParentObj();
+
+    if (m_Store.Find(key))
         return; // already have it
 
-    m_This.m_Bbs.MaybeCleanup();
+    BbsStore::Data d;
 
-    uint64_t id = db.BbsIns(wlk.m_Data);
-    m_This.m_Bbs.m_W.Delete(wlk.m_Data.m_Key);
+    d.m_Key = key;
+    d.m_Channel = msg.m_Channel;
+    d.m_TimePosted = msg.m_TimePosted;
+    d.m_Message = Blob(msg.m_Message);
+	msg.m_Nonce.Export(d.m_Nonce);
 
-	std::setmax(m_This.m_Bbs.m_HighestPosted_s, msg.m_TimePosted);
-	m_This.m_Bbs.m_Totals.m_Count++;
-	m_This.m_Bbs.m_Totals.m_Size += wlk.m_Data.m_Message.n;
+    MaybeCleanup();
 
-    // 1. Send to other BBS-es
+    uint64_t id = m_Store.Insert(d);
+    m_W.Delete(key);
 
-    proto::BbsHaveMsg msgOut;
-    msgOut.m_Key = wlk.m_Data.m_Key;
+	std::setmax(m_HighestPosted_s, msg.m_TimePosted);
 
-    for (PeerList::iterator it = m_This.m_lstPeers.begin(); m_This.m_lstPeers.end() != it; ++it)
+    // Both the announcement and the message itself are serialized once (on-demand), and shared by all the recipients
+    proto::NodeConnection::SharedMsg smHave, smMsg;
+
+    // 1. Send to other BBS-es
+
+    for (PeerList::iterator it = n.m_lstPeers.begin(); n.m_lstPeers.end() != it; ++it)
     {
         Peer& peer = *it;
-        if (this == &peer)
+        if (pSrc == &peer)
             continue;
 
         if (!(peer.m_LoginFlags & proto::LoginFlags::Bbs) || peer.IsChocking())
             continue;
 
-        peer.Send(msgOut);
+        if (smHave.IsEmpty())
+        {
+            proto::BbsHaveMsg msgOut;
+            msgOut.m_Key = d.m_Key;
+            smHave.Set(msgOut);
+        }
+
+        peer.SendShared(smHave);
     }
 
     // 2. Send to subscribed
-    typedef Bbs::Subscription::BbsSet::iterator It;
+    typedef Subscription::BbsSet::iterator It;
 
-    Bbs::Subscription::InBbs key;
-    key.m_Channel = msg.m_Channel;
+    Subscription::InBbs keySub;
+    keySub.m_Channel = msg.m_Channel;
 
-    for (std::pair<It, It> range = m_This.m_Bbs.m_Subscribed.equal_range(key); range.first != range.second; range.first++)
+    for (std::pair<It, It> range = m_Subscribed.equal_range(keySub); range.first != range.second; range.first++)
     {
-        Bbs::Subscription& s = range.first->get_ParentObj();
+        Subscription& s = range.first->get_ParentObj();
 		assert(s.m_Cursor < id);
 
         if (s.m_pPeer->IsChocking())
             continue;
 
-        s.m_pPeer->SendBbsMsg(wlk.m_Data);
+        if (smMsg.IsEmpty())
+            smMsg.Set(msg);
+
+        s.m_pPeer->SendShared(smMsg);
 		s.m_Cursor = id;
 
 		s.m_pPeer->IsChocking(); // in case it's chocking - for faster recovery recheck it ASAP
@@ -3499,8 +4532,7 @@ void Node::Peer::OnMsg(proto::BbsHaveMsg&& msg)
     if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-    NodeDB& db = m_This.m_Processor.get_DB();
-	if (db.BbsFind(msg.m_Key)) {
+	if (m_This.m_Bbs.m_Store.Find(msg.m_Key)) {
 		// stupid compiler insists on parentheses here!
 		return; // already have it
 	}
@@ -3520,17 +4552,16 @@ void Node::Peer::OnMsg(proto::BbsGetMsg&& msg)
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-	NodeDB& db = m_This.m_Processor.get_DB();
-    NodeDB::WalkerBbs wlk;
+    BbsStore::Data d;
+    ByteBuffer buf;
 
-    wlk.m_Data.m_Key = msg.m_Key;
-    if (!db.BbsFind(wlk))
+    if (!m_This.m_Bbs.m_Store.Find(msg.m_Key, d, buf))
         return; // don't have it
 
-    SendBbsMsg(wlk.m_Data);
+    SendBbsMsg(d);
 }
 
-void Node::Peer::SendBbsMsg(const NodeDB::WalkerBbs::Data& d)
+void Node::Peer::SendBbsMsg(const BbsStore::Data& d)
 {
 	proto::BbsMsg msgOut;
 	msgOut.m_Channel = d.m_Channel;
@@ -3562,7 +4593,7 @@ void Node::Peer::OnMsg(proto::BbsSubscribe&& msg)
         m_This.m_Bbs.m_Subscribed.insert(pS->m_Bbs);
         m_Subscriptions.insert(pS->m_Peer);
 
-		pS->m_Cursor = m_This.m_Processor.get_DB().BbsFindCursor(msg.m_TimeFrom) - 1;
+		pS->m_Cursor = m_This.m_Bbs.m_Store.FindCursor(msg.m_TimeFrom) - 1;
 
 		BroadcastBbs(*pS);
     }
@@ -3575,13 +4606,12 @@ void Node::Peer::BroadcastBbs(Bbs::Subscription& s)
 	if (IsChocking())
 		return;
 
-	NodeDB& db = m_This.m_Processor.get_DB();
-	NodeDB::WalkerBbs wlk;
+	BbsStore::WalkerChannel wlk;
 
 	wlk.m_Data.m_Channel = s.m_Peer.m_Channel;
 	wlk.m_ID = s.m_Cursor;
 
-	for (db.EnumBbsCSeq(wlk); wlk.MoveNext(); )
+	for (m_This.m_Bbs.m_Store.EnumChannelSeq(wlk); wlk.MoveNext(); )
 	{
 		SendBbsMsg(wlk.m_Data);
 		if (IsChocking())
@@ -3596,7 +4626,7 @@ void Node::Peer::OnMsg(proto::BbsResetSync&& msg)
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-	m_CursorBbs = m_This.m_Processor.get_DB().BbsFindCursor(msg.m_TimeFrom) - 1;
+	m_CursorBbs = m_This.m_Bbs.m_Store.FindCursor(msg.m_TimeFrom) - 1;
 	BroadcastBbs();
 }
 
@@ -3892,6 +4922,401 @@ void Node::Server::OnAccepted(io::TcpStream::Ptr&& newStream, int errorCode)
     }
 }
 
+/////////////////////////////
+// NetThreads
+template <typename Fn>
+void Node::NetThreads::Queue::PushFn(Fn&& fn)
+{
+    struct TaskFn
+        :public Task
+    {
+        Fn m_Fn;
+        TaskFn(Fn&& fn) :m_Fn(std::move(fn)) {}
+        virtual void Exec() override { m_Fn(); }
+    };
+
+    Push(new TaskFn(std::move(fn)));
+}
+
+void Node::NetThreads::Queue::Push(Task* p)
+{
+    p->m_pNext = m_pHead.load(std::memory_order_relaxed);
+    while (!m_pHead.compare_exchange_weak(p->m_pNext, p, std::memory_order_release, std::memory_order_relaxed))
+        ;
+
+    if (!p->m_pNext)
+        m_pEvt->post(); // was empty
+}
+
+void Node::NetThreads::Queue::Process()
+{
+    while (true)
+    {
+        Task* p = m_pHead.exchange(nullptr, std::memory_order_acquire);
+        if (!p)
+            break;
+
+        // reverse, to process in the order of arrival
+        Task* pFirst = nullptr;
+        while (p)
+        {
+            Task* pNext = p->m_pNext;
+            p->m_pNext = pFirst;
+            pFirst = p;
+            p = pNext;
+        }
+
+        while (pFirst)
+        {
+            std::unique_ptr<Task> pGuard(pFirst);
+            pFirst = pFirst->m_pNext;
+            pGuard->Exec();
+        }
+    }
+}
+
+void Node::NetThreads::Queue::Clear()
+{
+    for (Task* p = m_pHead.exchange(nullptr); p; )
+    {
+        std::unique_ptr<Task> pGuard(p);
+        p = p->m_pNext;
+    }
+}
+
+struct Node::NetThreads::Thread
+    :public PerThread
+{
+    NetThreads& m_Owner;
+    Queue m_Queue; // to this thread
+
+    // accessed by this thread only (after start)
+    io::TcpServer::Ptr m_pServer;
+    std::set<std::shared_ptr<Link> > m_setLinks;
+
+    Thread(NetThreads& x) :m_Owner(x) {}
+
+    void Run(const Rules&);
+    void OnAccepted(io::TcpStream::Ptr&&, io::ErrorCode);
+    void OnStop();
+};
+
+struct Node::NetThreads::Link
+    :public proto::NodeConnection::IRelay
+    ,public std::enable_shared_from_this<Link>
+{
+    Thread& m_Thread;
+
+    std::atomic<size_t> m_Queued; // posted by the main thread, not yet written
+    std::atomic<size_t> m_Unsent; // last known unsent of the connection
+
+    // main thread
+    Peer* m_pPeer = nullptr;
+
+    // transport thread
+    struct Transport
+        :public proto::NodeConnection
+    {
+        Link& m_Link;
+        bool m_Dead = false;
+
+        Transport(Link& x) :m_Link(x) {}
+
+        void UpdateUnsent()
+        {
+            m_Link.m_Unsent.store(get_Unsent(), std::memory_order_relaxed);
+        }
+
+        template <typename T>
+        bool Forward(T&& msg)
+        {
+            if (m_Dead)
+                return false;
+
+            UpdateUnsent();
+
+            std::shared_ptr<Link> pLink = m_Link.shared_from_this();
+            m_Link.m_Thread.m_Owner.m_Queue.PushFn([pLink, msg = std::move(msg)]() mutable
+            {
+                if (pLink->m_pPeer)
+                    pLink->m_pPeer->OnMsgSafe(std::move(msg));
+            });
+
+            return true;
+        }
+
+        // the secure channel is handled here
+        bool Forward(proto::SChannelInitiate&& msg)
+        {
+            OnMsg(std::move(msg));
+            return true;
+        }
+
+        bool Forward(proto::SChannelReady&& msg)
+        {
+            OnMsg(std::move(msg));
+            return true;
+        }
+
+#define THE_MACRO(code, msg) \
+        virtual bool OnMsg2(proto::msg&& v) override \
+        { \
+            return Forward(std::move(v)); \
+        }
+        BeamNodeMsgsAll(THE_MACRO)
+#undef THE_MACRO
+
+        virtual void OnConnectedSecure() override;
+        virtual void OnDisconnect(const DisconnectReason&) override;
+
+        virtual void OnReadPaused(bool) override
+        {
+            UpdateUnsent();
+        }
+    };
+
+    std::unique_ptr<Transport> m_pTransport;
+
+    Link(Thread& t)
+        :m_Thread(t)
+        ,m_Queued(0)
+        ,m_Unsent(0)
+    {
+    }
+
+    // IRelay, main thread
+    virtual void Write(SerializedMsg&& sm) override
+    {
+        size_t nSize = 0;
+        for (const auto& x : sm)
+            nSize += x.size;
+
+        m_Queued.fetch_add(nSize, std::memory_order_relaxed);
+
+        std::shared_ptr<Link> pLink = shared_from_this();
+        m_Thread.m_Queue.PushFn([pLink, nSize, sm = std::move(sm)]() mutable
+        {
+            if (pLink->m_pTransport)
+            {
+                pLink->m_pTransport->WriteFinalized(sm);
+                pLink->m_pTransport->UpdateUnsent();
+            }
+            pLink->m_Queued.fetch_sub(nSize, std::memory_order_relaxed);
+        });
+    }
+
+    virtual size_t get_Unsent() const override
+    {
+        return m_Queued.load(std::memory_order_relaxed) + m_Unsent.load(std::memory_order_relaxed);
+    }
+
+    virtual void Close() override
+    {
+        m_pPeer = nullptr;
+
+        std::shared_ptr<Link> pLink = shared_from_this();
+        m_Thread.m_Queue.PushFn([pLink]()
+        {
+            pLink->m_pTransport.reset();
+            pLink->m_Thread.m_setLinks.erase(pLink);
+        });
+    }
+};
+
+void Node::NetThreads::Link::Transport::OnConnectedSecure()
+{
+    ECC::Scalar::Native skMy;
+    PeerID pidRemote;
+    get_SChannelNonces(skMy, pidRemote);
+
+    std::shared_ptr<Link> pLink = m_Link.shared_from_this();
+    m_Link.m_Thread.m_Owner.m_Queue.PushFn([pLink, skMy, pidRemote]()
+    {
+        Peer* p = pLink->m_pPeer;
+        if (p)
+        {
+            p->SetSecureRelayed(skMy, pidRemote);
+            p->OnConnectedSecure();
+        }
+    });
+}
+
+void Node::NetThreads::Link::Transport::OnDisconnect(const DisconnectReason& dr)
+{
+    if (m_Dead)
+        return;
+    m_Dead = true;
+
+    // DisconnectReason is not copyable, the error msg may be transient
+    DisconnectReason::Enum eType = dr.m_Type;
+    io::ErrorCode nIoErr = (DisconnectReason::Io == eType) ? dr.m_IoError : io::EC_OK;
+    ProtocolError eProto = (DisconnectReason::Protocol == eType) ? dr.m_eProtoCode : ProtocolError();
+    uint8_t nBye = (DisconnectReason::Bye == eType) ? dr.m_ByeReason : 0;
+    proto::NodeProcessingException::Type eExc = proto::NodeProcessingException::Type::Base;
+    std::string sErr;
+
+    if (DisconnectReason::ProcessingExc == eType)
+    {
+        eExc = dr.m_ExceptionDetails.m_ExceptionType;
+        if (dr.m_ExceptionDetails.m_szErrorMsg)
+            sErr = dr.m_ExceptionDetails.m_szErrorMsg;
+    }
+
+    std::shared_ptr<Link> pLink = m_Link.shared_from_this();
+    m_Link.m_Thread.m_Owner.m_Queue.PushFn([pLink, eType, nIoErr, eProto, nBye, eExc, sErr]()
+    {
+        Peer* p = pLink->m_pPeer;
+        if (!p)
+            return;
+
+        DisconnectReason r;
+        r.m_Type = eType;
+
+        switch (eType)
+        {
+        case DisconnectReason::Io: r.m_IoError = nIoErr; break;
+        case DisconnectReason::Protocol: r.m_eProtoCode = eProto; break;
+        case DisconnectReason::Bye: r.m_ByeReason = nBye; break;
+        case DisconnectReason::ProcessingExc:
+            r.m_ExceptionDetails.m_ExceptionType = eExc;
+            r.m_ExceptionDetails.m_szErrorMsg = sErr.c_str();
+            break;
+        default: // suppress warning
+            break;
+        }
+
+        p->OnDisconnect(r);
+    });
+}
+
+void Node::NetThreads::Initialize()
+{
+    const Config& cfg = get_ParentObj().m_Cfg;
+    assert(cfg.m_ListenThreads && m_vThreads.empty());
+
+    uint32_t nThreads = cfg.m_ListenThreads;
+    if ((nThreads > 1) && !io::TcpServer::is_reuse_port_supported())
+    {
+        LOG_WARNING() << "SO_REUSEPORT not supported, listen threads=1";
+        nThreads = 1;
+    }
+
+    m_Queue.m_pEvt = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { m_Queue.Process(); });
+
+    m_vThreads.resize(nThreads);
+    for (uint32_t i = 0; i < nThreads; i++)
+    {
+        m_vThreads[i] = std::make_unique<Thread>(*this);
+        Thread& t = *m_vThreads[i];
+
+        t.m_pReactor = io::Reactor::create();
+        t.m_pEvt = io::AsyncEvent::create(*t.m_pReactor, [&t]() { t.m_Queue.Process(); });
+        t.m_Queue.m_pEvt = t.m_pEvt;
+
+        // bind here, so that the errors are reported right away
+        t.m_pServer = io::TcpServer::create(*t.m_pReactor, cfg.m_Listen, [&t](io::TcpStream::Ptr&& newStream, io::ErrorCode status) {
+            t.OnAccepted(std::move(newStream), status);
+        }, nThreads > 1);
+    }
+
+    for (uint32_t i = 0; i < nThreads; i++)
+    {
+        Thread& t = *m_vThreads[i];
+        t.m_Thread = std::thread(&Thread::Run, &t, Rules::get());
+    }
+
+    LOG_INFO() << "Listen threads=" << nThreads;
+}
+
+Node::NetThreads::NetThreads()
+{
+}
+
+Node::NetThreads::~NetThreads()
+{
+    Stop();
+}
+
+void Node::NetThreads::Stop()
+{
+    for (size_t i = 0; i < m_vThreads.size(); i++)
+    {
+        Thread& t = *m_vThreads[i];
+        if (t.m_Thread.joinable())
+        {
+            // after all the pending tasks
+            t.m_Queue.PushFn([&t]() { t.OnStop(); });
+            t.m_Thread.join();
+        }
+
+        t.m_Queue.Clear();
+    }
+
+    m_vThreads.clear();
+    m_Queue.Clear();
+}
+
+void Node::NetThreads::Thread::Run(const Rules& r)
+{
+    Rules::Scope scopeRules(r);
+    io::Reactor::Scope scopeReactor(*m_pReactor);
+    m_pReactor->run();
+}
+
+void Node::NetThreads::Thread::OnStop()
+{
+    m_pServer.reset();
+
+    for (const auto& pLink : m_setLinks)
+        pLink->m_pTransport.reset();
+    m_setLinks.clear();
+
+    m_pReactor->stop();
+}
+
+void Node::NetThreads::Thread::OnAccepted(io::TcpStream::Ptr&& newStream, io::ErrorCode)
+{
+    if (!newStream)
+        return;
+
+    const Node& n = m_Owner.get_ParentObj();
+    io::Address addr = newStream->peer_address();
+
+    auto pLink = std::make_shared<Link>(*this);
+    m_setLinks.insert(pLink);
+
+    pLink->m_pTransport = std::make_unique<Link::Transport>(*pLink);
+    Link::Transport& x = *pLink->m_pTransport;
+
+    // backpressure is applied here, the drown limit is controlled by the main thread
+    x.m_UnsentPauseMark = n.m_Cfg.m_BandwidthCtl.m_PauseHi;
+    x.m_UnsentResumeMark = n.m_Cfg.m_BandwidthCtl.m_PauseLo;
+
+    m_Owner.m_Queue.PushFn([pLink, addr]() {
+        pLink->m_Thread.m_Owner.OnAccepted(pLink, addr);
+    });
+
+    x.Accept(std::move(newStream));
+
+    try {
+        x.SecureConnect();
+    }
+    catch (const std::exception& e) {
+        x.OnExc(e);
+    }
+}
+
+void Node::NetThreads::OnAccepted(const std::shared_ptr<Link>& pLink, const io::Address& addr)
+{
+    LOG_DEBUG() << "New peer connected: " << addr;
+
+    Peer* p = get_ParentObj().AllocPeer(addr);
+    p->m_Flags |= Peer::Flags::Accepted;
+
+    pLink->m_pPeer = p;
+    p->Accept(std::static_pointer_cast<proto::NodeConnection::IRelay>(pLink));
+}
+
 bool Node::Miner::IsEnabled() const 
 {
     if (!m_External.m_pSolver && m_vThreads.empty())
@@ -3925,6 +5350,7 @@ void Node::Miner::Initialize(IExternalPOW* externalPOW)
     }
 
 	m_External.m_pSolver = externalPOW;
+	ZeroObject(m_External.m_PreJobTip);
 
     SetTimer(0, true); // async start mining
 }
@@ -4118,9 +5544,14 @@ bool Node::Miner::Restart()
             return false; // wait until we receive that outdated finalization
     }
     else
+    {
         if (!keys.m_pMiner)
             return false; // offline mining is disabled
 
+        if (StartEmptyPreJob())
+            return true;
+    }
+
     NodeProcessor::BlockContext bc(
         get_ParentObj().m_TxPool,
         keys.m_nMinerSubIndex,
@@ -4162,6 +5593,44 @@ bool Node::Miner::Restart()
     return true;
 }
 
+bool Node::Miner::StartEmptyPreJob()
+{
+    // The full block template may take a while (txs selection and validation). Meanwhile let the external miner work on an empty block.
+    // It remains valid after it's superseded by the full template (they share the stop indicator).
+    if (!m_External.m_pSolver || !get_ParentObj().m_Cfg.m_MiningEmptyPreJob)
+        return false;
+
+    const Block::SystemState::ID& idTip = get_ParentObj().m_Processor.m_Cursor.m_ID;
+    if (m_External.m_PreJobTip == idTip)
+        return false; // already started, now it's time for the full template
+
+    m_External.m_PreJobTip = idTip;
+
+    if (get_ParentObj().m_TxPool.m_setProfit.empty())
+        return false; // the full template would be empty anyway
+
+    const Keys& keys = get_ParentObj().m_Keys;
+    TxPool::Fluff txpEmpty;
+
+    NodeProcessor::BlockContext bc(
+        txpEmpty,
+        keys.m_nMinerSubIndex,
+        *keys.m_pMiner,
+        keys.m_pOwner ? *keys.m_pOwner : *keys.m_pGeneric);
+
+    if (!get_ParentObj().m_Processor.GenerateNewBlock(bc))
+        return false;
+
+    Task::Ptr pTask(std::make_shared<Task>());
+    Cast::Down<NodeProcessor::GeneratedBlock>(*pTask) = std::move(bc);
+
+    LOG_INFO() << "Empty block pre-job";
+    StartMining(std::move(pTask));
+
+    SetTimer(0, true); // the full template, on the next loop iteration
+    return true;
+}
+
 void Node::Miner::StartMining(Task::Ptr&& pTask)
 {
     assert(pTask && !m_pTaskToFinalize);
@@ -4496,6 +5965,8 @@ void Node::PeerMan::Initialize()
     m_pTimerFlush = io::Timer::create(io::Reactor::get_Current());
     m_pTimerFlush->start(cfg.m_Timeout.m_PeersDbFlush_ms, true, [this]() { OnFlush(); });
 
+    std::vector<PeerInfoPlus*> vLoaded;
+
     {
         NodeDB::WalkerPeer wlk;
         for (get_ParentObj().m_Processor.get_DB().EnumPeers(wlk); wlk.MoveNext(); )
@@ -4516,6 +5987,37 @@ void Node::PeerMan::Initialize()
 
             pPi->m_LastSeen = wlk.m_Data.m_LastSeen;
             pPi->m_LastConnectAttempt = pPi->m_LastSeen;
+
+            PeerInfoPlus& pip = Cast::Up<PeerInfoPlus>(*pPi);
+            pip.m_Throughput_Bps = wlk.m_Data.m_Throughput_Bps;
+            pip.m_Latency_ms = wlk.m_Data.m_Latency_ms;
+            pip.m_Saved = wlk.m_Data;
+
+            vLoaded.push_back(&pip);
+        }
+    }
+
+    // Reconnect to the historically fastest peers right away (connections are established in parallel).
+    // The rest is up to the regular update
+    std::sort(vLoaded.begin(), vLoaded.end(), [](const PeerInfoPlus* p1, const PeerInfoPlus* p2)
+    {
+        uint32_t bw1 = p1->get_ExpectedBps();
+        uint32_t bw2 = p2->get_ExpectedBps();
+        if (bw1 != bw2)
+            return bw1 > bw2;
+
+        // unknown latency goes last
+        return (p1->m_Latency_ms - 1) < (p2->m_Latency_ms - 1);
+    });
+
+    TimePoint tp;
+    uint32_t nSelected = 0;
+    for (size_t i = 0; (i < vLoaded.size()) && (nSelected < m_Cfg.m_DesiredHighest); i++)
+    {
+        if (ActivatePeerSafe(*vLoaded[i], tp.get()))
+        {
+            LOG_INFO() << *vLoaded[i] << " reconnecting, <Bps>=" << vLoaded[i]->get_ExpectedBps() << ", RTT=" << vLoaded[i]->m_Latency_ms;
+            nSelected++;
         }
     }
 }
@@ -4524,21 +6026,33 @@ void Node::PeerMan::OnFlush()
 {
     NodeDB& db = get_ParentObj().m_Processor.get_DB();
 
-    db.PeersDel();
+    for (size_t i = 0; i < m_vDeleted.size(); i++)
+        db.PeerDel(m_vDeleted[i]);
+    m_vDeleted.clear();
 
+    // write only those that were modified since the last flush
     const PeerMan::RawRatingSet& rs = get_Ratings();
 
     for (PeerMan::RawRatingSet::const_iterator it = rs.begin(); rs.end() != it; ++it)
     {
-        const PeerMan::PeerInfo& pi = it->get_ParentObj();
+        PeerInfoPlus& pip = Cast::Up<PeerInfoPlus>(Cast::NotConst(it->get_ParentObj()));
+        if (pip.m_ID.m_Key == Zero)
+            continue; // anonymous
 
         NodeDB::WalkerPeer::Data d;
-        d.m_ID = pi.m_ID.m_Key;
-        d.m_Rating = pi.m_RawRating.m_Value;
-        d.m_Address = pi.m_Addr.m_Value.u64();
-        d.m_LastSeen = pi.m_LastSeen;
+        pip.get_Data(d);
+
+        const NodeDB::WalkerPeer::Data& d0 = pip.m_Saved;
+        if ((d.m_ID == d0.m_ID) &&
+            (d.m_Rating == d0.m_Rating) &&
+            (d.m_Address == d0.m_Address) &&
+            (d.m_LastSeen == d0.m_LastSeen) &&
+            (d.m_Throughput_Bps == d0.m_Throughput_Bps) &&
+            (d.m_Latency_ms == d0.m_Latency_ms))
+            continue;
 
-        db.PeerIns(d);
+        db.PeerSave(d);
+        pip.m_Saved = d;
     }
 }
 
@@ -4583,12 +6097,19 @@ PeerManager::PeerInfo* Node::PeerMan::AllocPeer()
 {
     PeerInfoPlus* p = new PeerInfoPlus;
     p->m_Live.m_p = nullptr;
+    p->m_Throughput_Bps = 0;
+    p->m_Latency_ms = 0;
+    p->m_Saved.m_ID = Zero;
     return p;
 }
 
 void Node::PeerMan::DeletePeer(PeerInfo& pi)
 {
-    delete &Cast::Up<PeerInfoPlus>(pi);
+    PeerInfoPlus& pip = Cast::Up<PeerInfoPlus>(pi);
+    if (!(pip.m_Saved.m_ID == Zero))
+        m_vDeleted.push_back(pip.m_Saved.m_ID);
+
+    delete &pip;
 }
 
 void Node::PeerMan::PeerInfoPlus::Attach(Peer& p)
@@ -4599,6 +6120,9 @@ void Node::PeerMan::PeerInfoPlus::Attach(Peer& p)
 
 	PeerManager::TimePoint tp;
 	p.m_This.m_PeerMan.m_LiveSet.insert(m_Live);
+
+	if (m_Latency_ms && !p.m_Quality.m_Srtt_ms)
+		p.m_Quality.OnRtt(m_Latency_ms); // initial estimate, until it's measured
 }
 
 void Node::PeerMan::PeerInfoPlus::DetachStrict()
@@ -4611,6 +6135,24 @@ void Node::PeerMan::PeerInfoPlus::DetachStrict()
 	m_Live.m_p = nullptr;
 }
 
+void Node::PeerMan::PeerInfoPlus::get_Data(NodeDB::WalkerPeer::Data& d) const
+{
+	d.m_ID = m_ID.m_Key;
+	d.m_Rating = m_RawRating.m_Value;
+	d.m_Address = m_Addr.m_Value.u64();
+	d.m_LastSeen = m_LastSeen;
+	d.m_Throughput_Bps = m_Throughput_Bps;
+	d.m_Latency_ms = m_Latency_ms;
+}
+
+uint32_t Node::PeerMan::PeerInfoPlus::get_ExpectedBps() const
+{
+	if (!m_RawRating.m_Value)
+		return 0; // banned
+
+	return m_Throughput_Bps ? m_Throughput_Bps : PeerManager::Rating::ToBps(m_RawRating.m_Value);
+}
+
 bool Node::GenerateRecoveryInfo(const char* szPath)
 {
 	if (!m_Processor.BuildCwp())
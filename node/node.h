@@ -15,6 +15,7 @@
 #pragma once
 
 #include "processor.h"
+#include "bbs_store.h"
 #include "utility/io/timer.h"
 #include "core/proto.h"
 #include "core/block_crypt.h"
@@ -23,6 +24,7 @@
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <condition_variable>
+#include <atomic>
 #include <pow/external_pow.h>
 
 namespace beam
@@ -68,12 +70,35 @@ struct Node
 			uint32_t m_TopPeersUpd_ms = 1000 * 60 * 10; // once in 10 minutes
 			uint32_t m_PeersUpdate_ms	= 1000; // reconsider every second
 			uint32_t m_PeersDbFlush_ms = 1000 * 60; // 1 minute
+
+			// Request timeouts are adapted per peer, wrt its RTT and bandwidth. The above GetState/GetBlock values are the upper bounds
+			uint32_t m_RequestMin_ms = 1000 * 5;
+			uint32_t m_RttProbe_ms = 1000 * 30; // RTT is re-measured (by ping, when the peer has no pending requests) not more often than this
 		} m_Timeout;
 
 		uint32_t m_MaxConcurrentBlocksRequest = 18;
+
+		// New blocks are requested in a compact form (element IDs only), and restored from the tx pool. Only the missing elements are downloaded.
+		bool m_CompactBlocks = false;
+
+		// Number of reactors that accept and handle the inbound connections (transport only). 0: the main reactor does it all.
+		// Requires SO_REUSEPORT for more than 1.
+		uint32_t m_ListenThreads = 0;
+
+		struct HdrSync
+		{
+			// Parallel headers download. If a peer tip is far ahead - its ChainWorkProof is requested first, the embedded (verified) states
+			// are used as anchors, and the gaps between them are downloaded concurrently as independent HdrPacks from different peers.
+			uint32_t m_MaxPacks = 1; // max hdr packs in-flight. 1 means sequential mode (anchors not used)
+			Height m_MinGap = proto::g_HdrPackMaxSize * 4; // anchors are requested only if the peer tip is that far ahead
+
+		} m_HdrSync;
+
 		uint32_t m_MaxPoolTransactions = 100 * 1000;
+		uint64_t m_MaxPoolSize = uint64_t(512) * 1024U * 1024U; // estimated memory of the tx pool. The lowest fee-rate txs are evicted above it
 		uint32_t m_MaxDeferredTransactions = 100 * 1000;
 		uint32_t m_MiningThreads = 0; // by default disabled
+		bool m_MiningEmptyPreJob = true; // on a new tip send an empty-block job to the external miner at once, replaced by the full template when it's ready
 
 		bool m_LogEvents = false; // may be insecure. Off by default.
 		bool m_LogTxStem = true;
@@ -84,6 +109,9 @@ struct Node
 		// negative: number of cores minus number of mining threads.
 		int m_VerificationThreads = 0;
 
+		// Threads for the background jobs (BBS messages verification, Dandelion dummy outputs). They run on a separate executor, so that the block processing never waits for them
+		uint32_t m_BackgroundThreads = 1;
+
 		struct RollbackLimit
 		{
 			Height m_Max = 60; // artificial restriction on how much the node will rollback automatically
@@ -97,7 +125,7 @@ struct Node
 			uint32_t m_MessageTimeout_s = 3600 * 12; // 1/2 day
 			uint32_t m_CleanupPeriod_ms = 3600 * 1000; // 1 hour
 
-			NodeDB::BbsTotals m_Limit;
+			BbsStore::Totals m_Limit;
 
 			Bbs()
 			{
@@ -111,16 +139,32 @@ struct Node
 
 			bool IsEnabled() const { return m_Limit.m_Count > 0; }
 
+			BbsStore::Params m_Store; // messages are kept in a segmented log, next to the DB
+
+			uint32_t m_MaxPendingVerify = 4096; // incoming messages being verified, total (a backstop). Excess messages are dropped (they are re-requested from other peers)
+			uint32_t m_MaxPendingVerifyPerPeer = 256; // same, per peer. So that a flooding peer doesn't block the messages from others
+
+
 		} m_Bbs;
 
 		struct BandwidthCtl
 		{
-			size_t m_Chocking = 1024 * 1024;
-			size_t m_Drown    = 1024*1024 * 20;
+			size_t m_Chocking = 1024 * 1024; // broadcasts to the peer are paused above this
+			size_t m_Drown    = 1024*1024 * 20; // hard limit of the unsent data
+			bool m_DrownDrop = false; // above the hard limit drop messages to the peer, instead of disconnecting
+
+			// Requests from the peer are not read while the unsent data is above the high mark, until it's drained to the low mark
+			size_t m_PauseHi = 1024*1024 * 4;
+			size_t m_PauseLo = 1024 * 1024;
+			uint32_t m_PauseMax_ms = 1000 * 60; // the peer is disconnected if it doesn't drain in time
 
 			size_t m_MaxBodyPackSize = 1024 * 1024 * 5;
 			uint32_t m_MaxBodyPackCount = 3000;
 
+			// Pipelining: requests in flight to a peer are limited to what it's expected to deliver within this window (wrt its bandwidth)
+			uint32_t m_PipelineWindow_ms = 1000 * 5;
+			uint32_t m_PipelineMax = 8;
+
 		} m_BandwidthCtl;
 
 		struct TestMode {
@@ -145,6 +189,7 @@ struct Node
 			// dummy creation strategy
 			uint32_t m_DummyLifetimeLo = 720;
 			uint32_t m_DummyLifetimeHi = 1440 * 7; // set to 0 to disable
+			uint32_t m_DummyPoolSize = 20; // dummy outputs pre-generated in background. Set to 0 to create them on-demand
 
 		} m_Dandelion;
 
@@ -182,6 +227,31 @@ struct Node
 	void Initialize(IExternalPOW* externalPOW=nullptr);
 
 	NodeProcessor& get_Processor() { return m_Processor; } // for tests only!
+	Executor& get_ExecutorBg() { return m_Processor.m_ExecutorBg; } // for tests only!
+
+	struct DandelionStats
+	{
+		uint64_t m_Aggregated = 0; // txs that finished the aggregation
+		uint64_t m_Merged = 0; // txs merged into others
+		uint64_t m_MergedFast = 0; // of which without the full context re-validation
+		uint64_t m_DummiesGenerated = 0; // dummy outputs pre-generated in background
+		uint64_t m_DummiesPooled = 0; // dummy outputs taken from the pool
+		uint64_t m_DummiesInline = 0; // dummy outputs created on-demand
+		uint64_t m_DummiesDropped = 0; // pooled dummy outputs discarded, since the tip moved to another fork
+		uint64_t m_Latency_ms = 0; // total, from receiving the tx till the end of its aggregation
+		uint32_t m_LatencyMax_ms = 0;
+	};
+
+	const DandelionStats& get_DandelionStats() const { return m_Dandelion.m_Stats; }
+
+	struct PeerLink
+	{
+		uint32_t m_Rating; // raw, reflects the effective bandwidth
+		uint32_t m_Latency_ms; // smoothed RTT, 0 if unknown
+		bool m_Live; // connected now
+	};
+
+	bool get_PeerLink(PeerLink&, const PeerID&); // for tests only!
 
 	struct SyncStatus
 	{
@@ -249,6 +319,8 @@ private:
 
 		virtual Executor& get_Executor() override { return m_ExecutorMT; }
 
+		ExecutorMT_R m_ExecutorBg; // background jobs, see Config::m_BackgroundThreads
+
 
 		Block::ChainWorkProof m_Cwp; // cached
 		bool BuildCwp();
@@ -311,6 +383,16 @@ private:
 	bool TryAssignTask(Task&, Peer&);
 	void DeleteUnassignedTask(Task&);
 
+	struct HdrAnchors
+	{
+		Peer* m_pPeer = nullptr; // ChainWorkProof is currently requested from this peer
+		Height m_hDone = 0; // anchors up to this height are already inserted
+
+	} m_HdrAnchors;
+
+	void MaybeRequestHdrAnchors(Peer&);
+	void OnHdrAnchors(const Block::ChainWorkProof&, Peer&);
+
 	void InitKeys();
 	void InitIDs();
 	void RefreshOwnedUtxos();
@@ -365,6 +447,40 @@ private:
 		// TxPool::Stem
 		virtual bool ValidateTxContext(const Transaction&, const HeightRange&, const AmountBig::Type&, Amount& feeReserve) override;
 		virtual void OnTimedOut(Element&) override;
+		virtual bool ValidateMerged(Element& trg, const Element& src, const Transaction&, const HeightRange&, const AmountBig::Type&, Amount& feeReserve) override;
+
+		// Dummy outputs (each needs a key derivation and a bulletproof) are pre-generated by the background threads when the node is idle
+		struct DummyOutput
+		{
+			CoinID m_Cid;
+			Output::Ptr m_pOutput;
+			ECC::Scalar m_sk; // blinding factor
+			Height m_hScheme; // the output is created wrt this height
+		};
+
+		std::deque<DummyOutput> m_DummyPool;
+		uint32_t m_DummiesPending = 0; // being generated
+
+		std::mutex m_MutexDummies;
+		std::vector<DummyOutput> m_vDummiesDone; // protected by the mutex
+		io::AsyncEvent::Ptr m_pEvtDummies;
+
+		struct DummyTask;
+
+		struct Refill
+			:public io::IdleEvt
+		{
+			virtual void OnSchedule() override;
+			IMPLEMENT_GET_PARENT_OBJ(Dandelion, m_Refill)
+		} m_Refill;
+
+		void InitDummies();
+		void RefillDummies(); // schedules the generation if necessary
+		void OnDummiesReady();
+		bool TakeDummy(DummyOutput&);
+		void OnNewState(); // drops the pooled dummies that don't fit the current fork (incl. after the reorg)
+
+		DandelionStats m_Stats;
 
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_Dandelion)
 	} m_Dandelion;
@@ -397,6 +513,7 @@ private:
 	bool AddDummyInputEx(Transaction& tx, const CoinID&);
 	void AddDummyOutputs(Transaction&, Amount feeReserve);
 	Height SampleDummySpentHeight();
+	CoinID GenerateDummyCid();
 	void DeleteOutdated();
 
 	uint8_t ValidateTx(Transaction::Context&, const Transaction&, uint32_t& nSizeCorrection, Amount& feeReserve, std::ostream* pExtraInfo); // complete validation
@@ -414,8 +531,10 @@ private:
 			IMPLEMENT_GET_PARENT_OBJ(Bbs, m_W)
 		} m_W;
 
-		static void CalcMsgKey(NodeDB::WalkerBbs::Data&);
+		static void CalcMsgKey(BbsStore::Data&);
 		uint32_t m_LastCleanup_ms = 0;
+		BbsStore m_Store;
+		void Initialize();
 		void Cleanup();
 		void MaybeCleanup();
 		bool IsInLimits() const;
@@ -444,7 +563,42 @@ private:
 		Subscription::BbsSet m_Subscribed;
 		Timestamp m_HighestPosted_s = 0;
 
-		NodeDB::BbsTotals m_Totals;
+		// Incoming messages are pre-processed (PoW verification, key calculation) by the worker threads, the network thread
+		// only handles the results. Identical messages that arrive while the first copy is being verified are dropped.
+		struct Verifier
+		{
+			struct Pending
+				:public boost::intrusive::set_base_hook<>
+			{
+				proto::BbsMsg m_Msg;
+				BbsStore::Key m_Key;
+				Peer* m_pPeer; // reset if the peer is deleted meanwhile
+				bool m_bCheckPoW;
+				bool m_bValid;
+				bool m_bDone;
+
+				bool operator < (const Pending&) const; // by channel, timestamp, nonce and size
+			};
+
+			typedef boost::intrusive::multiset<Pending> PendingSet;
+			PendingSet m_setPending;
+			std::deque<Pending*> m_queOrder; // the results are handled in the order of arrival
+
+			std::mutex m_MutexDone;
+			std::vector<Pending*> m_vDone; // protected by the mutex
+			io::AsyncEvent::Ptr m_pEvtDone;
+
+			struct Task;
+
+			~Verifier();
+			void Push(proto::BbsMsg&&, Peer&);
+			void OnPeerDeleted(Peer&);
+			void OnDone();
+
+			IMPLEMENT_GET_PARENT_OBJ(Bbs, m_Verifier)
+		} m_Verifier;
+
+		void OnMsgVerified(const proto::BbsMsg&, const BbsStore::Key&, Peer* pSrc);
 
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_Bbs)
 	} m_Bbs;
@@ -471,10 +625,19 @@ private:
 				IMPLEMENT_GET_PARENT_OBJ(PeerInfoPlus, m_Live)
 			} m_Live;
 
+			uint32_t m_Throughput_Bps; // observed on data transfer, 0 if unknown
+			uint32_t m_Latency_ms; // smoothed RTT, 0 if unknown
+
+			NodeDB::WalkerPeer::Data m_Saved; // as it's stored in the DB. m_Saved.m_ID is Zero if not stored
+
 			void Attach(Peer&);
 			void DetachStrict();
+			void get_Data(NodeDB::WalkerPeer::Data&) const;
+			uint32_t get_ExpectedBps() const;
 		};
 
+		std::vector<PeerID> m_vDeleted; // stored peers, to be deleted from the DB on flush
+
 		// PeerManager
 		virtual void ActivatePeer(PeerInfo&) override;
 		virtual void DeactivatePeer(PeerInfo&) override;
@@ -510,6 +673,7 @@ private:
 			static const uint16_t Chocking		= 0x200;
 			static const uint16_t Viewer		= 0x400;
 			static const uint16_t Accepted		= 0x800;
+			static const uint16_t HdrAnchors	= 0x1000; // ChainWorkProof requested
 		};
 
 		uint16_t m_Flags;
@@ -520,6 +684,7 @@ private:
 		uint32_t m_LoginFlags;
 
 		uint64_t m_CursorBbs;
+		uint32_t m_nBbsPending; // messages from this peer being verified
 		TxPool::Fluff::Element* m_pCursorTx;
 
 		TaskList m_lstTasks;
@@ -529,6 +694,34 @@ private:
 
 		io::Timer::Ptr m_pTimerRequest;
 		io::Timer::Ptr m_pTimerPeers;
+		io::Timer::Ptr m_pTimerPaused;
+
+		struct CompactBody
+		{
+			Block::Body m_Body; // partially restored
+			std::vector<uint32_t> m_vOutputs; // missing elements
+			std::vector<uint32_t> m_vKernels;
+			std::vector<ECC::Hash::Value> m_vOutputKeys; // as announced by the peer
+			std::vector<Merkle::Hash> m_vKernelKeys;
+			ECC::Hash::Value m_Checksum; // of the original body
+		};
+
+		std::unique_ptr<CompactBody> m_pCompact; // set while the compact block body is being received
+
+		// Link quality. The bandwidth is reflected by the rating, the RTT is measured by pings
+		struct Quality
+		{
+			uint32_t m_Srtt_ms = 0; // smoothed RTT. 0 if not measured yet
+			uint32_t m_RttVar_ms = 0;
+			uint32_t m_LastProbe_ms = 0;
+			bool m_ProbePending = false;
+
+			std::deque<bool> m_PingsSent; // awaiting pongs, in order. Set if it's an RTT probe (otherwise it's sent on chocking)
+			uint32_t m_PingTime_ms = 0; // of the last probe
+
+			void OnRtt(uint32_t);
+			uint32_t get_Rto_ms() const;
+		} m_Quality;
 
 		Peer(Node& n) :m_This(n) {}
 
@@ -540,7 +733,8 @@ private:
 		void Unsubscribe();
 		void OnRequestTimeout();
 		void OnResendPeers();
-		void SendBbsMsg(const NodeDB::WalkerBbs::Data&);
+		void OnPausedTimeout();
+		void SendBbsMsg(const BbsStore::Data&);
 		void DeleteSelf(bool bIsError, uint8_t nByeReason);
 		void BroadcastTxs();
 		void BroadcastBbs();
@@ -549,6 +743,10 @@ private:
 		void OnChocking();
 		void SetTxCursor(TxPool::Fluff::Element*);
 		bool GetBlock(proto::BodyBuffers&, const NodeDB::StateID&, const proto::GetBodyPack&, bool bActive);
+		bool GetBlockBody(Block::Body&, const Block::SystemState::ID&, ECC::Hash::Value* pChecksum = nullptr);
+		bool IsCompactBodySupported() const;
+		void OnBody(const proto::BodyBuffers&);
+		void OnCompactBodyReady();
 
 		bool IsChocking(size_t nExtra = 0);
 		bool ShouldAssignTasks();
@@ -558,6 +756,10 @@ private:
 		void OnFirstTaskDone();
 		void OnFirstTaskDone(NodeProcessor::DataStatus::Enum);
 		void ModifyRatingWrtData(size_t nSize);
+		void ModifyRating(size_t nSize, uint32_t dt_ms);
+		void MaybeProbeRtt();
+		uint32_t get_RequestTimeout_ms(const Task&) const;
+		uint32_t get_PipelineDepth(bool bBody) const;
 		void SendHdrs(NodeDB::StateID&, uint32_t nCount);
 		void SendTx(Transaction::Ptr& ptx, bool bFluff);
 
@@ -569,6 +771,7 @@ private:
 		virtual void SetupLogin(proto::Login&) override;
 		virtual void OnLogin(proto::Login&&) override;
 		virtual Height get_MinPeerFork() override;
+		virtual void OnReadPaused(bool) override;
 		// messages
 		virtual void OnMsg(proto::Authentication&&) override;
 		virtual void OnMsg(proto::Bye&&) override;
@@ -583,6 +786,10 @@ private:
 		virtual void OnMsg(proto::GetBodyPack&&) override;
 		virtual void OnMsg(proto::Body&&) override;
 		virtual void OnMsg(proto::BodyPack&&) override;
+		virtual void OnMsg(proto::GetBodyCompact&&) override;
+		virtual void OnMsg(proto::BodyCompact&&) override;
+		virtual void OnMsg(proto::GetBodyParts&&) override;
+		virtual void OnMsg(proto::BodyParts&&) override;
 		virtual void OnMsg(proto::NewTransaction&&) override;
 		virtual void OnMsg(proto::HaveTransaction&&) override;
 		virtual void OnMsg(proto::GetTransaction&&) override;
@@ -591,11 +798,14 @@ private:
 		virtual void OnMsg(proto::GetProofKernel&&) override;
 		virtual void OnMsg(proto::GetProofKernel2&&) override;
 		virtual void OnMsg(proto::GetProofUtxo&&) override;
+		virtual void OnMsg(proto::GetProofUtxoMulti&&) override;
+		virtual void OnMsg(proto::GetProofKernelMulti&&) override;
 		virtual void OnMsg(proto::GetProofShieldedOutp&&) override;
 		virtual void OnMsg(proto::GetProofShieldedInp&&) override;
 		virtual void OnMsg(proto::GetProofAsset&&) override;
 		virtual void OnMsg(proto::GetShieldedList&&) override;
 		virtual void OnMsg(proto::GetProofChainWork&&) override;
+		virtual void OnMsg(proto::ProofChainWork&&) override;
 		virtual void OnMsg(proto::PeerInfoSelf&&) override;
 		virtual void OnMsg(proto::PeerInfo&&) override;
 		virtual void OnMsg(proto::GetExternalAddr&&) override;
@@ -700,6 +910,7 @@ private:
 
 		void HardAbortSafe();
 		bool Restart();
+		bool StartEmptyPreJob();
 		void StartMining(Task::Ptr&&);
 
 		Peer* m_pFinalizer = NULL;
@@ -716,6 +927,8 @@ private:
 			Task::Ptr m_ppTask[64]; // backlog of potentially being-mined currently
 			Task::Ptr& get_At(uint64_t);
 
+			Block::SystemState::ID m_PreJobTip; // tip for which the last empty pre-job was started
+
 		} m_External;
 
 		io::Timer::Ptr m_pTimer;
@@ -725,6 +938,53 @@ private:
 
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_Miner)
 	} m_Miner;
+
+	// Multi-reactor network mode. Inbound peers are accepted by several reactors on the same port (SO_REUSEPORT).
+	// Each reactor owns its connections: secure channel, framing, decryption and deserialization. Parsed messages
+	// are forwarded to the main thread, outgoing ones are serialized on the main thread and sealed by the owner reactor.
+	struct NetThreads
+	{
+		struct Task
+		{
+			Task* m_pNext;
+			virtual ~Task() {}
+			virtual void Exec() = 0;
+		};
+
+		// multiple producers, single consumer. Lock-free
+		struct Queue
+		{
+			std::atomic<Task*> m_pHead;
+			io::AsyncEvent::Ptr m_pEvt; // wakes the consumer
+
+			Queue() :m_pHead(nullptr) {}
+			~Queue() { Clear(); }
+
+			void Push(Task*);
+			void Process();
+			void Clear();
+
+			template <typename Fn>
+			void PushFn(Fn&& fn);
+		};
+
+		struct Link;
+		struct Thread;
+
+		std::vector<std::unique_ptr<Thread> > m_vThreads;
+		Queue m_Queue; // to the main thread
+
+		NetThreads();
+		~NetThreads();
+
+		bool IsEnabled() const { return !m_vThreads.empty(); }
+		void Initialize();
+		void Stop();
+
+		void OnAccepted(const std::shared_ptr<Link>&, const io::Address&);
+
+		IMPLEMENT_GET_PARENT_OBJ(Node, m_NetThreads)
+	} m_NetThreads;
 };
 
 } // namespace beam
@@ -351,18 +351,23 @@ int My_strcmpi(const char* sz1, const char* sz2)
 	return 0;
 }
 
-void NodeProcessor::get_MappingPath(std::string& sPath, const char* sz)
+void NodeProcessor::get_DbSiblingPath(std::string& sPath, const char* szDb, const char* szSufix)
 {
-	// derive mapping path from db path
-	sPath = sz;
+	sPath = szDb;
 
-	static const char szSufix[] = ".db";
-	const size_t nSufix = _countof(szSufix) - 1;
+	static const char szExt[] = ".db";
+	const size_t nExt = _countof(szExt) - 1;
 
-	if ((sPath.size() >= nSufix) && !My_strcmpi(sPath.c_str() + sPath.size() - nSufix, szSufix))
-		sPath.resize(sPath.size() - nSufix);
+	if ((sPath.size() >= nExt) && !My_strcmpi(sPath.c_str() + sPath.size() - nExt, szExt))
+		sPath.resize(sPath.size() - nExt);
+
+	sPath += szSufix;
+}
 
-	sPath += "-utxo-image.bin";
+void NodeProcessor::get_MappingPath(std::string& sPath, const char* sz)
+{
+	// derive mapping path from db path
+	get_DbSiblingPath(sPath, sz, "-utxo-image.bin");
 }
 
 bool NodeProcessor::InitMapping(const char* sz, bool bForceReset)
@@ -860,6 +865,7 @@ void NodeProcessor::UnreachableLog::Log(const Block::SystemState::ID& id)
 struct NodeProcessor::MultiSigmaContext
 {
 	static const uint32_t s_Chunk = 0x400;
+	static const uint32_t s_MaxBatch = s_Chunk * 0x100; // max points evaluated at once
 
 	struct Node
 	{
@@ -895,9 +901,12 @@ struct NodeProcessor::MultiSigmaContext
 private:
 
 	struct MyTask;
+	struct MyTask_Load;
 
 	void DeleteRaw(Node&);
 	std::vector<ECC::Point::Native> m_vRes;
+	std::vector<secp256k1_ge> m_vPts;
+	std::vector<ECC::Scalar::Native> m_vK;
 
 	virtual Sigma::CmList& get_List() = 0;
 	virtual void PrepareList(NodeProcessor&, const Node&) = 0;
@@ -961,22 +970,46 @@ void NodeProcessor::MultiSigmaContext::Add(TxoID id0, uint32_t nCount, const ECC
 	}
 }
 
-struct NodeProcessor::MultiSigmaContext::MyTask
+struct NodeProcessor::MultiSigmaContext::MyTask_Load
 	:public Executor::TaskSync
 {
 	MultiSigmaContext* m_pThis;
 	const Node* m_pNode;
+	uint32_t m_iDst;
 
 	virtual void Exec(Executor::Context& ctx) override
 	{
-		ECC::Point::Native& val = m_pThis->m_vRes[ctx.m_iThread];
-		val = Zero;
-
 		uint32_t i0, nCount;
 		ctx.get_Portion(i0, nCount, m_pNode->m_Max - m_pNode->m_Min);
+
+		secp256k1_ge* pPts = &m_pThis->m_vPts.front() + m_iDst + i0;
+		ECC::Scalar::Native* pK = &m_pThis->m_vK.front() + m_iDst + i0;
 		i0 += m_pNode->m_Min;
 
-		m_pThis->get_List().Calculate(val, i0, nCount, m_pNode->m_pS);
+		uint32_t nDone = m_pThis->get_List().Import(pPts, i0, nCount);
+		for (; nDone < nCount; nDone++)
+			pPts[nDone].infinity = 1; // shouldn't happen
+
+		for (uint32_t i = 0; i < nCount; i++)
+			pK[i] = m_pNode->m_pS[i0 + i];
+	}
+};
+
+struct NodeProcessor::MultiSigmaContext::MyTask
+	:public Executor::TaskSync
+{
+	MultiSigmaContext* m_pThis;
+	uint32_t m_Count;
+
+	virtual void Exec(Executor::Context& ctx) override
+	{
+		// the windows are split between the threads
+		ECC::MultiMac_Pippenger mmp;
+		mmp.m_pPts = &m_pThis->m_vPts.front();
+		mmp.m_pK = &m_pThis->m_vK.front();
+		mmp.m_Count = m_Count;
+
+		mmp.Calculate(m_pThis->m_vRes[ctx.m_iThread], ctx.m_iThread, ctx.m_pThis->get_Threads());
 	}
 };
 
@@ -987,23 +1020,44 @@ void NodeProcessor::MultiSigmaContext::Calculate(ECC::Point::Native& res, NodePr
 
 	while (!m_Set.empty())
 	{
-		Node& n = m_Set.begin()->get_ParentObj();
-		assert(n.m_Min < n.m_Max);
-		assert(n.m_Max <= s_Chunk);
+		// flatten the nodes, load the points in parallel
+		uint32_t nCount = 0;
+		while (!m_Set.empty())
+		{
+			Node& n = m_Set.begin()->get_ParentObj();
+			assert(n.m_Min < n.m_Max);
+			assert(n.m_Max <= s_Chunk);
+
+			uint32_t nPortion = n.m_Max - n.m_Min;
+			if (nCount && (nCount + nPortion > s_MaxBatch))
+				break;
+
+			m_vPts.resize(nCount + nPortion);
+			m_vK.resize(nCount + nPortion);
+
+			PrepareList(np, n);
+
+			MyTask_Load t;
+			t.m_pThis = this;
+			t.m_pNode = &n;
+			t.m_iDst = nCount;
+
+			ex.ExecAll(t);
+
+			nCount += nPortion;
+			DeleteRaw(n);
+		}
 
 		m_vRes.resize(nThreads);
-		PrepareList(np, n);
 
 		MyTask t;
 		t.m_pThis = this;
-		t.m_pNode = &n;
+		t.m_Count = nCount;
 
 		ex.ExecAll(t);
 
 		for (uint32_t i = 0; i < nThreads; i++)
 			res += m_vRes[i];
-
-		DeleteRaw(n);
 	}
 }
 
@@ -2230,6 +2284,21 @@ struct NodeProcessor::ProofBuilder_PrevState
 	}
 };
 
+struct NodeProcessor::ProofBuilder_Kernels
+	:public ProofBuilder_PrevState
+{
+	// from the block kernels root to the system state
+	using ProofBuilder_PrevState::ProofBuilder_PrevState;
+
+	virtual bool get_Kernels(Merkle::Hash&) override { return false; }
+
+	virtual bool get_Logs(Merkle::Hash& hv) override
+	{
+		hv = m_StateExtra.m_hvLogs;
+		return true;
+	}
+};
+
 Height NodeProcessor::get_ProofKernel(Merkle::Proof& proof, TxKernel::Ptr* ppRes, const Merkle::Hash& idKrn)
 {
 	NodeDB::StateID sid;
@@ -2252,25 +2321,100 @@ Height NodeProcessor::get_ProofKernel(Merkle::Proof& proof, TxKernel::Ptr* ppRes
 
 	if (sid.m_Height >= Rules::get().pForks[3].m_Height)
 	{
-		struct MyProofBuilder
-			:public ProofBuilder_PrevState
+		ProofBuilder_Kernels pb(*this, proof, sid);
+		pb.GenerateProof();
+	}
+
+	return sid.m_Height;
+}
+
+void NodeProcessor::get_ProofKernels(std::vector<Height>& vHeights, std::vector<proto::KernelsProof>& vBlocks, const std::vector<Merkle::Hash>& vIDs)
+{
+	// group by blocks
+	std::map<Height, std::vector<uint32_t> > mapBlocks;
+
+	vHeights.resize(vIDs.size());
+	for (uint32_t i = 0; i < vIDs.size(); i++)
+	{
+		Height h = m_DB.FindKernel(vIDs[i]);
+		if (h < Rules::HeightGenesis)
+			vHeights[i] = 0;
+		else
 		{
-			using ProofBuilder_PrevState::ProofBuilder_PrevState;
+			vHeights[i] = h;
+			mapBlocks[h].push_back(i);
+		}
+	}
 
-			virtual bool get_Kernels(Merkle::Hash&) override { return false; }
+	vBlocks.reserve(mapBlocks.size());
 
-			virtual bool get_Logs(Merkle::Hash& hv) override
+	for (auto it = mapBlocks.begin(); mapBlocks.end() != it; it++)
+	{
+		const std::vector<uint32_t>& vReq = it->second;
+
+		NodeDB::StateID sid;
+		sid.m_Height = it->first;
+		sid.m_Row = FindActiveAtStrict(sid.m_Height);
+
+		TxVectors::Eternal txve;
+		ReadKrns(sid.m_Row, txve);
+
+		Merkle::FixedMmr mmr;
+		mmr.Resize(txve.m_vKernels.size());
+		ProcessKrnMmr(mmr, txve.m_vKernels, Zero, nullptr);
+
+		proto::KernelsProof& kp = vBlocks.emplace_back();
+		kp.m_Height = sid.m_Height;
+		kp.m_Count = txve.m_vKernels.size();
+		kp.m_vIdx.resize(vReq.size());
+
+		for (size_t i = 0; i < vReq.size(); i++)
+		{
+			const Merkle::Hash& idKrn = vIDs[vReq[i]];
+
+			size_t iPos = 0;
+			for ( ; iPos < txve.m_vKernels.size(); iPos++)
+				if (txve.m_vKernels[iPos]->m_Internal.m_ID == idKrn)
+					break;
+
+			if (txve.m_vKernels.size() == iPos)
+				OnCorrupted();
+
+			kp.m_vIdx[i] = iPos;
+		}
+
+		// shared paths within the block
+		std::vector<uint64_t> vPos = kp.m_vIdx;
+		std::sort(vPos.begin(), vPos.end());
+		vPos.erase(std::unique(vPos.begin(), vPos.end()), vPos.end());
+
+		struct MyBuilder
+			:public Merkle::MultiProof::Builder
+		{
+			const Merkle::FixedMmr& m_Mmr;
+
+			MyBuilder(Merkle::MultiProof& x, const Merkle::FixedMmr& mmr)
+				:Merkle::MultiProof::Builder(x)
+				,m_Mmr(mmr)
 			{
-				hv = m_StateExtra.m_hvLogs;
-				return true;
+			}
+
+			virtual void get_Proof(Merkle::IProofBuilder& p, uint64_t i) override
+			{
+				m_Mmr.get_Proof(p, i);
 			}
 		};
 
-		MyProofBuilder pb(*this, proof, sid);
-		pb.GenerateProof();
-	}
+		MyBuilder bld(kp.m_Proof, mmr);
+		for (size_t i = 0; i < vPos.size(); i++)
+			bld.Add(vPos[i]);
 
-	return sid.m_Height;
+		if (sid.m_Height >= Rules::get().pForks[3].m_Height)
+		{
+			ProofBuilder_Kernels pb(*this, kp.m_Tail, sid);
+			pb.GenerateProof();
+		}
+	}
 }
 
 bool NodeProcessor::get_ProofContractLog(Merkle::Proof& proof, const HeightPos& pos)
@@ -2914,6 +3058,7 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, const Block::SystemS
 
 		// recognize all
 		MyRecognizer rec(*this);
+		Executor::Scope scopeExec(get_ExecutorRecognize());
 		rec.m_Recognizer.Recognize(block, sid.m_Height, bic.m_ShieldedOuts);
 
 		Serializer ser;
@@ -3037,10 +3182,19 @@ void NodeProcessor::Recognizer::Recognize(const TxVectors::Full& block, Height h
 
 	NodeProcessor::ViewerKeys vk;
 	m_Handler.get_ViewerKeys(vk);
-	if (vk.m_pMw)
+	if (vk.m_pMw && !block.m_vOutputs.empty())
 	{
-		for (size_t i = 0; i < block.m_vOutputs.size(); i++)
-			Recognize(*block.m_vOutputs[i], height, *vk.m_pMw);
+		// the recovery is the heavy part, run it in parallel. The events are added sequentially, in the original order
+		uint32_t nOuts = static_cast<uint32_t>(block.m_vOutputs.size());
+		std::vector<Output::Recovered> vRes(nOuts);
+		Output::RecoverBatch(height, *vk.m_pMw, &block.m_vOutputs.front(), nOuts, &vRes.front());
+
+		for (uint32_t i = 0; i < nOuts; i++)
+		{
+			const Output::Recovered& r = vRes[i];
+			if (r.m_Valid)
+				Recognize(*block.m_vOutputs[i], height, r.m_Cid, r.m_User);
+		}
 	}
 
 	if (!vk.IsEmpty())
@@ -3176,9 +3330,12 @@ void NodeProcessor::Recognizer::Recognize(const Output& x, Height h, Key::IPKdf&
 {
 	CoinID cid;
 	Output::User user;
-	if (!x.Recover(h, keyViewer, cid, &user))
-		return;
+	if (x.Recover(h, keyViewer, cid, &user))
+		Recognize(x, h, cid, user);
+}
 
+void NodeProcessor::Recognizer::Recognize(const Output& x, Height h, const CoinID& cid, const Output::User& user)
+{
 	// filter-out dummies
 	if (cid.IsDummy())
 	{
@@ -4046,8 +4203,32 @@ bool NodeProcessor::HandleValidatedBlock(const Block::Body& block, BlockInterpre
 		m_Extra.m_Txos--;
 	}
 
-	if (!HandleValidatedTx(block, bic))
-		return false;
+	if (bic.m_Fwd && !bic.m_AlreadyValidated)
+	{
+		// Contract kernel signatures are context-bound, hence verified during the interpretation. Accumulate them in a batch,
+		// and settle it once the whole block is interpreted. The block is invalid anyway if any of them fails.
+		typedef ECC::InnerProduct::BatchContextEx<4> MyBatch;
+		std::unique_ptr<MyBatch> pBc(new MyBatch);
+
+		{
+			MyBatch::Scope scope(*pBc);
+			if (!HandleValidatedTx(block, bic))
+				return false;
+		}
+
+		if (!pBc->Flush())
+		{
+			bic.m_Fwd = false;
+			BEAM_VERIFY(HandleValidatedTx(block, bic)); // undo changes
+			bic.m_Fwd = true;
+			return false;
+		}
+	}
+	else
+	{
+		if (!HandleValidatedTx(block, bic))
+			return false;
+	}
 
 	// currently there's no extra info in the block that's needed
 
@@ -6011,22 +6192,23 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 		return 0; //
 	}
 
-	size_t nTxNum = 0;
+	std::vector<TxPool::Fluff::Element*> vSel;
+	std::set<const TxPool::Fluff::Element*> setSel;
 
-	for (TxPool::Fluff::ProfitSet::iterator it = bc.m_TxPool.m_setProfit.begin(); bc.m_TxPool.m_setProfit.end() != it; )
+	// In the incremental mode (and for package alternatives) the pool is not modified, the rejected txs are just skipped (will be handled on the full rebuild)
+	auto fnTry = [&](TxPool::Fluff::Element& x, bool bIncremental) -> bool
 	{
-		TxPool::Fluff::Element& x = (it++)->get_ParentObj();
-
 		if (AmountBig::get_Hi(x.m_Profit.m_Fee))
 		{
 			// huge fees are unsupported
-			bc.m_TxPool.Delete(x);
-			continue;
+			if (!bIncremental)
+				bc.m_TxPool.Delete(x);
+			return false;
 		}
 
 		Amount feesNext = bc.m_Fees + AmountBig::get_Lo(x.m_Profit.m_Fee);
 		if (feesNext < bc.m_Fees)
-			continue; // huge fees are unsupported
+			return false; // huge fees are unsupported
 
 		size_t nSizeNext = ssc.m_Counter.m_Value + x.m_Profit.m_nSize;
 		if (!bc.m_Fees && feesNext)
@@ -6040,9 +6222,10 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 			{
 				// won't fit in empty block
 				LOG_INFO() << "Tx is too big.";
-				bc.m_TxPool.Delete(x);
+				if (!bIncremental)
+					bc.m_TxPool.Delete(x);
 			}
-			continue;
+			return false;
 		}
 
 		Transaction& tx = *x.m_pValue;
@@ -6058,7 +6241,9 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 				bc.m_Fees = feesNext;
 				ssc.m_Counter.m_Value = nSizeNext;
 				offset += ECC::Scalar::Native(tx.m_Offset);
-				++nTxNum;
+				vSel.push_back(&x);
+				setSel.insert(&x);
+				return true;
 			}
 			else
 			{
@@ -6069,11 +6254,124 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 			}
 		}
 
-		if (bDelete)
+		if (bDelete && !bIncremental)
 			bc.m_TxPool.SetOutdated(x, h); // isn't available in this context
+
+		return false;
+	};
+
+	std::vector<TxPool::Fluff::Element*> vRivals;
+
+	auto fnConflicts = [&](const TxPool::Fluff::Element& x)
+	{
+		vRivals.clear();
+		bc.m_TxPool.get_Rivals(x, vRivals);
+
+		for (size_t i = 0; i < vRivals.size(); i++)
+			if (setSel.count(vRivals[i]))
+				return true;
+		return false;
+	};
+
+	// Package selection. The rivals of x (that share kernels or spends with it) are mutually exclusive, only one may be included.
+	// Greedy selection by fee rate would pick x, and lose the rival with more fees (such as an aggregated tx that contains x).
+	// Select the rival instead, if the extra fee per extra size is not worse than that of the next tx that is not a rival.
+	auto fnTryPackage = [&](TxPool::Fluff::Element& x, TxPool::Fluff::ProfitSet::iterator itNext) -> bool
+	{
+		vRivals.clear();
+		bc.m_TxPool.get_Rivals(x, vRivals);
+		if (vRivals.empty())
+			return false;
+
+		std::vector<TxPool::Fluff::Element*> vAlt;
+		for (size_t i = 0; i < vRivals.size(); i++)
+			if (x.m_Profit.m_Fee < vRivals[i]->m_Profit.m_Fee)
+				vAlt.push_back(vRivals[i]);
+		if (vAlt.empty())
+			return false;
+
+		// the cutoff
+		const TxPool::Profit* pNext = nullptr;
+		for (uint32_t i = 0; (bc.m_TxPool.m_setProfit.end() != itNext) && (i < 16); i++, ++itNext)
+		{
+			TxPool::Fluff::Element* p = &itNext->get_ParentObj();
+			if (std::find(vRivals.begin(), vRivals.end(), p) == vRivals.end())
+			{
+				pNext = &p->m_Profit;
+				break;
+			}
+		}
+
+		// most fees first
+		std::sort(vAlt.begin(), vAlt.end(), [](const TxPool::Fluff::Element* p0, const TxPool::Fluff::Element* p1) {
+			return p1->m_Profit.m_Fee < p0->m_Profit.m_Fee;
+		});
+
+		for (size_t i = 0; i < vAlt.size(); i++)
+		{
+			TxPool::Fluff::Element& y = *vAlt[i];
+
+			if (pNext)
+			{
+				uint32_t nSize0, nSize1;
+				x.m_Profit.m_nSizeCorrected.Export(nSize0);
+				y.m_Profit.m_nSizeCorrected.Export(nSize1);
+
+				if (nSize1 > nSize0)
+				{
+					TxPool::Profit d;
+					d.m_Fee = x.m_Profit.m_Fee;
+					d.m_Fee.Negate();
+					d.m_Fee += y.m_Profit.m_Fee; // extra fee
+					d.m_nSizeCorrected = nSize1 - nSize0;
+
+					if (*pNext < d)
+						continue; // the space is better used by others
+				}
+			}
+
+			if (fnConflicts(y))
+				continue;
+
+			if (fnTry(y, true))
+				return true;
+		}
+
+		return false;
+	};
+
+	std::vector<TxPool::Fluff::Element*> vCandidates;
+	bool bIncremental = get_TemplateCandidates(bc.m_TxPool, vCandidates);
+
+	if (bIncremental)
+	{
+		for (size_t i = 0; i < vCandidates.size(); i++)
+			fnTry(*vCandidates[i], true);
+	}
+	else
+	{
+		for (TxPool::Fluff::ProfitSet::iterator it = bc.m_TxPool.m_setProfit.begin(); bc.m_TxPool.m_setProfit.end() != it; )
+		{
+			TxPool::Fluff::Element& x = (it++)->get_ParentObj();
+
+			if (bc.m_TxPool.m_PackageSelection)
+			{
+				// a rival is already selected. Leave it in the pool, it'll be outdated if the rival gets into the chain
+				if (setSel.count(&x) || fnConflicts(x))
+					continue;
+
+				if (fnTryPackage(x, it))
+					continue;
+			}
+
+			fnTry(x, false);
+		}
 	}
 
-	LOG_INFO() << "GenerateNewBlock: size of block = " << ssc.m_Counter.m_Value << "; amount of tx = " << nTxNum;
+	size_t nTxNum = vSel.size();
+	bc.m_TxPool.SetTemplate(m_Cursor.m_ID, std::move(vSel), ssc.m_Counter.m_Value, bc.m_Fees);
+
+	LOG_INFO() << "GenerateNewBlock: size of block = " << ssc.m_Counter.m_Value << "; amount of tx = " << nTxNum << (bIncremental ? " (incremental)" : "");
 
 	if (BlockContext::Mode::Assemble != bc.m_Mode)
 	{
@@ -6095,6 +6393,84 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 	return ssc.m_Counter.m_Value;
 }
 
+bool NodeProcessor::get_TemplateCandidates(TxPool::Fluff& txp, std::vector<TxPool::Fluff::Element*>& vRes)
+{
+	const TxPool::Fluff::Template& tpl = txp.m_Template;
+	if (tpl.m_Tip != m_Cursor.m_ID)
+		return false;
+
+	// all the selected elements must still be valid
+	for (size_t i = 0; i < tpl.m_vElems.size(); i++)
+	{
+		const TxPool::Fluff::Element& x = *tpl.m_vElems[i];
+		if (!x.m_pValue || x.IsOutdated())
+			return false;
+	}
+
+	vRes = tpl.m_vElems;
+	size_t n0 = vRes.size();
+
+	// newer elements are at the tail
+	for (TxPool::Fluff::Queue::reverse_iterator it = txp.m_Queue.rbegin(); txp.m_Queue.rend() != it; ++it)
+	{
+		TxPool::Fluff::Element& x = it->get_ParentObj();
+		if (x.m_Seq <= tpl.m_SeqLast)
+			break;
+
+		if (x.m_pValue && !x.IsOutdated())
+		{
+			if (txp.m_PackageSelection)
+			{
+				// rivals are resolved on the full rebuild only
+				std::vector<TxPool::Fluff::Element*> vRivals;
+				txp.get_Rivals(x, vRivals);
+				if (!vRivals.empty())
+					return false;
+			}
+
+			vRes.push_back(&x);
+		}
+	}
+
+	std::sort(vRes.begin() + n0, vRes.end(), [](const TxPool::Fluff::Element* p0, const TxPool::Fluff::Element* p1) {
+		return p0->m_Profit < p1->m_Profit;
+	});
+
+	// the worst selected element
+	const TxPool::Profit* pWorst = nullptr;
+	for (size_t i = 0; i < n0; i++)
+		if (!pWorst || (*pWorst < vRes[i]->m_Profit))
+			pWorst = &vRes[i]->m_Profit;
+
+	size_t nSize = tpl.m_nSize;
+	bool bFees = !!tpl.m_Fees;
+
+	for (size_t i = n0; i < vRes.size(); i++)
+	{
+		const TxPool::Fluff::Element& x = *vRes[i];
+
+		size_t nSizeNext = nSize + x.m_Profit.m_nSize;
+		bool bFeesNext = bFees || AmountBig::get_Lo(x.m_Profit.m_Fee);
+		if (bFeesNext && !bFees)
+			nSizeNext += m_nSizeUtxoComission;
+
+		if (nSizeNext > Rules::get().MaxBodySize)
+		{
+			// doesn't fit into the remaining space. If it's better than the worst selected element - it may displace it, rebuild.
+			// Otherwise the full rebuild would skip it as well.
+			if (pWorst && (x.m_Profit < *pWorst))
+				return false;
+		}
+		else
+		{
+			nSize = nSizeNext;
+			bFees = bFeesNext;
+		}
+	}
+
+	return true;
+}
+
 void NodeProcessor::GenerateNewHdr(BlockContext& bc, BlockInterpretCtx& bic)
 {
 	bc.m_Hdr.m_Prev = m_Cursor.m_ID.m_Hash;
@@ -6240,6 +6616,17 @@ Executor& NodeProcessor::get_Executor()
 	return *m_pExecSync;
 }
 
+Executor& NodeProcessor::get_ExecutorRecognize()
+{
+	if (!m_pExecRecognize)
+	{
+		m_pExecRecognize = std::make_unique<ExecutorMT_R>();
+		m_pExecRecognize->set_Threads(get_Executor().get_Threads());
+	}
+
+	return *m_pExecRecognize;
+}
+
 uint32_t NodeProcessor::MyExecutor::get_Threads()
 {
 	return 1;
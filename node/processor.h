@@ -283,6 +283,7 @@ public:
 
     static bool ExtractTreasury(const Blob&, Treasury::Data&);
 	static void get_MappingPath(std::string&, const char*);
+	static void get_DbSiblingPath(std::string&, const char* szDb, const char* szSufix); // replaces the .db extension
 
 	NodeProcessor();
 	virtual ~NodeProcessor();
@@ -511,8 +512,10 @@ public:
 	};
 
 	struct ProofBuilder_PrevState;
+	struct ProofBuilder_Kernels;
 
 	Height get_ProofKernel(Merkle::Proof&, TxKernel::Ptr*, const Merkle::Hash& idKrn);
+	void get_ProofKernels(std::vector<Height>&, std::vector<proto::KernelsProof>&, const std::vector<Merkle::Hash>& vIDs);
 	bool get_ProofContractLog(Merkle::Proof&, const HeightPos&);
 
 	void CommitDB();
@@ -559,6 +562,10 @@ public:
 
 	virtual Executor& get_Executor();
 
+	// outputs recovery runs on a dedicated executor: the standard one may be busy with the verification of the pending blocks
+	std::unique_ptr<ExecutorMT_R> m_pExecRecognize; // created on demand, threads are started on the first use
+	Executor& get_ExecutorRecognize();
+
 	bool ValidateAndSummarize(TxBase::Context&, const TxBase&, TxBase::IReader&&);
 
 	struct ViewerKeys
@@ -753,6 +760,7 @@ public:
 
 		void Recognize(const Input&, Height);
 		void Recognize(const Output&, Height, Key::IPKdf&);
+		void Recognize(const Output&, Height, const CoinID&, const Output::User&); // already recovered
 
 #define THE_MACRO(id, name) void Recognize(const TxKernel##name&, Height, uint32_t);
 		BeamKernelsAll(THE_MACRO)
@@ -856,6 +864,7 @@ public:
 
 private:
 	size_t GenerateNewBlockInternal(BlockContext&, BlockInterpretCtx&);
+	bool get_TemplateCandidates(TxPool::Fluff&, std::vector<TxPool::Fluff::Element*>&);
 	void GenerateNewHdr(BlockContext&, BlockInterpretCtx&);
 	DataStatus::Enum OnStateInternal(const Block::SystemState::Full&, Block::SystemState::ID&, bool bAlreadyChecked);
 	bool GetBlockInternal(const NodeDB::StateID&, ByteBuffer* pEthernal, ByteBuffer* pPerishable, Height h0, Height hLo1, Height hHi1, bool bActive, Block::Body*);
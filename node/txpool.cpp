@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "processor.h"
+#include "../core/serialization_adapters.h"
 #include "../utility/logger.h"
 #include "../utility/logger_checkpoints.h"
 
@@ -50,6 +51,13 @@ bool TxPool::Profit::operator < (const Profit& t) const
 
 /////////////////////////////
 // Fluff
+TxPool::Fluff::Fluff()
+{
+	m_MinRate.m_Fee = Zero;
+	m_MinRate.m_nSize = 0;
+	m_MinRate.m_nSizeCorrected = 1u;
+}
+
 TxPool::Fluff::Element* TxPool::Fluff::AddValidTx(Transaction::Ptr&& pValue, const Transaction::Context& ctx, const Transaction::KeyType& key, uint32_t nSizeCorrection)
 {
 	assert(pValue);
@@ -60,10 +68,15 @@ TxPool::Fluff::Element* TxPool::Fluff::AddValidTx(Transaction::Ptr&& pValue, con
 	p->m_Profit.m_Fee = ctx.m_Stats.m_Fee;
 	p->m_Profit.SetSize(*p->m_pValue, nSizeCorrection);
 	p->m_Tx.m_Key = key;
+	p->m_Seq = ++m_SeqLast;
 	p->m_Outdated.m_Height = MaxHeight;
 	assert(!p->IsOutdated());
 
 	InternalInsert(*p);
+	InsertContent(*p);
+
+	p->m_nMemSize = get_MemSize(*p);
+	m_TotalMemSize += p->m_nMemSize;
 
 	p->m_Queue.m_Refs = 1;
 	m_Queue.push_back(p->m_Queue);
@@ -111,9 +124,200 @@ void TxPool::Fluff::DeleteEmpty(Element& x)
 {
 	assert(!x.m_pValue);
 	InternalErase(x);
+	DeleteContent(x);
+
+	assert(m_TotalMemSize >= x.m_nMemSize);
+	m_TotalMemSize -= x.m_nMemSize;
 	Release(x);
 }
 
+void TxPool::Fluff::InsertContent(Element& x)
+{
+	const Transaction& tx = *x.m_pValue;
+
+	x.m_vKrn.resize(tx.m_vKernels.size());
+	for (size_t i = 0; i < x.m_vKrn.size(); i++)
+	{
+		Element::Kernel& n = x.m_vKrn[i];
+		n.m_pKrn = tx.m_vKernels[i].get();
+		n.m_Key = n.m_pKrn->m_Internal.m_ID;
+		n.m_pThis = &x;
+		m_setKrns.insert(n);
+	}
+
+	x.m_vOutp.resize(tx.m_vOutputs.size());
+	for (size_t i = 0; i < x.m_vOutp.size(); i++)
+	{
+		Element::Output& n = x.m_vOutp[i];
+		n.m_pOutp = tx.m_vOutputs[i].get();
+		get_OutputKey(n.m_Key, *n.m_pOutp);
+		m_setOutps.insert(n);
+	}
+
+	x.m_vSpend.reserve(tx.m_vInputs.size());
+	for (size_t i = 0; i < tx.m_vInputs.size(); i++)
+	{
+		x.m_vSpend.emplace_back();
+		x.m_vSpend.back().m_Key = tx.m_vInputs[i]->m_Commitment;
+	}
+
+	InsertSpends(x, tx.m_vKernels);
+
+	// the vector won't be reallocated anymore
+	for (size_t i = 0; i < x.m_vSpend.size(); i++)
+	{
+		Element::Spend& n = x.m_vSpend[i];
+		n.m_pThis = &x;
+		m_setSpends.insert(n);
+	}
+}
+
+void TxPool::Fluff::InsertSpends(Element& x, const std::vector<TxKernel::Ptr>& vKrn)
+{
+	for (size_t i = 0; i < vKrn.size(); i++)
+	{
+		const TxKernel& krn = *vKrn[i];
+		InsertSpends(x, krn.m_vNested);
+
+		switch (krn.get_Subtype())
+		{
+		case TxKernel::Subtype::ShieldedInput:
+			x.m_vSpend.emplace_back();
+			x.m_vSpend.back().m_Key = Cast::Up<TxKernelShieldedInput>(krn).m_SpendProof.m_SpendPk;
+			break;
+
+		case TxKernel::Subtype::AssetCreate:
+		case TxKernel::Subtype::AssetDestroy:
+			{
+				// keyed by the owner. Use an invalid Y flag, so that it can't collide with a real point
+				x.m_vSpend.emplace_back();
+				ECC::Point& pt = x.m_vSpend.back().m_Key;
+				pt.m_X = Cast::Down<ECC::uintBig>(Cast::Up<TxKernelAssetControl>(krn).m_Owner);
+				pt.m_Y = 2;
+			}
+			break;
+
+		default: // suppress warning
+			break;
+		}
+	}
+}
+
+void TxPool::Fluff::DeleteContent(Element& x)
+{
+	for (size_t i = 0; i < x.m_vKrn.size(); i++)
+		m_setKrns.erase(KrnSet::s_iterator_to(x.m_vKrn[i]));
+	x.m_vKrn.clear();
+
+	for (size_t i = 0; i < x.m_vOutp.size(); i++)
+		m_setOutps.erase(OutpSet::s_iterator_to(x.m_vOutp[i]));
+	x.m_vOutp.clear();
+
+	for (size_t i = 0; i < x.m_vSpend.size(); i++)
+		m_setSpends.erase(SpendSet::s_iterator_to(x.m_vSpend[i]));
+	x.m_vSpend.clear();
+}
+
+const TxKernel* TxPool::Fluff::FindKernel(const Merkle::Hash& hv) const
+{
+	Element::Kernel key;
+	key.m_Key = hv;
+
+	KrnSet::const_iterator it = m_setKrns.find(key);
+	return (m_setKrns.end() == it) ? nullptr : it->m_pKrn;
+}
+
+const Output* TxPool::Fluff::FindOutput(const ECC::Hash::Value& hv) const
+{
+	Element::Output key;
+	key.m_Key = hv;
+
+	OutpSet::const_iterator it = m_setOutps.find(key);
+	return (m_setOutps.end() == it) ? nullptr : it->m_pOutp;
+}
+
+uint32_t TxPool::Fluff::get_MemSize(const Element& x)
+{
+	// The serialized size is a good approximation for the payload (proofs, signatures, etc.), plus the objects and the containers overhead.
+	// Kernels are accounted by the largest common type
+	const Transaction& tx = *x.m_pValue;
+
+	size_t n =
+		sizeof(Element) +
+		sizeof(Transaction) +
+		x.m_Profit.m_nSize +
+		tx.m_vInputs.size() * (sizeof(Input) + sizeof(Input::Ptr)) +
+		tx.m_vOutputs.size() * (sizeof(beam::Output) + sizeof(beam::Output::Ptr)) +
+		tx.m_vKernels.size() * (sizeof(TxKernelStd) + sizeof(TxKernel::Ptr)) +
+		x.m_vKrn.size() * sizeof(Element::Kernel) +
+		x.m_vOutp.size() * sizeof(Element::Output) +
+		x.m_vSpend.capacity() * sizeof(Element::Spend);
+
+	return static_cast<uint32_t>(n);
+}
+
+bool TxPool::Fluff::IsBelowMinRate(const TxPool::Profit& p) const
+{
+	if (m_MinRate.m_Fee == Zero)
+		return false;
+
+	// must be strictly better than what was evicted
+	return !(p < m_MinRate);
+}
+
+void TxPool::Fluff::RaiseMinRate(const TxPool::Profit& p)
+{
+	if ((m_MinRate.m_Fee == Zero) || (m_MinRate < p))
+	{
+		m_MinRate.m_Fee = p.m_Fee;
+		m_MinRate.m_nSize = p.m_nSize;
+		m_MinRate.m_nSizeCorrected = p.m_nSizeCorrected;
+	}
+}
+
+void TxPool::Fluff::DecayMinRate()
+{
+	AmountBig::Type val = m_MinRate.m_Fee;
+	val.ShiftRight(1, m_MinRate.m_Fee);
+}
+
+void TxPool::Fluff::get_Rivals(const Element& x, std::vector<Element*>& vRes) const
+{
+	size_t n0 = vRes.size();
+
+	for (size_t i = 0; i < x.m_vKrn.size(); i++)
+	{
+		auto range = m_setKrns.equal_range(x.m_vKrn[i]);
+		for (KrnSet::const_iterator it = range.first; range.second != it; ++it)
+			vRes.push_back(it->m_pThis);
+	}
+
+	for (size_t i = 0; i < x.m_vSpend.size(); i++)
+	{
+		auto range = m_setSpends.equal_range(x.m_vSpend[i]);
+		for (SpendSet::const_iterator it = range.first; range.second != it; ++it)
+			vRes.push_back(it->m_pThis);
+	}
+
+	// remove self, outdated, and duplicates
+	std::sort(vRes.begin() + n0, vRes.end());
+	vRes.erase(std::unique(vRes.begin() + n0, vRes.end()), vRes.end());
+
+	vRes.erase(std::remove_if(vRes.begin() + n0, vRes.end(), [&x](const Element* p) {
+		return (&x == p) || p->IsOutdated();
+	}), vRes.end());
+}
+
+void TxPool::Fluff::get_OutputKey(ECC::Hash::Value& hv, const Output& outp)
+{
+	Serializer ser;
+	ser & outp;
+
+	ECC::Hash::Processor()
+		<< Blob(ser.buffer().first, static_cast<uint32_t>(ser.buffer().second))
+		>> hv;
+}
+
 void TxPool::Fluff::Release(Element& x)
 {
 	assert(x.m_Queue.m_Refs);
@@ -125,8 +329,33 @@ void TxPool::Fluff::Release(Element& x)
 	}
 }
 
+void TxPool::Fluff::SetTemplate(const Block::SystemState::ID& tip, std::vector<Element*>&& vElems, size_t nSize, Amount fees)
+{
+	for (size_t i = 0; i < vElems.size(); i++)
+		vElems[i]->m_Queue.m_Refs++;
+
+	ResetTemplate();
+
+	m_Template.m_Tip = tip;
+	m_Template.m_vElems = std::move(vElems);
+	m_Template.m_SeqLast = m_SeqLast;
+	m_Template.m_nSize = nSize;
+	m_Template.m_Fees = fees;
+}
+
+void TxPool::Fluff::ResetTemplate()
+{
+	for (size_t i = 0; i < m_Template.m_vElems.size(); i++)
+		Release(*m_Template.m_vElems[i]);
+
+	m_Template.m_vElems.clear();
+	ZeroObject(m_Template.m_Tip);
+}
+
 void TxPool::Fluff::Clear()
 {
+	ResetTemplate();
+
 	while (!m_setProfit.empty())
 		Delete(m_setProfit.begin()->get_ParentObj());
 
@@ -163,7 +392,7 @@ bool TxPool::Stem::TryMerge(Element& trg, Element& src)
 	auto fees = trg.m_Profit.m_Fee;
 	fees += src.m_Profit.m_Fee;
 	Amount feeReserve = 0;
-	if (!ValidateTxContext(txNew, hr, fees, feeReserve))
+	if (!ValidateMerged(trg, src, txNew, hr, fees, feeReserve))
 		return false; // conflicting txs, can't merge
 
 	trg.m_Profit.m_Fee += fees;
@@ -58,6 +58,8 @@ struct TxPool
 			} m_Profit;
 
 			HeightRange m_Height;
+			uint64_t m_Seq; // order of arrival
+			uint32_t m_nMemSize; // estimated memory consumption, incl. the tx and the index
 
 			struct Outdated
 				:public boost::intrusive::set_base_hook<>
@@ -75,6 +77,38 @@ struct TxPool
 				IMPLEMENT_GET_PARENT_OBJ(Element, m_Queue)
 			} m_Queue;
 
+			// content index, used to restore compact block bodies. Covers outdated txs as well
+			struct Kernel
+				:public boost::intrusive::set_base_hook<>
+			{
+				Merkle::Hash m_Key;
+				const TxKernel* m_pKrn;
+				Element* m_pThis;
+				bool operator < (const Kernel& t) const { return m_Key < t.m_Key; }
+			};
+
+			struct Output
+				:public boost::intrusive::set_base_hook<>
+			{
+				ECC::Hash::Value m_Key;
+				const beam::Output* m_pOutp;
+				bool operator < (const Output& t) const { return m_Key < t.m_Key; }
+			};
+
+			// conflict index: spent inputs, shielded spend keys, asset create/destroy. Txs that share a key (or a kernel) are rivals,
+			// at most one of them can get into a block
+			struct Spend
+				:public boost::intrusive::set_base_hook<>
+			{
+				ECC::Point m_Key;
+				Element* m_pThis;
+				bool operator < (const Spend& t) const { return m_Key < t.m_Key; }
+			};
+
+			std::vector<Kernel> m_vKrn;
+			std::vector<Output> m_vOutp;
+			std::vector<Spend> m_vSpend;
+
 			bool IsOutdated() const { return MaxHeight != m_Outdated.m_Height; }
 		};
 
@@ -82,11 +116,48 @@ struct TxPool
 		typedef boost::intrusive::multiset<Element::Profit> ProfitSet;
 		typedef boost::intrusive::multiset<Element::Outdated> OutdatedSet;
 		typedef boost::intrusive::list<Element::Queue> Queue;
+		typedef boost::intrusive::multiset<Element::Kernel> KrnSet;
+		typedef boost::intrusive::multiset<Element::Output> OutpSet;
+		typedef boost::intrusive::multiset<Element::Spend> SpendSet;
 
 		TxSet m_setTxs;
 		ProfitSet m_setProfit;
 		OutdatedSet m_setOutdated;
 		Queue m_Queue;
+		KrnSet m_setKrns;
+		OutpSet m_setOutps;
+		SpendSet m_setSpends;
+
+		// Package selection: rival txs are resolved per block. A tx that conflicts with an already selected one is skipped (not outdated),
+		// and a rival that carries more fees (such as an aggregated tx that includes this one) may be selected instead.
+		bool m_PackageSelection = true;
+
+		uint64_t m_SeqLast = 0;
+		uint64_t m_TotalMemSize = 0; // of all the elements that hold a tx
+
+		// Rolling minimum fee rate for the new txs. Raised to the rate of the valid txs evicted due to the pool limits, decays when there's no pressure.
+		// Zero fee means no restriction.
+		TxPool::Profit m_MinRate;
+
+		bool IsBelowMinRate(const TxPool::Profit&) const;
+		void RaiseMinRate(const TxPool::Profit&);
+		void DecayMinRate();
+
+		// Block template: elements selected for the next block at the given tip. Maintained incrementally by NodeProcessor::GenerateNewBlock,
+		// new elements are appended, the full rebuild is needed only if the tip changes, or the selected elements are removed/displaced.
+		struct Template
+		{
+			Block::SystemState::ID m_Tip;
+			std::vector<Element*> m_vElems; // in the order of inclusion, referenced
+			uint64_t m_SeqLast = 0; // newer elements weren't considered yet
+			size_t m_nSize = 0; // accumulated block size, incl. the fees UTXO if there are fees
+			Amount m_Fees = 0;
+
+			Template() { ZeroObject(m_Tip); }
+		} m_Template;
+
+		void SetTemplate(const Block::SystemState::ID&, std::vector<Element*>&&, size_t nSize, Amount fees);
+		void ResetTemplate();
 
 		Element* AddValidTx(Transaction::Ptr&&, const Transaction::Context&, const Transaction::KeyType&, uint32_t nSizeCorrection);
 		void SetOutdated(Element&, Height);
@@ -95,11 +166,26 @@ struct TxPool
 		void Release(Element&);
 		void Clear();
 
+		// lookup by content. Returned ptrs are valid until the pool is modified
+		const TxKernel* FindKernel(const Merkle::Hash&) const;
+		const beam::Output* FindOutput(const ECC::Hash::Value&) const;
+
+		// valid (not outdated) txs that conflict with the given one
+		void get_Rivals(const Element&, std::vector<Element*>&) const;
+
+		// output key covers all the output data (incl. rangeproof), not just the commitment
+		static void get_OutputKey(ECC::Hash::Value&, const beam::Output&);
+
+		Fluff();
 		~Fluff() { Clear(); }
 
 	private:
 		void InternalInsert(Element&);
 		void InternalErase(Element&);
+		void InsertContent(Element&);
+		void DeleteContent(Element&);
+		void InsertSpends(Element&, const std::vector<TxKernel::Ptr>&);
+		static uint32_t get_MemSize(const Element&);
 	};
 
 	struct Stem
@@ -144,6 +230,9 @@ struct TxPool
 			HeightRange m_Height;
 			Amount m_FeeReserve;
 
+			Block::SystemState::ID m_CtxID; // the tip at which the tx context was validated. Zero if unknown
+			uint32_t m_Received_ms; // for stats
+
 			std::vector<Kernel> m_vKrn;
 		};
 
@@ -181,6 +270,13 @@ struct TxPool
 		virtual bool ValidateTxContext(const Transaction&, const HeightRange&, const AmountBig::Type& fees, Amount& feeReserve) = 0; // assuming context-free validation is already performed, but 
 		virtual void OnTimedOut(Element&) = 0;
 
+		// Validate the merge of 2 txs, each of them was already validated. By default the merged tx is validated in its entirety.
+		// Overrides may skip the parts that are known to be valid (update the target ctx, once validated).
+		virtual bool ValidateMerged(Element& trg, const Element& src, const Transaction& txNew, const HeightRange& hr, const AmountBig::Type& fees, Amount& feeReserve)
+		{
+			return ValidateTxContext(txNew, hr, fees, feeReserve);
+		}
+
 	private:
 		void DeleteRaw(Element&);
 		void SetTimerRaw(uint32_t nTimeout_ms);
@@ -27,6 +27,7 @@
 #include "../../core/unittest/mini_blockchain.h"
 #include "../../bvm/bvm2.h"
 #include "../../bvm/ManagerStd.h"
+#include <boost/filesystem.hpp>
 
 #ifndef LOG_VERBOSE_ENABLED
     #define LOG_VERBOSE_ENABLED 0
@@ -457,61 +458,47 @@ namespace beam
 		tr.Commit();
 		tr.Start(db);
 
+		NodeDB::WalkerPeer::Data dPeer;
+
 		for (int i = 0; i < 20; i++)
 		{
-			NodeDB::WalkerPeer::Data d;
+			NodeDB::WalkerPeer::Data& d = dPeer;
 			ECC::SetRandom(d.m_ID);
 			d.m_Address = i * 17;
 			d.m_LastSeen = i + 10;
 			d.m_Rating = i * 100 + 50;
+			d.m_Throughput_Bps = i * 1000;
+			d.m_Latency_ms = i + 1;
 
-			db.PeerIns(d);
+			db.PeerSave(d);
 		}
 
-		NodeDB::WalkerPeer wlkp;
-		for (db.EnumPeers(wlkp); wlkp.MoveNext(); )
-			;
-
-		db.PeersDel();
-
-		for (db.EnumPeers(wlkp); wlkp.MoveNext(); )
-			;
-
+		// update in-place
+		dPeer.m_Rating = 7;
+		dPeer.m_Latency_ms = 150;
+		db.PeerSave(dPeer);
 
-		NodeDB::WalkerBbs::Data dBbs;
-
-		for (uint32_t i = 0; i < 200; i++)
+		uint32_t nPeers = 0;
+		NodeDB::WalkerPeer wlkp;
+		for (db.EnumPeers(wlkp); wlkp.MoveNext(); nPeers++)
 		{
-			dBbs.m_Key = i;
-			dBbs.m_Channel = i % 7;
-			dBbs.m_TimePosted = i + 100;
-			dBbs.m_Message.p = "hello";
-			dBbs.m_Message.n = 5;
-
-			db.BbsIns(dBbs);
+			if (wlkp.m_Data.m_ID == dPeer.m_ID)
+				verify_test((wlkp.m_Data.m_Rating == 7) && (wlkp.m_Data.m_Latency_ms == 150) && (wlkp.m_Data.m_Throughput_Bps == dPeer.m_Throughput_Bps));
 		}
+		verify_test(20 == nPeers);
 
-		NodeDB::WalkerBbs wlkbbs;
-		wlkbbs.m_Data = dBbs;
-		verify_test(db.BbsFind(wlkbbs));
+		db.PeerDel(dPeer.m_ID);
 
-		wlkbbs.m_Data.m_Key.Inc();
-		verify_test(!db.BbsFind(wlkbbs));
+		nPeers = 0;
+		for (db.EnumPeers(wlkp); wlkp.MoveNext(); nPeers++)
+			verify_test(!(wlkp.m_Data.m_ID == dPeer.m_ID));
+		verify_test(19 == nPeers);
 
+		db.PeersDel();
 
-		for (wlkbbs.m_Data.m_Channel = 0; wlkbbs.m_Data.m_Channel < 7; wlkbbs.m_Data.m_Channel++)
-		{
-			wlkbbs.m_ID = 0;
-			for (db.EnumBbsCSeq(wlkbbs); wlkbbs.MoveNext(); )
-				;
-		}
+		for (db.EnumPeers(wlkp); wlkp.MoveNext(); )
+			;
 
-		for (wlkbbs.m_Data.m_Channel = 0; wlkbbs.m_Data.m_Channel < 7; wlkbbs.m_Data.m_Channel++)
-		{
-			wlkbbs.m_ID = 0;
-			for (db.EnumBbsCSeq(wlkbbs); wlkbbs.MoveNext(); )
-				;
-		}
 
 		Key::ID kid(Zero);
 		kid.m_Idx = 345;
@@ -812,6 +799,131 @@ namespace beam
 		}
 	}
 
+	void DeleteBbsStore(const char* szDb)
+	{
+		std::string sPath;
+		NodeProcessor::get_DbSiblingPath(sPath, szDb, "-bbs");
+
+		boost::system::error_code ec;
+		boost::filesystem::remove_all(sPath, ec);
+	}
+
+	void TestBbsStore()
+	{
+		DeleteBbsStore(g_sz);
+
+		std::string sPath;
+		NodeProcessor::get_DbSiblingPath(sPath, g_sz, "-bbs");
+
+		const uint32_t nMsgs = 200;
+		const uint32_t nChannels = 7;
+
+		{
+			BbsStore bs;
+			bs.m_Params.m_SegmentDuration_s = 10; // 20 segments
+			bs.Open(sPath.c_str());
+			verify_test(!bs.get_Totals().m_Count);
+
+			BbsStore::Data d;
+			d.m_Message.p = "hello";
+			d.m_Message.n = 5;
+
+			for (uint32_t i = 0; i < nMsgs; i++)
+			{
+				d.m_Key = i + 1;
+				d.m_Channel = i % nChannels;
+				d.m_TimePosted = i + 100;
+				d.m_Nonce = i;
+
+				verify_test(bs.Insert(d) == i + 1);
+			}
+
+			verify_test(bs.get_Totals().m_Count == nMsgs);
+			verify_test(bs.get_Totals().m_Size == nMsgs * 5);
+			verify_test(bs.get_MaxTime() == nMsgs + 99);
+		}
+
+		BbsStore bs;
+		bs.m_Params.m_SegmentDuration_s = 10;
+		bs.Open(sPath.c_str()); // the index must be rebuilt
+		verify_test(bs.get_Totals().m_Count == nMsgs);
+		verify_test(bs.get_LastID() == nMsgs);
+
+		BbsStore::Data d;
+		ByteBuffer buf;
+		BbsStore::Key key = 17U;
+		verify_test(bs.Find(key, d, buf));
+		verify_test((d.m_Channel == 16 % nChannels) && (d.m_TimePosted == 116) && (d.m_Nonce == 16));
+		verify_test((d.m_Message.n == 5) && !memcmp(d.m_Message.p, "hello", 5));
+
+		key = nMsgs + 1;
+		verify_test(!bs.Find(key));
+
+		for (BbsChannel c = 0; c < nChannels; c++)
+		{
+			BbsStore::WalkerChannel wlk;
+			wlk.m_Data.m_Channel = c;
+			wlk.m_ID = 0;
+
+			uint32_t n = 0;
+			for (bs.EnumChannelSeq(wlk); wlk.MoveNext(); n++)
+			{
+				verify_test(wlk.m_Data.m_Channel == c);
+				verify_test(wlk.m_ID == c + n * nChannels + 1);
+			}
+			verify_test(n == (nMsgs - c + nChannels - 1) / nChannels);
+		}
+
+		verify_test(bs.FindCursor(150) == 51);
+
+		// drop the segments with all the messages older than 150
+		BbsStore::Totals lim;
+		lim.m_Count = nMsgs;
+		lim.m_Size = nMsgs * 5;
+		bs.Cleanup(150, lim);
+
+		verify_test(bs.get_Totals().m_Count == nMsgs - 50);
+
+		BbsStore::WalkerSeq wlk;
+		wlk.m_ID = 0;
+		bs.EnumAllSeq(wlk);
+		verify_test(wlk.MoveNext() && (wlk.m_ID == 51));
+
+		key = 50U;
+		verify_test(!bs.Find(key));
+
+		// the new messages are appended
+		d.m_Key = nMsgs + 1;
+		d.m_Channel = 0;
+		d.m_TimePosted = nMsgs + 100;
+		d.m_Message.p = "hello";
+		d.m_Message.n = 5;
+		verify_test(bs.Insert(d) == nMsgs + 1);
+
+		// not flushed yet, must be readable anyway
+		key = nMsgs + 1;
+		verify_test(bs.Find(key, d, buf));
+		verify_test((d.m_TimePosted == nMsgs + 100) && (d.m_Message.n == 5) && !memcmp(d.m_Message.p, "hello", 5));
+
+		// posting times aren't monotonic
+		d.m_Key = nMsgs + 2;
+		d.m_TimePosted = 160;
+		d.m_Message.p = "hello";
+		verify_test(bs.Insert(d) == nMsgs + 2);
+		bs.Flush();
+
+		verify_test(bs.FindCursor(nMsgs + 100) == nMsgs + 1);
+		verify_test(bs.FindCursor(nMsgs + 101) == nMsgs + 3);
+
+		// over the count limit
+		lim.m_Count = 10;
+		bs.Cleanup(0, lim);
+		verify_test(bs.get_Totals().m_Count <= lim.m_Count);
+
+		bs.Close();
+		DeleteBbsStore(g_sz);
+	}
+
 	struct MiniWallet
 	{
 		Key::IKdf::Ptr m_pKdf;
@@ -1049,10 +1161,104 @@ namespace beam
 
 		const Height hIncubation = 3; // artificial incubation period for outputs.
 
+		auto fnAddTx = [&np](Transaction::Ptr&& pTx) -> TxPool::Fluff::Element*
+		{
+			Transaction::Context::Params pars;
+			Transaction::Context ctx(pars);
+			ctx.m_Height = np.m_Cursor.m_Sid.m_Height + 1;
+			verify_test(pTx->IsValid(ctx));
+
+			Transaction::KeyType key;
+			pTx->get_Key(key);
+
+			return np.m_TxPool.AddValidTx(std::move(pTx), ctx, key, 0);
+		};
+
 		for (Height h = Rules::HeightGenesis; h < 96 + Rules::HeightGenesis; h++)
 		{
-			while (true)
+			TxPool::Fluff::Element* pA = nullptr;
+			TxPool::Fluff::Element* pAB = nullptr;
+
+			if (40 == h)
+			{
+				// package selection. A has the higher fee rate, but the aggregated AB has more fees. They are rivals, AB should be selected
+				Transaction::Ptr pA0, pB0;
+				Amount val = np.m_Wallet.MakeTxInput(pA0, np.m_Cursor.m_ID.m_Height);
+				verify_test(val);
+				np.m_Wallet.MakeTxOutput(*pA0, np.m_Cursor.m_ID.m_Height, hIncubation, val, 10900000 * 16);
+
+				val = np.m_Wallet.MakeTxInput(pB0, np.m_Cursor.m_ID.m_Height);
+				verify_test(val);
+				np.m_Wallet.MakeTxOutput(*pB0, np.m_Cursor.m_ID.m_Height, hIncubation, val, 10900000 * 4);
+
+				Transaction::Ptr pAB0 = std::make_shared<Transaction>();
+				TxVectors::Writer wtx(*pAB0, *pAB0);
+				volatile bool bStop = false;
+				wtx.Combine(pA0->get_Reader(), pB0->get_Reader(), bStop);
+				pAB0->m_Offset = ECC::Scalar::Native(pA0->m_Offset) + ECC::Scalar::Native(pB0->m_Offset);
+
+				pA = fnAddTx(std::move(pA0));
+				pAB = fnAddTx(std::move(pAB0));
+				verify_test(pA->m_Profit < pAB->m_Profit);
+			}
+
+			if (50 == h)
+			{
+				// displacement. The template isn't full, but a new better tx doesn't fit into the remaining space.
+				// The full rebuild would select it instead of the worse one, the incremental must do the same
+				Transaction::Ptr pTx;
+				Amount val = np.m_Wallet.MakeTxInput(pTx, np.m_Cursor.m_ID.m_Height);
+				verify_test(val);
+				np.m_Wallet.MakeTxOutput(*pTx, np.m_Cursor.m_ID.m_Height, hIncubation, val);
+				TxPool::Fluff::Element* pLo = fnAddTx(std::move(pTx));
+
+				NodeProcessor::BlockContext bc(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+				verify_test(np.GenerateNewBlock(bc));
+
+				std::vector<TxPool::Fluff::Element*> vSel = np.m_TxPool.m_Template.m_vElems;
+				verify_test(std::find(vSel.begin(), vSel.end(), pLo) != vSel.end());
+
+				val = np.m_Wallet.MakeTxInput(pTx, np.m_Cursor.m_ID.m_Height);
+				verify_test(val);
+				np.m_Wallet.MakeTxOutput(*pTx, np.m_Cursor.m_ID.m_Height, hIncubation, val, 10900000 * 4);
+				TxPool::Fluff::Element* pHi = fnAddTx(std::move(pTx));
+				verify_test(pHi->m_Profit < pLo->m_Profit);
+
+				size_t nSizeMax0 = Rules::get().MaxBodySize;
+				Rules::get().MaxBodySize = np.m_TxPool.m_Template.m_nSize + pHi->m_Profit.m_nSize - 1;
+
+				NodeProcessor::BlockContext bc2(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+				verify_test(np.GenerateNewBlock(bc2));
+				vSel = np.m_TxPool.m_Template.m_vElems;
+
+				np.m_TxPool.ResetTemplate();
+
+				NodeProcessor::BlockContext bc3(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+				verify_test(np.GenerateNewBlock(bc3));
+				std::vector<TxPool::Fluff::Element*> vSel2 = np.m_TxPool.m_Template.m_vElems;
+
+				Rules::get().MaxBodySize = nSizeMax0;
+				np.m_TxPool.ResetTemplate(); // with the original limit both should be included in this block
+
+				verify_test(std::find(vSel.begin(), vSel.end(), pHi) != vSel.end());
+				verify_test(std::find(vSel.begin(), vSel.end(), pLo) == vSel.end());
+				verify_test(bc2.m_Fees == bc3.m_Fees);
+
+				std::sort(vSel.begin(), vSel.end());
+				std::sort(vSel2.begin(), vSel2.end());
+				verify_test(vSel == vSel2);
+			}
+
+			for (uint32_t nTxs = 0; ; nTxs++)
 			{
+				if (1 == nTxs)
+				{
+					// build the template with the 1st tx, the rest should be appended incrementally
+					NodeProcessor::BlockContext bc(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+					verify_test(np.GenerateNewBlock(bc));
+					verify_test(np.m_TxPool.m_Template.m_Tip == np.m_Cursor.m_ID);
+				}
+
 				// Spend it in a transaction
 				Transaction::Ptr pTx;
 				if (!np.m_Wallet.MakeTx(pTx, np.m_Cursor.m_ID.m_Height, hIncubation))
@@ -1077,6 +1283,51 @@ namespace beam
 			NodeProcessor::BlockContext bc(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
 			verify_test(np.GenerateNewBlock(bc));
 
+			if (pA)
+			{
+				const std::vector<TxPool::Fluff::Element*>& v = np.m_TxPool.m_Template.m_vElems;
+				verify_test(std::find(v.begin(), v.end(), pAB) != v.end());
+				verify_test(std::find(v.begin(), v.end(), pA) == v.end());
+				verify_test(!pA->IsOutdated()); // not outdated, until AB is in the chain
+
+				// rolling min fee rate
+				verify_test(!np.m_TxPool.IsBelowMinRate(pA->m_Profit));
+				np.m_TxPool.RaiseMinRate(pAB->m_Profit);
+				verify_test(np.m_TxPool.IsBelowMinRate(pAB->m_Profit));
+				verify_test(!np.m_TxPool.IsBelowMinRate(pA->m_Profit));
+
+				for (uint32_t i = 0; i < 128; i++)
+					np.m_TxPool.DecayMinRate();
+				verify_test(!np.m_TxPool.IsBelowMinRate(pAB->m_Profit));
+			}
+
+			{
+				// memory accounting
+				uint64_t nMemSize = 0;
+				for (TxPool::Fluff::ProfitSet::iterator it = np.m_TxPool.m_setProfit.begin(); np.m_TxPool.m_setProfit.end() != it; ++it)
+					nMemSize += it->get_ParentObj().m_nMemSize;
+				for (TxPool::Fluff::OutdatedSet::iterator it = np.m_TxPool.m_setOutdated.begin(); np.m_TxPool.m_setOutdated.end() != it; ++it)
+					nMemSize += it->get_ParentObj().m_nMemSize;
+				verify_test(np.m_TxPool.m_TotalMemSize == nMemSize);
+			}
+
+			{
+				// full rebuild should select the same
+				std::vector<TxPool::Fluff::Element*> vSel = np.m_TxPool.m_Template.m_vElems;
+				np.m_TxPool.ResetTemplate();
+
+				NodeProcessor::BlockContext bc2(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+				verify_test(np.GenerateNewBlock(bc2));
+				verify_test(bc2.m_Fees == bc.m_Fees);
+				verify_test(bc2.m_Block.m_vKernels.size() == bc.m_Block.m_vKernels.size());
+
+				// the order may differ
+				std::vector<TxPool::Fluff::Element*> vSel2 = np.m_TxPool.m_Template.m_vElems;
+				std::sort(vSel.begin(), vSel.end());
+				std::sort(vSel2.begin(), vSel2.end());
+				verify_test(vSel == vSel2);
+			}
+
 			np.OnState(bc.m_Hdr, PeerID());
 
 			Block::SystemState::ID id;
@@ -1577,124 +1828,1643 @@ namespace beam
 		struct MyClient
 			:public proto::NodeConnection
 		{
-			Node* m_ppNode[2];
-			unsigned int m_iNode;
-			unsigned int m_WaitingCycles;
+			Node* m_ppNode[2];
+			unsigned int m_iNode;
+			unsigned int m_WaitingCycles;
+
+			Height m_HeightMax;
+			const Height m_HeightTrg = 70;
+
+			MyClient()
+			{
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+			}
+
+			virtual void OnConnectedSecure() override {
+				OnTimer();
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override {
+				fail_test("OnDisconnect");
+			}
+
+			io::Timer::Ptr m_pTimer;
+
+			void OnTimer() {
+
+
+				if (m_HeightMax < m_HeightTrg)
+				{
+					Node& n = *m_ppNode[m_iNode];
+
+					TxPool::Fluff txPool; // empty, no transactions
+					NodeProcessor::BlockContext bc(txPool, 0, *n.m_Keys.m_pMiner, *n.m_Keys.m_pMiner);
+
+					verify_test(n.get_Processor().GenerateNewBlock(bc));
+
+					n.get_Processor().OnState(bc.m_Hdr, PeerID());
+
+					Block::SystemState::ID id;
+					bc.m_Hdr.get_ID(id);
+
+					n.get_Processor().OnBlock(id, bc.m_BodyP, bc.m_BodyE, PeerID());
+					n.get_Processor().TryGoUp();
+
+					std::setmax(m_HeightMax, bc.m_Hdr.m_Height);
+
+					printf("Mined block Height = %u, node = %u \n", (unsigned int) bc.m_Hdr.m_Height, (unsigned int)m_iNode);
+
+					++m_iNode %= _countof(m_ppNode);
+				}
+				else
+					if (m_WaitingCycles++ > 60)
+					{
+						fail_test("Blockchain height didn't reach target");
+						io::Reactor::get_Current().stop();
+					}
+
+				SetTimer(100);
+			}
+
+			virtual void OnMsg(proto::NewTip&& msg) override
+			{
+				printf("Tip Height=%u\n", (unsigned int) msg.m_Description.m_Height);
+				verify_test(msg.m_Description.m_Height <= m_HeightMax);
+				if (msg.m_Description.m_Height == m_HeightTrg)
+					io::Reactor::get_Current().stop();
+			}
+
+			void SetTimer(uint32_t timeout_ms) {
+				m_pTimer->start(timeout_ms, false, [this]() { return (this->OnTimer)(); });
+			}
+		};
+
+		MyClient cl;
+		cl.m_iNode = 0;
+		cl.m_HeightMax = 0;
+		cl.m_WaitingCycles = 0;
+		cl.m_ppNode[0] = &node;
+		cl.m_ppNode[1] = &node2;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port + 1);
+
+		cl.Connect(addr);
+
+
+		pReactor->run();
+
+		node.GenerateRecoveryInfo(g_sz3);
+
+		struct MyParser :public RecoveryInfo::IParser
+		{
+			Key::IPKdf::Ptr m_pOwner1;
+			Key::IPKdf::Ptr m_pOwner2;
+			uint32_t m_nUnrecognized = 0;
+
+			virtual bool OnUtxo(Height h, const Output& outp) override
+			{
+				verify_test(outp.m_RecoveryOnly);
+
+				CoinID cid;
+				bool b1 = outp.Recover(h, *m_pOwner1, cid);
+				bool b2 = outp.Recover(h, *m_pOwner2, cid);
+				if (!(b1 || b2))
+				{
+					verify_test(!h); // treasury
+					m_nUnrecognized++;
+					verify_test(m_nUnrecognized <= 1);
+				}
+
+				return true;
+			}
+		} parser;
+		parser.m_pOwner1 = node.m_Keys.m_pOwner;
+		parser.m_pOwner2 = node2.m_Keys.m_pOwner;
+
+		verify_test(parser.Proceed(g_sz3));
+
+		DeleteFile(g_sz3);
+	}
+
+	struct ExecutorBlocker
+	{
+		// occupies an executor thread until released
+		std::mutex m_Mutex;
+		std::condition_variable m_Cv;
+		bool m_Released = false;
+
+		struct Task
+			:public Executor::TaskAsync
+		{
+			ExecutorBlocker* m_pThis;
+
+			virtual void Exec(Executor::Context&) override
+			{
+				std::unique_lock<std::mutex> scope(m_pThis->m_Mutex);
+				while (!m_pThis->m_Released)
+					m_pThis->m_Cv.wait(scope);
+			}
+		};
+
+		void Block(Executor& ex)
+		{
+			std::unique_ptr<Task> pTask(new Task);
+			pTask->m_pThis = this;
+			ex.Push(std::move(pTask));
+		}
+
+		void Release()
+		{
+			std::unique_lock<std::mutex> scope(m_Mutex);
+			m_Released = true;
+			m_Cv.notify_all();
+		}
+	};
+
+	void MineBlockAt(Node& n)
+	{
+		TxPool::Fluff txPool; // empty, no transactions
+		NodeProcessor::BlockContext bc(txPool, 0, *n.m_Keys.m_pMiner, *n.m_Keys.m_pMiner);
+
+		verify_test(n.get_Processor().GenerateNewBlock(bc));
+
+		n.get_Processor().OnState(bc.m_Hdr, PeerID());
+
+		Block::SystemState::ID id;
+		bc.m_Hdr.get_ID(id);
+
+		n.get_Processor().OnBlock(id, bc.m_BodyP, bc.m_BodyE, PeerID());
+		n.get_Processor().TryGoUp();
+	}
+
+	void TestNodeBbsFlood()
+	{
+		// Flood the node with BBS messages, while their verification is stuck. The block processing must not wait for it.
+		// The flooding peer is limited, the messages from another peer are still accepted.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_VerificationThreads = 2;
+		node.m_Cfg.m_Bbs.m_MaxPendingVerifyPerPeer = 100;
+		node.m_Cfg.m_Bbs.m_MaxPendingVerify = 150;
+		const uint32_t nPerPeer = node.m_Cfg.m_Bbs.m_MaxPendingVerifyPerPeer;
+		ECC::SetRandom(node);
+
+		node.Initialize();
+
+		ExecutorBlocker blk;
+		blk.Block(node.get_ExecutorBg());
+
+		const uint32_t nFlood = 500;
+		const uint32_t nOther = 20;
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			uint8_t m_iTag = 0;
+			uint32_t m_nMsgs = 0; // to send
+			uint32_t m_pReceived[2] = { 0 }; // per sender
+			bool m_bSent = false;
+
+			virtual void OnConnectedSecure() override
+			{
+				SendLogin();
+
+				proto::BbsSubscribe msgSub;
+				msgSub.m_Channel = 5;
+				msgSub.m_On = true;
+				Send(msgSub);
+
+				for (uint32_t i = 0; i < m_nMsgs; i++)
+				{
+					proto::BbsMsg msg;
+					msg.m_Channel = 5;
+					msg.m_TimePosted = getTimestamp();
+					msg.m_Message.resize(sizeof(i) + 1);
+					msg.m_Message.front() = m_iTag;
+					memcpy(&msg.m_Message.front() + 1, &i, sizeof(i));
+					Send(msg);
+				}
+
+				m_bSent = true;
+			}
+
+			virtual void OnMsg(proto::BbsMsg&& msg) override
+			{
+				verify_test(!msg.m_Message.empty() && (msg.m_Message.front() < _countof(m_pReceived)));
+				m_pReceived[msg.m_Message.front()]++;
+			}
+
+			bool IsReceived(uint32_t n0, uint32_t n1) const
+			{
+				return (m_pReceived[0] == n0) && (m_pReceived[1] == n1);
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
+			}
+		};
+
+		MyClient pCl[2];
+		pCl[0].m_nMsgs = nFlood;
+		pCl[1].m_iTag = 1;
+		pCl[1].m_nMsgs = nOther;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+
+		pCl[0].Connect(addr);
+
+		io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
+		uint32_t nCycles = 0;
+
+		std::function<void()> fnOnTimer = [&]()
+		{
+			nCycles++;
+
+			if (1 == nCycles)
+				pCl[1].Connect(addr); // after the flood
+			else
+			{
+				if (5 == nCycles)
+				{
+					verify_test(pCl[0].m_bSent && pCl[1].m_bSent);
+
+					// the verification is stuck, yet the blocks are processed
+					Height h0 = node.get_Processor().m_Cursor.m_ID.m_Height;
+					for (uint32_t i = 0; i < 3; i++)
+						MineBlockAt(node);
+
+					verify_test(node.get_Processor().m_Cursor.m_ID.m_Height == h0 + 3);
+					verify_test(pCl[0].IsReceived(0, 0) && pCl[1].IsReceived(0, 0));
+
+					blk.Release();
+				}
+
+				// the flood is cut at the per-peer limit, the other peer's messages fit the total
+				if ((nCycles > 5) && pCl[0].IsReceived(nPerPeer, nOther) && pCl[1].IsReceived(nPerPeer, nOther))
+				{
+					io::Reactor::get_Current().stop();
+					return;
+				}
+
+				if (nCycles > 100)
+				{
+					fail_test("BBS messages not received");
+					io::Reactor::get_Current().stop();
+					return;
+				}
+			}
+
+			pTimer->start(100, false, fnOnTimer);
+		};
+
+		pTimer->start(200, false, fnOnTimer);
+		pReactor->run();
+
+		blk.Release(); // in case of failure
+		verify_test(pCl[0].IsReceived(nPerPeer, nOther));
+		verify_test(pCl[1].IsReceived(nPerPeer, nOther));
+	}
+
+	void TestNodeDandelionDummies()
+	{
+		// The stem aggregation takes the dummy outputs from the pool. Those created wrt another fork are dropped once the tip moves (incl. reorg)
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		MiniWallet wallet;
+		ECC::SetRandom(wallet.m_pKdf);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Keys.SetSingleKey(wallet.m_pKdf);
+
+		node.m_Cfg.m_Dandelion.m_AggregationTime_ms = 0;
+		node.m_Cfg.m_Dandelion.m_OutputsMin = 3;
+		node.m_Cfg.m_Dandelion.m_DummyLifetimeLo = 5;
+		node.m_Cfg.m_Dandelion.m_DummyLifetimeHi = 10;
+		node.m_Cfg.m_Dandelion.m_DummyPoolSize = 4;
+
+		node.Initialize();
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			Node* m_pNode;
+			MiniWallet* m_pWallet;
+			uint32_t m_iStage = 0;
+			uint32_t m_nCycles = 0;
+			io::Timer::Ptr m_pTimer;
+
+			virtual void OnConnectedSecure() override
+			{
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+				OnTimer();
+			}
+
+			void MineTo(Height h)
+			{
+				while (m_pNode->get_Processor().m_Cursor.m_ID.m_Height < h)
+				{
+					MineBlockAt(*m_pNode);
+
+					Height hTip = m_pNode->get_Processor().m_Cursor.m_ID.m_Height;
+					m_pWallet->AddMyUtxo(CoinID(Rules::get_Emission(hTip), hTip, Key::Type::Coinbase));
+				}
+			}
+
+			void SendStemTx()
+			{
+				Height h = m_pNode->get_Processor().m_Cursor.m_ID.m_Height;
+
+				proto::NewTransaction msgTx;
+				msgTx.m_Fluff = false;
+
+				Amount val = m_pWallet->MakeTxInput(msgTx.m_Transaction, h);
+				verify_test(val);
+				m_pWallet->MakeTxOutput(*msgTx.m_Transaction, h, 0, val);
+
+				verify_test(msgTx.m_Transaction->m_vOutputs.size() < m_pNode->m_Cfg.m_Dandelion.m_OutputsMin);
+				Send(msgTx);
+			}
+
+			bool IsPoolFull() const
+			{
+				const Node::DandelionStats& st = m_pNode->get_DandelionStats();
+				return st.m_DummiesGenerated >= st.m_DummiesPooled + st.m_DummiesDropped + m_pNode->m_Cfg.m_Dandelion.m_DummyPoolSize;
+			}
+
+			void OnTimer()
+			{
+				const Node::DandelionStats& st = m_pNode->get_DandelionStats();
+				const uint32_t nPool = m_pNode->m_Cfg.m_Dandelion.m_DummyPoolSize;
+
+				switch (m_iStage)
+				{
+				case 0:
+					if (!IsPoolFull())
+						break;
+
+					// the coinbase of the 1st block matures at this height, all the blocks are still before the fork
+					MineTo(1 + Rules::get().Maturity.Coinbase);
+					verify_test(!st.m_DummiesDropped);
+
+					SendStemTx();
+					m_iStage++;
+					break;
+
+				case 1:
+					if (!st.m_Aggregated || !IsPoolFull())
+						break;
+
+					verify_test(st.m_DummiesPooled == 2);
+					verify_test(!st.m_DummiesInline);
+
+					// the next block belongs to the next fork
+					MineTo(Rules::get().pForks[1].m_Height - 1);
+					verify_test(st.m_DummiesDropped == nPool);
+
+					m_iStage++;
+					break;
+
+				case 2:
+					if (!IsPoolFull())
+						break;
+
+					// reorg back to the previous fork
+					m_pNode->get_Processor().ManualRollbackTo(Rules::get().pForks[1].m_Height - 2);
+					verify_test(st.m_DummiesDropped == nPool * 2);
+
+					m_iStage++;
+					break;
+
+				default:
+					if (!IsPoolFull())
+						break;
+
+					io::Reactor::get_Current().stop();
+					return;
+				}
+
+				if (++m_nCycles > 600)
+				{
+					fail_test("Dandelion dummies stuck");
+					io::Reactor::get_Current().stop();
+					return;
+				}
+
+				m_pTimer->start(100, false, [this]() { OnTimer(); });
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
+			}
+		};
+
+		MyClient cl;
+		cl.m_pNode = &node;
+		cl.m_pWallet = &wallet;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+
+		cl.Connect(addr);
+		pReactor->run();
+
+		verify_test(cl.m_iStage == 3);
+	}
+
+	void TestNodeCompactBlocks()
+	{
+		// The node restores the new blocks from its tx pool. Covers the full restore, partial (missing elements are requested),
+		// and the mismatch (pool version of the element differs) with the fallback to the full body download.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		MiniWallet wallet;
+		ECC::SetRandom(wallet.m_pKdf);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_CompactBlocks = true;
+		node.m_Keys.SetSingleKey(wallet.m_pKdf);
+
+		node.Initialize();
+
+		// the txs are created after Fork1, and remain valid in all the test blocks
+		while (node.get_Processor().m_Cursor.m_ID.m_Height < std::max<Height>(3 + Rules::get().Maturity.Coinbase, Rules::get().pForks[1].m_Height))
+		{
+			MineBlockAt(node);
+
+			Height hTip = node.get_Processor().m_Cursor.m_ID.m_Height;
+			wallet.AddMyUtxo(CoinID(Rules::get_Emission(hTip), hTip, Key::Type::Coinbase));
+		}
+
+		const Height h0 = node.get_Processor().m_Cursor.m_ID.m_Height;
+
+		struct MyPeer
+			:public proto::NodeConnection
+		{
+			Node* m_pNode;
+			MiniWallet m_Miner;
+
+			std::vector<Transaction::Ptr> m_vTxs; // sent to the node
+			Transaction::Ptr m_pTxAlt; // same as the last one, but the kernel is re-signed
+
+			uint32_t m_nStatus = 0;
+			uint32_t m_iStage = 0;
+			uint32_t m_nCycles = 0;
+			uint32_t m_nCompact = 0;
+			uint32_t m_nParts = 0;
+			uint32_t m_nPack = 0;
+			Height m_hTrg = 0;
+
+			TxPool::Fluff m_TxPool;
+			Transaction::Ptr m_pTxCur; // in the block
+			std::unique_ptr<NodeProcessor::BlockContext> m_pBc;
+			io::Timer::Ptr m_pTimer;
+
+			MyPeer()
+			{
+				ECC::SetRandom(m_Miner.m_pKdf);
+			}
+
+			virtual void OnConnectedSecure() override
+			{
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+
+				SendLogin();
+
+				// not a node yet, each tx is replied
+				for (size_t i = 0; i < m_vTxs.size(); i++)
+				{
+					proto::NewTransaction msg;
+					msg.m_Transaction = m_vTxs[i];
+					msg.m_Fluff = true;
+					Send(msg);
+				}
+			}
+
+			virtual void OnMsg(proto::Status&& msg) override
+			{
+				verify_test(proto::TxStatus::Ok == msg.m_Value);
+				if (++m_nStatus < m_vTxs.size())
+					return;
+
+				ECC::Scalar::Native sk;
+				ECC::SetRandom(sk);
+				ProveID(sk, proto::IDType::Node);
+
+				NewBlock();
+				OnTimer();
+			}
+
+			void NewBlock()
+			{
+				m_pTxCur = (m_iStage < 2) ? m_vTxs[m_iStage] : m_pTxAlt;
+				Transaction::Ptr pTx = m_pTxCur;
+
+				Transaction::Context::Params pars;
+				Transaction::Context ctx(pars);
+				ctx.m_Height = m_pNode->get_Processor().m_Cursor.m_ID.m_Height + 1;
+				verify_test(pTx->IsValid(ctx));
+
+				Transaction::KeyType key;
+				pTx->get_Key(key);
+
+				m_TxPool.Clear();
+				m_TxPool.AddValidTx(std::move(pTx), ctx, key, 0);
+
+				m_pBc.reset(new NodeProcessor::BlockContext(m_TxPool, 0, *m_Miner.m_pKdf, *m_Miner.m_pKdf));
+				verify_test(m_pNode->get_Processor().GenerateNewBlock(*m_pBc));
+
+				m_hTrg = m_pBc->m_Hdr.m_Height;
+
+				proto::NewTip msg;
+				msg.m_Description = m_pBc->m_Hdr;
+				Send(msg);
+			}
+
+			bool IsGetBodyOk(const Block::SystemState::ID& id) const
+			{
+				if (!m_pBc)
+					return false;
+
+				Block::SystemState::ID idTrg;
+				m_pBc->m_Hdr.get_ID(idTrg);
+				return id == idTrg;
+			}
+
+			virtual void OnMsg(proto::GetBodyCompact&& msg) override
+			{
+				verify_test(IsGetBodyOk(msg.m_ID));
+				m_nCompact++;
+
+				const Block::Body& block = m_pBc->m_Block;
+				const Transaction& txPool = *m_pTxCur; // same kernel IDs/output keys as in the node pool
+
+				proto::BodyCompact msgOut;
+				msgOut.m_Included = std::make_shared<Transaction>();
+				Transaction& tx = *msgOut.m_Included;
+
+				tx.m_Offset = block.m_Offset;
+				for (const auto& pInp : block.m_vInputs)
+				{
+					tx.m_vInputs.emplace_back(new Input);
+					*tx.m_vInputs.back() = *pInp;
+				}
+
+				msgOut.m_Outputs.resize(block.m_vOutputs.size());
+				for (size_t i = 0; i < block.m_vOutputs.size(); i++)
+				{
+					const Output& outp = *block.m_vOutputs[i];
+					TxPool::Fluff::get_OutputKey(msgOut.m_Outputs[i], outp);
+
+					bool bInPool = false;
+					for (const auto& pOutp : txPool.m_vOutputs)
+						if (pOutp->m_Commitment == outp.m_Commitment)
+							bInPool = true;
+
+					if (!bInPool)
+					{
+						tx.m_vOutputs.emplace_back(new Output);
+						*tx.m_vOutputs.back() = outp;
+					}
+				}
+
+				msgOut.m_Kernels.resize(block.m_vKernels.size());
+				for (size_t i = 0; i < block.m_vKernels.size(); i++)
+				{
+					const TxKernel& krn = *block.m_vKernels[i];
+					msgOut.m_Kernels[i] = krn.m_Internal.m_ID;
+
+					bool bInPool = false;
+					for (const auto& pKrn : txPool.m_vKernels)
+						if (pKrn->m_Internal.m_ID == krn.m_Internal.m_ID)
+							bInPool = true;
+
+					// for the partial restore the kernels not in the node pool are omitted, they should be requested
+					if (!bInPool && (1 != m_iStage))
+					{
+						tx.m_vKernels.emplace_back();
+						krn.Clone(tx.m_vKernels.back());
+					}
+				}
+
+				proto::BodyBuffers bb;
+				bb.m_Perishable = m_pBc->m_BodyP;
+				bb.m_Eternal = m_pBc->m_BodyE;
+				bb.get_Checksum(msgOut.m_Checksum);
+
+				Send(msgOut);
+			}
+
+			virtual void OnMsg(proto::GetBodyParts&& msg) override
+			{
+				verify_test(IsGetBodyOk(msg.m_ID));
+				m_nParts++;
+
+				const Block::Body& block = m_pBc->m_Block;
+
+				proto::BodyParts msgOut;
+				msgOut.m_Value = std::make_shared<Transaction>();
+
+				for (uint32_t iIdx : msg.m_Outputs)
+				{
+					verify_test(iIdx < block.m_vOutputs.size());
+					msgOut.m_Value->m_vOutputs.emplace_back(new Output);
+					*msgOut.m_Value->m_vOutputs.back() = *block.m_vOutputs[iIdx];
+				}
+
+				for (uint32_t iIdx : msg.m_Kernels)
+				{
+					verify_test(iIdx < block.m_vKernels.size());
+					msgOut.m_Value->m_vKernels.emplace_back();
+					block.m_vKernels[iIdx]->Clone(msgOut.m_Value->m_vKernels.back());
+				}
+
+				Send(msgOut);
+			}
+
+			virtual void OnMsg(proto::GetBodyPack&& msg) override
+			{
+				verify_test(IsGetBodyOk(msg.m_Top));
+				verify_test(!msg.m_CountExtra);
+				m_nPack++;
+
+				proto::Body msgOut;
+				msgOut.m_Body.m_Perishable = m_pBc->m_BodyP;
+				msgOut.m_Body.m_Eternal = m_pBc->m_BodyE;
+				Send(msgOut);
+			}
+
+			void OnTimer()
+			{
+				if (m_pNode->get_Processor().m_Cursor.m_ID.m_Height == m_hTrg)
+				{
+					verify_test(m_nCompact == m_iStage + 1);
+
+					switch (m_iStage)
+					{
+					case 0: // full restore
+						verify_test(!m_nParts && !m_nPack);
+						break;
+
+					case 1: // partial
+						verify_test((1 == m_nParts) && !m_nPack);
+						break;
+
+					default: // mismatch
+						verify_test((1 == m_nParts) && (1 == m_nPack));
+					}
+
+					if (++m_iStage == 3)
+					{
+						io::Reactor::get_Current().stop();
+						return;
+					}
+
+					NewBlock();
+				}
+
+				if (++m_nCycles > 100)
+				{
+					fail_test("Compact block stuck");
+					io::Reactor::get_Current().stop();
+					return;
+				}
+
+				m_pTimer->start(100, false, [this]() { OnTimer(); });
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
+			}
+		};
+
+		MyPeer peer;
+		peer.m_pNode = &node;
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			peer.m_vTxs.emplace_back();
+			verify_test(wallet.MakeTx(peer.m_vTxs.back(), h0, 0));
+		}
+
+		// same kernel ID, another signature (the signature nonce is random)
+		{
+			const Transaction& tx = *peer.m_vTxs.back();
+
+			Serializer ser;
+			ser & tx;
+
+			peer.m_pTxAlt = std::make_shared<Transaction>();
+			Deserializer der;
+			der.reset(ser.buffer().first, ser.buffer().second);
+			der & *peer.m_pTxAlt;
+
+			TxKernelStd::Ptr pKrn;
+			wallet.m_MyKernels.back().Export(pKrn);
+			verify_test(pKrn->m_Internal.m_ID == tx.m_vKernels.front()->m_Internal.m_ID);
+			verify_test(!(pKrn->m_Signature == Cast::Up<TxKernelStd>(*tx.m_vKernels.front()).m_Signature));
+
+			peer.m_pTxAlt->m_vKernels.front() = std::move(pKrn);
+		}
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+
+		peer.Connect(addr);
+		pReactor->run();
+
+		verify_test(peer.m_iStage == 3);
+		verify_test(node.get_Processor().m_Cursor.m_ID.m_Height == h0 + 3);
+	}
+
+	void TestNodeRtt()
+	{
+		// The RTT is probed only when the peer is idle. The slow peer gets a lower rating.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_Timeout.m_RttProbe_ms = 0; // probe each time the peer becomes idle
+		ECC::SetRandom(node);
+
+		node.Initialize();
+
+		const uint32_t nDelaySlow_ms = 300;
+
+		struct MyPeer
+			:public proto::NodeConnection
+		{
+			Node* m_pNode;
+			PeerID m_ID;
+			uint32_t m_Delay_ms = 0;
+			uint32_t m_nPings = 0;
+			bool m_bRequestPending = false;
+
+			TxPool::Fluff m_TxPool;
+			std::unique_ptr<NodeProcessor::BlockContext> m_pBc;
+			io::Timer::Ptr m_pTimerPong;
+			io::Timer::Ptr m_pTimerBody;
+
+			virtual void OnConnectedSecure() override
+			{
+				m_pTimerPong = io::Timer::create(io::Reactor::get_Current());
+				m_pTimerBody = io::Timer::create(io::Reactor::get_Current());
+
+				SendLogin();
+
+				ECC::Scalar::Native sk;
+				ECC::SetRandom(sk);
+				m_ID.FromSk(sk);
+				ProveID(sk, proto::IDType::Node);
+			}
+
+			virtual void OnMsg(proto::Ping&&) override
+			{
+				verify_test(!m_bRequestPending);
+				m_nPings++;
+
+				m_pTimerPong->start(m_Delay_ms, false, [this]() { OnPongDelayed(); });
+			}
+
+			void OnPongDelayed()
+			{
+				Send(proto::Pong(Zero));
+			}
+
+			void Announce()
+			{
+				// the node would request this block
+				m_pBc.reset(new NodeProcessor::BlockContext(m_TxPool, 0, *m_pNode->m_Keys.m_pMiner, *m_pNode->m_Keys.m_pMiner));
+				verify_test(m_pNode->get_Processor().GenerateNewBlock(*m_pBc));
+
+				proto::NewTip msg;
+				msg.m_Description = m_pBc->m_Hdr;
+				Send(msg);
+			}
+
+			virtual void OnMsg(proto::GetBodyPack&& msg) override
+			{
+				verify_test(m_pBc && !m_bRequestPending);
+				m_bRequestPending = true;
+
+				m_pTimerBody->start(m_Delay_ms, false, [this]() { OnBodyDelayed(); });
+			}
+
+			void OnBodyDelayed()
+			{
+				m_bRequestPending = false;
+
+				proto::Body msgOut;
+				msgOut.m_Body.m_Perishable = m_pBc->m_BodyP;
+				msgOut.m_Body.m_Eternal = m_pBc->m_BodyE;
+				Send(msgOut);
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
+			}
+		};
+
+		MyPeer pPeers[2];
+		MyPeer& pFast = pPeers[0];
+		MyPeer& pSlow = pPeers[1];
+		pSlow.m_Delay_ms = nDelaySlow_ms;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+
+		for (uint32_t i = 0; i < _countof(pPeers); i++)
+		{
+			pPeers[i].m_pNode = &node;
+			pPeers[i].Connect(addr);
+		}
+
+		const Height h0 = node.get_Processor().m_Cursor.m_ID.m_Height;
+		Node::PeerLink plFast, plSlow;
+		plFast.m_Latency_ms = plSlow.m_Latency_ms = 0;
+		bool bMeasured = false;
+		uint32_t nCycles = 0;
+
+		io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
+
+		std::function<void()> fnOnTimer = [&]()
+		{
+			if (!bMeasured)
+			{
+				// wait for the 1st probe of both
+				if (node.get_PeerLink(plFast, pFast.m_ID) && node.get_PeerLink(plSlow, pSlow.m_ID) &&
+					plFast.m_Latency_ms && plSlow.m_Latency_ms)
+				{
+					bMeasured = true;
+
+					verify_test(plSlow.m_Latency_ms >= nDelaySlow_ms);
+					verify_test(plFast.m_Latency_ms < nDelaySlow_ms);
+					verify_test(plSlow.m_Rating == plFast.m_Rating); // probes don't affect the rating
+
+					pSlow.Announce();
+				}
+			}
+			else
+			{
+				// the slow peer is probed again once the block is received, not while it's pending
+				if ((node.get_Processor().m_Cursor.m_ID.m_Height > h0) && (pSlow.m_nPings >= 2))
+				{
+					Node::PeerLink pl;
+					verify_test(node.get_PeerLink(pl, pSlow.m_ID));
+					verify_test(pl.m_Latency_ms >= nDelaySlow_ms);
+					verify_test(pl.m_Latency_ms < nDelaySlow_ms * 2); // the body transfer time isn't included
+					verify_test(pl.m_Rating < plFast.m_Rating); // the delayed response is penalized
+
+					io::Reactor::get_Current().stop();
+					return;
+				}
+			}
+
+			if (++nCycles > 100)
+			{
+				fail_test("RTT probe stuck");
+				io::Reactor::get_Current().stop();
+				return;
+			}
+
+			pTimer->start(100, false, fnOnTimer);
+		};
+
+		pTimer->start(100, false, fnOnTimer);
+		pReactor->run();
+
+		verify_test(pSlow.m_nPings >= 2);
+		verify_test(1 == pFast.m_nPings);
+	}
+
+	void TestNodeListenThreads()
+	{
+		// Inbound peers are handed to the listen reactors. Covers the secure channel, the message exchange via the main thread,
+		// and the disconnect initiated by either side.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_ListenThreads = 2;
+		ECC::SetRandom(node);
+
+		node.Initialize();
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			PeerID m_ID;
+			bool m_Authenticated = false;
+			bool m_ExternalAddr = false;
+			bool m_Disconnected = false;
+			uint32_t m_nPings = 0;
+			uint32_t m_nPongs = 0;
+
+			virtual void OnConnectedSecure() override
+			{
+				SendLogin();
+
+				ECC::Scalar::Native sk;
+				ECC::SetRandom(sk);
+				m_ID.FromSk(sk);
+				ProveID(sk, proto::IDType::Node);
+
+				Send(proto::GetExternalAddr(Zero));
+
+				for (m_nPings = 0; m_nPings < 10; m_nPings++)
+					Send(proto::Ping(Zero));
+			}
+
+			virtual void OnMsg(proto::Authentication&& msg) override
+			{
+				proto::NodeConnection::OnMsg(std::move(msg)); // verifies the signature wrt the channel nonces
+				if (proto::IDType::Node == msg.m_IDType)
+					m_Authenticated = true;
+			}
+
+			virtual void OnMsg(proto::ExternalAddr&& msg) override
+			{
+				io::Address addr;
+				addr.resolve("127.0.0.1");
+				verify_test(msg.m_Value == addr.ip());
+				m_ExternalAddr = true;
+			}
+
+			virtual void OnMsg(proto::Pong&&) override
+			{
+				verify_test(m_nPongs < m_nPings);
+				m_nPongs++;
+			}
+
+			bool IsReady() const
+			{
+				return m_Authenticated && m_ExternalAddr && (m_nPongs == m_nPings);
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				m_Disconnected = true;
+			}
+		};
+
+		MyClient pCl[2];
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+
+		for (uint32_t i = 0; i < _countof(pCl); i++)
+			pCl[i].Connect(addr);
+
+		auto fnIsLive = [&node](const MyClient& cl)
+		{
+			Node::PeerLink pl;
+			return node.get_PeerLink(pl, cl.m_ID) && pl.m_Live;
+		};
+
+		uint32_t iStage = 0;
+		uint32_t nCycles = 0;
+
+		io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
+
+		std::function<void()> fnOnTimer = [&]()
+		{
+			switch (iStage)
+			{
+			case 0:
+				if (!pCl[0].IsReady() || !pCl[1].IsReady() || !fnIsLive(pCl[0]) || !fnIsLive(pCl[1]))
+					break;
+
+				// the 1st closes the connection, the 2nd sends an unexpected message, the node should drop it
+				pCl[0].Reset();
+				pCl[1].Send(proto::Body(Zero));
+
+				iStage++;
+				break;
+
+			default:
+				if (!pCl[1].m_Disconnected || fnIsLive(pCl[0]) || fnIsLive(pCl[1]))
+					break;
+
+				verify_test(!pCl[0].m_Disconnected); // closed locally
+				io::Reactor::get_Current().stop();
+				return;
+			}
+
+			if (++nCycles > 100)
+			{
+				fail_test("Listen threads stuck");
+				io::Reactor::get_Current().stop();
+				return;
+			}
+
+			pTimer->start(100, false, fnOnTimer);
+		};
+
+		pTimer->start(100, false, fnOnTimer);
+		pReactor->run();
+
+		verify_test(iStage == 1);
+	}
+
+	void TestNodeHdrAnchors()
+	{
+		// Headers are synced in parallel packs, between the anchors from the peer's ChainWorkProof. The peer with a bad proof is dropped.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		// the source chain
+		Node nodeSrc;
+		nodeSrc.m_Cfg.m_sPathLocal = g_sz2;
+		nodeSrc.m_Cfg.m_Listen.port(g_Port + 1);
+		nodeSrc.m_Cfg.m_Listen.ip(INADDR_ANY);
+		nodeSrc.m_Cfg.m_Treasury = g_Treasury;
+		ECC::SetRandom(nodeSrc);
+
+		nodeSrc.Initialize();
+
+		while (nodeSrc.get_Processor().m_Cursor.m_ID.m_Height < 200)
+			MineBlockAt(nodeSrc);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_HdrSync.m_MaxPacks = 4;
+		node.m_Cfg.m_HdrSync.m_MinGap = 10;
+		ECC::SetRandom(node);
+
+		node.Initialize();
+
+		struct Context
+		{
+			uint32_t m_nInFlight = 0;
+			uint32_t m_nInFlightMax = 0;
+			uint32_t m_nAnchored = 0; // packs requested below the anchors
+		};
+
+		struct MyPeer
+			:public proto::NodeConnection
+		{
+			NodeProcessor* m_pSrc;
+			Context* m_pCtx;
+			bool m_bBadProof = false;
+			bool m_Disconnected = false;
+
+			std::deque<proto::GetHdrPack> m_queHdrs;
+			io::Timer::Ptr m_pTimer;
+
+			virtual void OnConnectedSecure() override
+			{
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+
+				SendLogin();
+
+				ECC::Scalar::Native sk;
+				ECC::SetRandom(sk);
+				ProveID(sk, proto::IDType::Node);
+
+				proto::NewTip msg;
+				msg.m_Description = m_pSrc->m_Cursor.m_Full;
+				Send(msg);
+			}
+
+			struct Source
+				:public Block::ChainWorkProof::ISource
+			{
+				NodeProcessor& m_Proc;
+				Source(NodeProcessor& p) :m_Proc(p) {}
+
+				virtual void get_StateAt(Block::SystemState::Full& s, const Difficulty::Raw& d) override
+				{
+					uint64_t rowid = m_Proc.get_DB().FindStateWorkGreater(d);
+					m_Proc.get_DB().get_State(rowid, s);
+				}
+
+				virtual void get_Proof(Merkle::IProofBuilder& bld, Height h) override
+				{
+					m_Proc.m_Mmr.m_States.get_Proof(bld, m_Proc.m_Mmr.m_States.H2I(h));
+				}
+			};
+
+			virtual void OnMsg(proto::GetProofChainWork&& msg) override
+			{
+				Block::ChainWorkProof cwp;
+				Source src(*m_pSrc);
+				cwp.Create(src, m_pSrc->m_Cursor.m_Full);
+
+				NodeProcessor::Evaluator ev(*m_pSrc);
+				ev.get_Live(cwp.m_hvRootLive);
+
+				proto::ProofChainWork msgOut;
+				msgOut.m_Proof.m_LowerBound = msg.m_LowerBound;
+				verify_test(msgOut.m_Proof.Crop(cwp));
+				verify_test(msgOut.m_Proof.IsValid());
+
+				if (m_bBadProof)
+				{
+					verify_test(!msgOut.m_Proof.m_vArbitraryStates.empty());
+					msgOut.m_Proof.m_vArbitraryStates.front().m_Kernels.Inc();
+					verify_test(!msgOut.m_Proof.IsValid());
+				}
+
+				Send(msgOut);
+			}
+
+			virtual void OnMsg(proto::GetHdrPack&& msg) override
+			{
+				if (m_bBadProof)
+					return; // would be dropped anyway
+
+				// w/o anchors all the headers are requested as a single pack, right below the tip
+				if (msg.m_Top.m_Height + 1 < m_pSrc->m_Cursor.m_ID.m_Height)
+					m_pCtx->m_nAnchored++;
+
+				std::setmax(m_pCtx->m_nInFlightMax, ++m_pCtx->m_nInFlight);
+
+				// reply after a while, let the node request other packs meanwhile
+				m_queHdrs.push_back(std::move(msg));
+				if (1 == m_queHdrs.size())
+					m_pTimer->start(200, false, [this]() { OnTimer(); });
+			}
+
+			void OnTimer()
+			{
+				assert(!m_queHdrs.empty());
+				const proto::GetHdrPack& msg = m_queHdrs.front();
+
+				NodeDB& db = m_pSrc->get_DB();
+
+				NodeDB::StateID sid;
+				sid.m_Height = msg.m_Top.m_Height;
+				sid.m_Row = db.StateFindSafe(msg.m_Top);
+				verify_test(sid.m_Row);
+
+				proto::HdrPack msgOut;
+
+				NodeDB::WalkerSystemState wlk;
+				for (db.EnumSystemStatesBkwd(wlk, sid); wlk.MoveNext(); )
+				{
+					msgOut.m_vElements.push_back(wlk.m_State);
+					if (msgOut.m_vElements.size() == msg.m_Count)
+						break;
+				}
+
+				msgOut.m_Prefix = wlk.m_State;
+				Send(msgOut);
+
+				m_pCtx->m_nInFlight--;
+				m_queHdrs.pop_front();
+
+				if (!m_queHdrs.empty())
+					m_pTimer->start(200, false, [this]() { OnTimer(); });
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				m_Disconnected = true;
+				if (!m_bBadProof)
+				{
+					fail_test("OnDisconnect");
+					io::Reactor::get_Current().stop();
+				}
+			}
+		};
+
+		Context ctx;
+		MyPeer pPeers[3];
+		MyPeer& peerBad = pPeers[0];
+		peerBad.m_bBadProof = true;
+
+		for (uint32_t i = 0; i < _countof(pPeers); i++)
+		{
+			pPeers[i].m_pSrc = &nodeSrc.get_Processor();
+			pPeers[i].m_pCtx = &ctx;
+		}
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+
+		peerBad.Connect(addr);
+
+		auto fnAllHdrs = [&]()
+		{
+			NodeProcessor& npSrc = nodeSrc.get_Processor();
+			for (Height h = Rules::HeightGenesis; h <= npSrc.m_Cursor.m_ID.m_Height; h++)
+			{
+				NodeDB::StateID sid;
+				sid.m_Height = h;
+				sid.m_Row = npSrc.FindActiveAtStrict(h);
+
+				Block::SystemState::ID id;
+				npSrc.get_DB().get_StateID(sid, id);
+
+				if (!node.get_Processor().get_DB().StateFindSafe(id))
+					return false;
+			}
+			return true;
+		};
+
+		uint32_t iStage = 0;
+		uint32_t nCycles = 0;
+
+		io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
+
+		std::function<void()> fnOnTimer = [&]()
+		{
+			switch (iStage)
+			{
+			case 0:
+				if (!peerBad.m_Disconnected)
+					break;
+
+				// the good peers come only now, so that the anchors are requested from them
+				pPeers[1].Connect(addr);
+				pPeers[2].Connect(addr);
+				iStage++;
+				break;
+
+			default:
+				if (!fnAllHdrs())
+					break;
+
+				io::Reactor::get_Current().stop();
+				return;
+			}
+
+			if (++nCycles > 200)
+			{
+				fail_test("Hdr sync stuck");
+				io::Reactor::get_Current().stop();
+				return;
+			}
+
+			pTimer->start(100, false, fnOnTimer);
+		};
+
+		pTimer->start(100, false, fnOnTimer);
+		pReactor->run();
+
+		verify_test(iStage == 1);
+		verify_test(ctx.m_nAnchored);
+		verify_test(ctx.m_nInFlightMax >= 2);
+	}
+
+	template <typename T>
+	void SaveMsgOnce(ByteBuffer& buf, const T& msg)
+	{
+		verify_test(buf.empty()); // only once
+		Serializer ser;
+		ser & msg;
+		ser.swap_buf(buf);
+	}
+
+	void TestNodeSharedMsg(uint32_t nListenThreads)
+	{
+		// The broadcast messages (new tip, BBS) are serialized once and shared. Every peer must receive the same message.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_ListenThreads = nListenThreads;
+		ECC::SetRandom(node);
+
+		node.Initialize();
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			BbsChannel m_Channel = 0;
+			bool m_Subscribed = false;
+			Height m_hTrg = 0;
+			ByteBuffer m_bufTip;
+			ByteBuffer m_bufBbs;
 
-			Height m_HeightMax;
-			const Height m_HeightTrg = 70;
+			virtual void OnConnectedSecure() override
+			{
+				SendLogin();
 
-			MyClient()
+				proto::BbsSubscribe msgSub;
+				msgSub.m_Channel = m_Channel;
+				msgSub.m_On = true;
+				Send(msgSub);
+
+				Send(proto::Ping(Zero)); // the pong confirms the subscription
+			}
+
+			virtual void OnMsg(proto::Pong&&) override
 			{
-				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+				m_Subscribed = true;
 			}
 
-			virtual void OnConnectedSecure() override {
-				OnTimer();
+			virtual void OnMsg(proto::NewTip&& msg) override
+			{
+				if (m_hTrg && (msg.m_Description.m_Height == m_hTrg))
+					SaveMsgOnce(m_bufTip, msg);
 			}
 
-			virtual void OnDisconnect(const DisconnectReason&) override {
+			virtual void OnMsg(proto::BbsMsg&& msg) override
+			{
+				SaveMsgOnce(m_bufBbs, msg);
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
 				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
 			}
+		};
 
-			io::Timer::Ptr m_pTimer;
+		const BbsChannel nChannel = 7;
 
-			void OnTimer() {
+		MyClient pCl[3];
 
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
 
-				if (m_HeightMax < m_HeightTrg)
-				{
-					Node& n = *m_ppNode[m_iNode];
+		for (uint32_t i = 0; i < _countof(pCl); i++)
+		{
+			pCl[i].m_Channel = nChannel;
+			pCl[i].Connect(addr);
+		}
 
-					TxPool::Fluff txPool; // empty, no transactions
-					NodeProcessor::BlockContext bc(txPool, 0, *n.m_Keys.m_pMiner, *n.m_Keys.m_pMiner);
+		proto::BbsMsg msgBbs;
+		msgBbs.m_Channel = nChannel;
+		msgBbs.m_Message.resize(1000);
+		ECC::GenRandom(&msgBbs.m_Message.front(), msgBbs.m_Message.size());
 
-					verify_test(n.get_Processor().GenerateNewBlock(bc));
+		uint32_t iStage = 0;
+		uint32_t nCycles = 0;
 
-					n.get_Processor().OnState(bc.m_Hdr, PeerID());
+		io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
 
-					Block::SystemState::ID id;
-					bc.m_Hdr.get_ID(id);
+		std::function<void()> fnOnTimer = [&]()
+		{
+			bool bReady = true;
 
-					n.get_Processor().OnBlock(id, bc.m_BodyP, bc.m_BodyE, PeerID());
-					n.get_Processor().TryGoUp();
+			switch (iStage)
+			{
+			case 0:
+				for (uint32_t i = 0; i < _countof(pCl); i++)
+					if (!pCl[i].m_Subscribed)
+						bReady = false;
 
-					std::setmax(m_HeightMax, bc.m_Hdr.m_Height);
+				if (bReady)
+				{
+					Height hTrg = node.get_Processor().m_Cursor.m_ID.m_Height + 1;
+					for (uint32_t i = 0; i < _countof(pCl); i++)
+						pCl[i].m_hTrg = hTrg;
 
-					printf("Mined block Height = %u, node = %u \n", (unsigned int) bc.m_Hdr.m_Height, (unsigned int)m_iNode);
+					MineBlockAt(node);
 
-					++m_iNode %= _countof(m_ppNode);
+					msgBbs.m_TimePosted = getTimestamp();
+					pCl[0].Send(msgBbs);
+
+					iStage++;
 				}
-				else
-					if (m_WaitingCycles++ > 60)
-					{
-						fail_test("Blockchain height didn't reach target");
-						io::Reactor::get_Current().stop();
-					}
+				break;
 
-				SetTimer(100);
+			default:
+				for (uint32_t i = 0; i < _countof(pCl); i++)
+					if (pCl[i].m_bufTip.empty() || pCl[i].m_bufBbs.empty())
+						bReady = false;
+
+				if (bReady)
+				{
+					io::Reactor::get_Current().stop();
+					return;
+				}
 			}
 
-			virtual void OnMsg(proto::NewTip&& msg) override
+			if (++nCycles > 100)
 			{
-				printf("Tip Height=%u\n", (unsigned int) msg.m_Description.m_Height);
-				verify_test(msg.m_Description.m_Height <= m_HeightMax);
-				if (msg.m_Description.m_Height == m_HeightTrg)
-					io::Reactor::get_Current().stop();
+				fail_test("Broadcast not received");
+				io::Reactor::get_Current().stop();
+				return;
 			}
 
-			void SetTimer(uint32_t timeout_ms) {
-				m_pTimer->start(timeout_ms, false, [this]() { return (this->OnTimer)(); });
+			pTimer->start(100, false, fnOnTimer);
+		};
+
+		pTimer->start(100, false, fnOnTimer);
+		pReactor->run();
+
+		verify_test(iStage == 1);
+
+		ByteBuffer bufBbs;
+		SaveMsgOnce(bufBbs, msgBbs);
+
+		for (uint32_t i = 0; i < _countof(pCl); i++)
+		{
+			verify_test(pCl[i].m_bufBbs == bufBbs);
+			verify_test(pCl[i].m_bufTip == pCl[0].m_bufTip);
+		}
+	}
+
+	void TestNodeMiningPreJob()
+	{
+		// On a new tip the external miner gets the empty block at once, followed by the full template. The empty pre-job remains valid after that.
+
+		struct MyExternalPow
+			:public IExternalPOW
+		{
+			struct Job
+			{
+				std::string m_ID;
+				Height m_Height;
+				BlockFound m_Callback;
+			};
+
+			std::vector<Job> m_vJobs;
+			size_t m_iFound = 0;
+
+			void new_job(const std::string& jobID, const Merkle::Hash&, const Block::PoW&, const Height& h, const BlockFound& callback, const CancelCallback&) override
+			{
+				// called under the miner mutex, the solution is reported later
+				m_vJobs.push_back({ jobID, h, callback });
+			}
+
+			void get_last_found_block(std::string& jobID, Height& h, Block::PoW& pow) override
+			{
+				const Job& job = m_vJobs[m_iFound];
+				jobID = job.m_ID;
+				h = job.m_Height;
+				ZeroObject(pow);
+			}
+
+			void stop_current() override {}
+			void stop() override {}
+
+			BlockFoundResult Solve(size_t iJob)
+			{
+				m_iFound = iJob;
+				return m_vJobs[iJob].m_Callback();
+			}
+
+			size_t FindFirstAt(Height h, size_t iFrom) const
+			{
+				for (size_t i = iFrom; i < m_vJobs.size(); i++)
+					if (m_vJobs[i].m_Height == h)
+						return i;
+				return m_vJobs.size();
 			}
 		};
 
-		MyClient cl;
-		cl.m_iNode = 0;
-		cl.m_HeightMax = 0;
-		cl.m_WaitingCycles = 0;
-		cl.m_ppNode[0] = &node;
-		cl.m_ppNode[1] = &node2;
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
 
-		io::Address addr;
-		addr.resolve("127.0.0.1");
-		addr.port(g_Port + 1);
+		MiniWallet wallet;
+		ECC::SetRandom(wallet.m_pKdf);
 
-		cl.Connect(addr);
+		MyExternalPow pow;
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_MiningThreads = 0;
+		node.m_Cfg.m_TestMode.m_FakePowSolveTime_ms = 100; // enables the miner in the FakePoW mode
+		node.m_Keys.SetSingleKey(wallet.m_pKdf);
 
+		node.Initialize(&pow);
 
-		pReactor->run();
+		// the tx is created after Fork1, and remains valid in all the test blocks
+		while (node.get_Processor().m_Cursor.m_ID.m_Height < std::max<Height>(3 + Rules::get().Maturity.Coinbase, Rules::get().pForks[1].m_Height))
+		{
+			MineBlockAt(node);
 
-		node.GenerateRecoveryInfo(g_sz3);
+			Height hTip = node.get_Processor().m_Cursor.m_ID.m_Height;
+			wallet.AddMyUtxo(CoinID(Rules::get_Emission(hTip), hTip, Key::Type::Coinbase));
+		}
 
-		struct MyParser :public RecoveryInfo::IParser
+		Transaction::Ptr pTx;
+		verify_test(wallet.MakeTx(pTx, node.get_Processor().m_Cursor.m_ID.m_Height, 0));
+		Merkle::Hash hvKrn = pTx->m_vKernels.front()->m_Internal.m_ID;
+		verify_test(proto::TxStatus::Ok == node.OnTransaction(std::move(pTx), nullptr, true, nullptr));
+
+		MineBlockAt(node);
+		const Height h1 = node.get_Processor().m_Cursor.m_ID.m_Height;
+		size_t iJob0 = pow.m_vJobs.size();
+
+		uint32_t iStage = 0;
+		uint32_t nCycles = 0;
+
+		io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
+
+		std::function<void()> fnOnTimer = [&]()
 		{
-			Key::IPKdf::Ptr m_pOwner1;
-			Key::IPKdf::Ptr m_pOwner2;
-			uint32_t m_nUnrecognized = 0;
 
-			virtual bool OnUtxo(Height h, const Output& outp) override
-			{
-				verify_test(outp.m_RecoveryOnly);
-
-				CoinID cid;
-				bool b1 = outp.Recover(h, *m_pOwner1, cid);
-				bool b2 = outp.Recover(h, *m_pOwner2, cid);
-				if (!(b1 || b2))
+			Height hTip = node.get_Processor().m_Cursor.m_ID.m_Height;
+			Height hKrn = node.get_Processor().get_DB().FindKernel(hvKrn);
+
+			size_t iPre = pow.FindFirstAt(hTip + 1, iJob0);
+			size_t iFull = pow.FindFirstAt(hTip + 1, iPre + 1);
+
+			switch (iStage)
+			{
+			case 0:
+				if (iFull < pow.m_vJobs.size())
 				{
-					verify_test(!h); // treasury
-					m_nUnrecognized++;
-					verify_test(m_nUnrecognized <= 1);
+					// solve the older one (the empty pre-job), though it's already superseded by the full template
+					verify_test(pow.Solve(iPre) == IExternalPOW::solution_accepted);
+					iStage++;
 				}
-
-				return true;
-			}
-		} parser;
-		parser.m_pOwner1 = node.m_Keys.m_pOwner;
-		parser.m_pOwner2 = node2.m_Keys.m_pOwner;
+				break;
 
-		verify_test(parser.Proceed(g_sz3));
+			case 1:
+				if (hTip == h1 + 1)
+				{
+					verify_test(!hKrn); // the tx was not included
+					iStage++;
+				}
+				break;
 
-		DeleteFile(g_sz3);
+			case 2:
+				if (iFull < pow.m_vJobs.size())
+				{
+					verify_test(pow.Solve(iFull) == IExternalPOW::solution_accepted);
+					verify_test(pow.Solve(iPre) == IExternalPOW::solution_rejected); // the same stop indicator
+					iStage++;
+				}
+				break;
+
+			case 3:
+				if (hTip == h1 + 2)
+				{
+					verify_test(hKrn == h1 + 2);
+					iStage++;
+					io::Reactor::get_Current().stop();
+					return;
+				}
+			}
+
+			if (++nCycles > 100)
+			{
+				fail_test("Mining jobs not received");
+				io::Reactor::get_Current().stop();
+				return;
+			}
+
+			pTimer->start(100, false, fnOnTimer);
+		};
+
+		pTimer->start(100, false, fnOnTimer);
+		pReactor->run();
+
+		verify_test(iStage == 4);
 	}
 
 	namespace bvm2
@@ -1728,6 +3498,7 @@ namespace beam
 		node.m_Cfg.m_Listen.ip(INADDR_ANY);
 		node.m_Cfg.m_TestMode.m_FakePowSolveTime_ms = 100;
 		node.m_Cfg.m_MiningThreads = 1;
+		node.m_Cfg.m_ListenThreads = 2; // inbound peers are handled by the network threads
 
 		ECC::SetRandom(node);
 
@@ -1756,9 +3527,12 @@ namespace beam
 			std::list<ECC::Point> m_queProofsExpected;
 			std::list<uint32_t> m_queProofsStateExpected;
 			std::list<uint32_t> m_queProofsKrnExpected;
+			std::list<std::vector<ECC::Point> > m_queProofsMultiExpected;
+			std::list<std::vector<Merkle::Hash> > m_queProofsKrnMultiExpected;
 			uint32_t m_nChainWorkProofsPending = 0;
 			uint32_t m_nBbsMsgsPending = 0;
 			uint32_t m_nRecoveryPending = 0;
+			uint32_t m_nReadPaused = 0;
 			std::list<std::pair<Height, Merkle::Hash> > m_queProofLogsExpected;
 
 			struct
@@ -1792,6 +3566,16 @@ namespace beam
 				m_Wallet.m_pKdf = pKdf;
 				m_Wallet.m_AutoAddTxOutputs = false;
 				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+
+				// low marks, to exercise the read pause while the requests are queued
+				m_UnsentPauseMark = 1024 * 4;
+				m_UnsentResumeMark = 1024;
+			}
+
+			virtual void OnReadPaused(bool bPaused) override
+			{
+				if (bPaused)
+					m_nReadPaused++;
 			}
 
 			virtual void OnConnectedSecure() override
@@ -1842,6 +3626,8 @@ namespace beam
 				return
 					m_queProofsExpected.empty() &&
 					m_queProofsKrnExpected.empty() &&
+					m_queProofsMultiExpected.empty() &&
+					m_queProofsKrnMultiExpected.empty() &&
 					m_queProofsStateExpected.empty() &&
 					m_queProofLogsExpected.empty() &&
 					!m_nChainWorkProofsPending;
@@ -2219,6 +4005,8 @@ namespace beam
 					Send(msgOut2);
 				}
 
+				proto::GetProofUtxoMulti msgUtxoMulti;
+
 				for (auto it = m_Wallet.m_MyUtxos.begin(); m_Wallet.m_MyUtxos.end() != it; it++)
 				{
 					const MiniWallet::MyUtxo& utxo = it->second;
@@ -2232,9 +4020,20 @@ namespace beam
 					{
 						Send(msgOut2);
 						m_queProofsExpected.push_back(msgOut2.m_Utxo);
+
+						if (msgUtxoMulti.m_Utxos.size() < proto::g_ProofMultiMax)
+							msgUtxoMulti.m_Utxos.push_back(msgOut2.m_Utxo);
 					}
 				}
 
+				if (!msgUtxoMulti.m_Utxos.empty())
+				{
+					Send(msgUtxoMulti);
+					m_queProofsMultiExpected.push_back(std::move(msgUtxoMulti.m_Utxos));
+				}
+
+				proto::GetProofKernelMulti msgKrnMulti;
+
 				for (uint32_t i = 0; i < m_Wallet.m_MyKernels.size(); i++)
 				{
 					const MiniWallet::MyKernel mk = m_Wallet.m_MyKernels[i];
@@ -2254,6 +4053,16 @@ namespace beam
 					Send(msgOut3);
 
 					m_queProofsKrnExpected.push_back(i);
+
+					if (msgKrnMulti.m_IDs.size() < proto::g_ProofMultiMax)
+						msgKrnMulti.m_IDs.push_back(krn.m_Internal.m_ID);
+				}
+
+				if (!msgKrnMulti.m_IDs.empty())
+				{
+					msgKrnMulti.m_IDs.push_back(Zero); // non-existing
+					Send(msgKrnMulti);
+					m_queProofsKrnMultiExpected.push_back(std::move(msgKrnMulti.m_IDs));
 				}
 
 				{
@@ -2779,6 +4588,75 @@ namespace beam
 					fail_test("unexpected proof");
 			}
 
+			virtual void OnMsg(proto::ProofUtxoMulti&& msg) override
+			{
+				if (!m_queProofsMultiExpected.empty())
+				{
+					const std::vector<ECC::Point>& vUtxos = m_queProofsMultiExpected.front();
+					verify_test(msg.m_Proofs.size() == vUtxos.size());
+
+					for (uint32_t i = 0; i < vUtxos.size(); i++)
+					{
+						verify_test(!msg.m_Proofs[i].empty());
+
+						for (uint32_t j = 0; j < msg.m_Proofs[i].size(); j++)
+						{
+							Input::Proof proof = msg.m_Proofs[i][j];
+							proof.m_Proof.insert(proof.m_Proof.end(), msg.m_Tail.begin(), msg.m_Tail.end());
+							verify_test(m_vStates.back().IsValidProofUtxo(vUtxos[i], proof));
+						}
+					}
+
+					m_queProofsMultiExpected.pop_front();
+				}
+				else
+					fail_test("unexpected proof");
+			}
+
+			virtual void OnMsg(proto::ProofKernelMulti&& msg) override
+			{
+				if (!m_queProofsKrnMultiExpected.empty())
+				{
+					const std::vector<Merkle::Hash>& vIDs = m_queProofsKrnMultiExpected.front();
+					verify_test(msg.m_Heights.size() == vIDs.size());
+					verify_test(!msg.m_Heights.back()); // the last one doesn't exist
+
+					for (uint32_t iBlock = 0; iBlock < msg.m_Blocks.size(); iBlock++)
+					{
+						const proto::KernelsProof& kp = msg.m_Blocks[iBlock];
+
+						std::vector<Merkle::Hash> vKrns;
+						for (uint32_t i = 0; i < vIDs.size(); i++)
+							if (msg.m_Heights[i] == kp.m_Height)
+								vKrns.push_back(vIDs[i]);
+
+						verify_test(vKrns.size() == kp.m_vIdx.size());
+
+						verify_test(kp.m_Height <= m_vStates.size());
+						const Block::SystemState::Full& s = m_vStates[kp.m_Height - 1];
+						verify_test(kp.IsValid(s, &vKrns.front()));
+
+						// excess proof data
+						proto::KernelsProof kp2 = kp;
+						kp2.m_Proof.m_vData.emplace_back(Zero);
+						verify_test(!kp2.IsValid(s, &vKrns.front()));
+
+						// no kernels
+						kp2 = kp;
+						kp2.m_vIdx.clear();
+						verify_test(!kp2.IsValid(s, &vKrns.front()));
+
+						// tamper
+						vKrns.front().Inv();
+						verify_test(!kp.IsValid(s, &vKrns.front()));
+					}
+
+					m_queProofsKrnMultiExpected.pop_front();
+				}
+				else
+					fail_test("unexpected proof");
+			}
+
 			virtual void OnMsg(proto::ProofKernel2&& msg) override
 			{
 				if (!m_queProofsKrnExpected.empty())
@@ -3074,8 +4952,13 @@ namespace beam
 
 		pReactor->run();
 
+		verify_test(cl.m_nReadPaused && !cl.IsReadPaused());
+
 		cl.TestAllDone(true);
 
+		// dummy outputs are pre-generated in background
+		verify_test(node.get_DandelionStats().m_DummiesGenerated >= node.m_Cfg.m_Dandelion.m_DummyPoolSize);
+
 		struct TxoRecover
 			:public NodeProcessor::ITxoRecover
 		{
@@ -3482,6 +5365,8 @@ void TestAll()
 
 	beam::DeleteFile(beam::g_sz);
 	beam::DeleteFile(beam::g_sz2);
+	beam::DeleteBbsStore(beam::g_sz);
+	beam::DeleteBbsStore(beam::g_sz2);
 
 	if (!bClientProtoOnly)
 	{
@@ -3491,6 +5376,8 @@ void TestAll()
 		beam::TestNodeDB();
 		beam::DeleteFile(beam::g_sz);
 
+		beam::TestBbsStore();
+
 		{
 			printf("NodeProcessor test1...\n");
 			fflush(stdout);
@@ -3521,6 +5408,61 @@ void TestAll()
 		beam::TestNodeConversation();
 		beam::DeleteFile(beam::g_sz);
 		beam::DeleteFile(beam::g_sz2);
+
+		printf("Node BBS flood test...\n");
+		fflush(stdout);
+
+		beam::TestNodeBbsFlood();
+		beam::DeleteFile(beam::g_sz);
+		beam::DeleteBbsStore(beam::g_sz);
+
+		printf("Node Dandelion dummies test...\n");
+		fflush(stdout);
+
+		beam::TestNodeDandelionDummies();
+		beam::DeleteFile(beam::g_sz);
+
+		printf("Node compact blocks test...\n");
+		fflush(stdout);
+
+		beam::TestNodeCompactBlocks();
+		beam::DeleteFile(beam::g_sz);
+
+		printf("Node RTT probe test...\n");
+		fflush(stdout);
+
+		beam::TestNodeRtt();
+		beam::DeleteFile(beam::g_sz);
+
+		printf("Node listen threads test...\n");
+		fflush(stdout);
+
+		beam::TestNodeListenThreads();
+		beam::DeleteFile(beam::g_sz);
+
+		printf("Node hdr anchors test...\n");
+		fflush(stdout);
+
+		beam::TestNodeHdrAnchors();
+		beam::DeleteFile(beam::g_sz);
+		beam::DeleteFile(beam::g_sz2);
+
+		printf("Node shared broadcast test...\n");
+		fflush(stdout);
+
+		beam::TestNodeSharedMsg(0);
+		beam::DeleteFile(beam::g_sz);
+		beam::DeleteBbsStore(beam::g_sz);
+
+		beam::TestNodeSharedMsg(2); // relayed via the listen threads
+		beam::DeleteFile(beam::g_sz);
+		beam::DeleteBbsStore(beam::g_sz);
+
+		printf("Node mining pre-job test...\n");
+		fflush(stdout);
+
+		beam::TestNodeMiningPreJob();
+		beam::DeleteFile(beam::g_sz);
 	}
 
 	beam::Rules::get().MaxRollback = 100;
@@ -49,6 +49,18 @@ public:
     /// Disables all messages
     void disable_all_msg_types() { _msgReader.disable_all_msg_types(); }
 
+    /// Stops/resumes reading messages, already received data is retained.
+    /// On resume returns false if the connection should be closed (at this moment, the *this* may be deleted)
+    bool pause_read(bool pause) {
+        if (pause) {
+            _msgReader.pause();
+            _stream->pause_read(true);
+            return true;
+        }
+        _stream->pause_read(false);
+        return _msgReader.resume();
+    }
+
 private:
     MsgReader _msgReader;
 };
@@ -48,6 +48,21 @@ void MsgReader::reset() {
     _cursor = _msgBuffer.data();
 }
 
+void MsgReader::pause() {
+    _paused = true;
+}
+
+bool MsgReader::resume() {
+    _paused = false;
+    if (_pendingData.empty()) {
+        return true;
+    }
+
+    std::vector<uint8_t> data;
+    data.swap(_pendingData);
+    return new_data_from_stream(io::EC_OK, data.data(), data.size());
+}
+
 void MsgReader::change_id(uint64_t newStreamId) {
     _streamId = newStreamId;
 }
@@ -78,6 +93,12 @@ bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const void*
         return true;
     }
 
+    if (_paused) {
+        const uint8_t* pData = (const uint8_t*)data;
+        _pendingData.insert(_pendingData.end(), pData, pData + size);
+        return true;
+    }
+
 	std::shared_ptr<bool> pAlive(_pAlive);
 	volatile const bool& bAlive = *pAlive;
 
@@ -153,6 +174,13 @@ bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const void*
 			_state = reading_header;
 
 			_cursor = _msgBuffer.data();
+
+			if (_paused)
+			{
+				// retain the rest till resumed
+				_pendingData.insert(_pendingData.end(), p, p + sz);
+				return true;
+			}
 		}
 	}
 
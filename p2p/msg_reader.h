@@ -48,6 +48,14 @@ public:
     /// Resets to initial state
     void reset();
 
+    /// Stops extracting messages. The rest of the received data is retained till resume()
+    void pause();
+
+    /// Processes the retained data. Returns false if the stream should be closed (at this moment, the *this* may be deleted)
+    bool resume();
+
+    bool is_paused() const { return _paused; }
+
 private:
     /// 2 states of the reader
     enum State { reading_header, reading_message };
@@ -77,6 +85,12 @@ private:
     std::bitset<256> _expectedMsgTypes;
 
 	std::shared_ptr<bool> _pAlive;
+
+    /// Set while the owner can't accept more messages
+    bool _paused = false;
+
+    /// Received while paused
+    std::vector<uint8_t> _pendingData;
 };
 
 } //namespace
@@ -18,6 +18,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <fstream>
+#include <algorithm>
 
 #ifndef LOG_VERBOSE_ENABLED
 #define LOG_VERBOSE_ENABLED 1
@@ -40,6 +41,7 @@ static const uint64_t SERVER_RESTART_TIMER = 1;
 static const uint64_t ACL_REFRESH_TIMER = 2;
 static const unsigned SERVER_RESTART_INTERVAL = 1000;
 static const unsigned ACL_REFRESH_INTERVAL = 5000;
+static const size_t MAX_LIVE_JOBS = 64; // the node keeps the same backlog
 
 static const char STS[] = "stratum server ";
 
@@ -167,7 +169,18 @@ bool Server::on_solution(uint64_t from, const Solution& sol) {
 	    }
 	}
 
+    auto it = std::find_if(_liveJobs.rbegin(), _liveJobs.rend(), [&sol](const LiveJob& j) { return j.id == sol.id; });
+    if (it == _liveJobs.rend()) {
+        LOG_INFO() << STS << "solution to expired job " << sol.id << " from " << io::Address::from_u64(from);
+        Result res(sol.id, stratum::solution_expired);
+        append_json_msg(_fw, res);
+        bool sent = _connections[from]->send_msg(_currentMsg, true);
+        _currentMsg.clear();
+        return sent;
+    }
+
 	_recentResult.id = sol.id;
+	_recentResult.height = it->height;
     sol.fill_pow(_recentResult.pow);
 
     LOG_INFO() << STS << "solution to " << sol.id << " from " << io::Address::from_u64(from);
@@ -205,6 +218,14 @@ void Server::new_job(
     _recentResult.onBlockFound = callback;
     _recentResult.height = height;	
 
+    if (!_liveJobs.empty() && (_liveJobs.back().height != height)) {
+        _liveJobs.clear(); // new block
+    }
+    if (_liveJobs.size() >= MAX_LIVE_JOBS) {
+        _liveJobs.pop_front();
+    }
+    _liveJobs.push_back({ id, height });
+
     LOG_INFO() << STS << "new job " << id << " will be sent to " << _connections.size() << " connected peers";
 
     Job jobMsg(id, input, pow, height);
@@ -234,6 +255,7 @@ void Server::get_last_found_block(std::string& jobID, Height& jobHeight, Block::
 
 void Server::stop_current() {
     _recentJob.id.clear();
+    _liveJobs.clear();
 }
 
 void Server::stop() {
@@ -20,6 +20,7 @@
 #include "utility/io/coarsetimer.h"
 #include <set>
 #include <map>
+#include <deque>
 
 namespace beam { namespace stratum {
 
@@ -117,7 +118,14 @@ private:
 	struct RecentJob {
 		io::SerializedMsg msg;
 		std::string id;
-	} _recentJob;
+	} _recentJob; // the latest, sent to the newly logged-in miners
+
+	// Jobs for the current height, the latest last. Superseded ones (such as the empty-block pre-job) remain valid until the next block
+	struct LiveJob {
+		std::string id;
+		Height height;
+	};
+	std::deque<LiveJob> _liveJobs;
 
 	struct RecentResult {
 		std::string id;
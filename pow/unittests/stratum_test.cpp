@@ -13,11 +13,15 @@
 // limitations under the License.
 
 #include "pow/stratum.h"
+#include "pow/external_pow.h"
 #include "core/ecc.h"
 #include "utility/io/json_serializer.h"
 #include "p2p/line_protocol.h"
 #include "utility/helpers.h"
 #include "utility/logger.h"
+#include "utility/io/tcpstream.h"
+#include "utility/io/timer.h"
+#include <deque>
 
 using namespace beam;
 
@@ -106,6 +110,184 @@ void gen_examples() {
     reader.new_data_from_stream((void*)buf.data, buf.size);
 }
 
+// The miner side of the live jobs test
+struct LiveJobsClient : public stratum::ParserCallback {
+    io::TcpStream::Ptr stream;
+    LineProtocol lp;
+    uint32_t nJobs = 0;
+    std::deque<std::pair<std::string, stratum::ResultCode> > expected; // solutions sent, in order
+    std::function<void()> onBatchDone; // all the expected results received
+    int& nErrors;
+
+    LiveJobsClient(int& n) :
+        lp(
+            [this](void* data, size_t size) { return parse_json_msg(data, size, *this); },
+            [this](io::SharedBuffer&& buf) { if (stream) stream->write(buf); }
+        ),
+        nErrors(n)
+    {}
+
+    template <typename T>
+    void send(const T& msg) {
+        append_json_msg(lp, msg);
+        lp.finalize();
+    }
+
+    void send_solution(uint32_t i, stratum::ResultCode code) {
+        Block::PoW pow;
+        ECC::GenRandom(&pow.m_Nonce, Block::PoW::NonceType::nBytes);
+        ECC::GenRandom(pow.m_Indices.data(), Block::PoW::nSolutionBytes);
+
+        std::string id = std::to_string(i);
+        expected.emplace_back(id, code);
+        send(stratum::Solution(id, pow));
+    }
+
+    bool on_message(const stratum::Job&) override {
+        nJobs++;
+        return true;
+    }
+
+    bool on_message(const stratum::Result& res) override {
+        if (expected.empty()) {
+            if ((res.id != "login") || (res.code != stratum::no_error)) {
+                LOG_ERROR() << "login failed";
+                ++nErrors;
+            }
+        } else {
+            if ((res.id != expected.front().first) || (res.code != expected.front().second)) {
+                LOG_ERROR() << "unexpected result for " << res.id << ": " << res.code;
+                ++nErrors;
+            }
+            expected.pop_front();
+        }
+
+        if (expected.empty()) {
+            onBatchDone();
+        }
+        return true;
+    }
+};
+
+// Jobs for the current height remain valid until the next block (up to 64), e.g. the empty-block pre-job superseded by the full template
+int live_jobs_test() {
+    using namespace beam::stratum;
+
+    int nErrors = 0;
+
+    io::Reactor::Ptr reactor = io::Reactor::create();
+    io::Reactor::Scope scope(*reactor);
+
+    io::Address addr;
+    addr.resolve("127.0.0.1");
+    addr.port(20301);
+
+    std::unique_ptr<IExternalPOW> server = IExternalPOW::create(IExternalPOW::Options(), *reactor, addr, 0);
+
+    struct FoundBlock {
+        std::string id;
+        Height height;
+    };
+    std::vector<FoundBlock> found;
+
+    auto fnNewJob = [&](uint32_t i, Height h) {
+        Merkle::Hash hv;
+        ECC::GenRandom(hv.m_pData, hv.nBytes);
+        Block::PoW pow;
+        ZeroObject(pow);
+
+        server->new_job(std::to_string(i), hv, pow, h, [&]() {
+            FoundBlock fb;
+            Block::PoW powFound;
+            server->get_last_found_block(fb.id, fb.height, powFound);
+            found.push_back(fb);
+            return IExternalPOW::BlockFoundResult(IExternalPOW::solution_accepted);
+        }, []() { return false; });
+    };
+
+    LiveJobsClient client(nErrors);
+
+    uint32_t iStage = 0;
+    client.onBatchDone = [&]() {
+        switch (iStage++) {
+        case 0:
+            // the empty-block pre-job, then the full template at the same height
+            fnNewJob(1, 10);
+            fnNewJob(2, 10);
+            client.send_solution(1, solution_accepted);
+            break;
+
+        case 1:
+            // 65 live jobs in total, the oldest is evicted
+            for (uint32_t i = 3; i <= 65; i++)
+                fnNewJob(i, 10);
+            client.send_solution(1, solution_expired);
+            client.send_solution(2, solution_accepted);
+            break;
+
+        case 2:
+            // new block, previous jobs are dropped
+            fnNewJob(66, 11);
+            client.send_solution(65, solution_expired);
+            client.send_solution(66, solution_accepted);
+            break;
+
+        default:
+            reactor->stop();
+        }
+    };
+
+    io::Timer::Ptr timer = io::Timer::create(*reactor);
+    timer->start(200, false, [&]() {
+        // the server starts listening asynchronously
+        reactor->tcp_connect(addr, 1, [&](uint64_t, io::TcpStream::Ptr&& newStream, io::ErrorCode errorCode) {
+            if (errorCode) {
+                LOG_ERROR() << "connect failed";
+                ++nErrors;
+                reactor->stop();
+                return;
+            }
+
+            client.stream = std::move(newStream);
+            client.stream->enable_read([&](io::ErrorCode ec, void* data, size_t size) {
+                if (ec || !client.lp.new_data_from_stream(data, size)) {
+                    LOG_ERROR() << "disconnected";
+                    ++nErrors;
+                    reactor->stop();
+                    return false;
+                }
+                return true;
+            });
+
+            client.send(Login("abcdefgh12345678"));
+        });
+
+        timer->start(10000, false, [&]() {
+            LOG_ERROR() << "timeout";
+            ++nErrors;
+            reactor->stop();
+        });
+    });
+
+    reactor->run();
+
+    if (client.nJobs != 66) {
+        LOG_ERROR() << "jobs received: " << client.nJobs;
+        ++nErrors;
+    }
+
+    if ((found.size() != 3) ||
+        (found[0].id != "1") || (found[0].height != 10) ||
+        (found[1].id != "2") || (found[1].height != 10) ||
+        (found[2].id != "66") || (found[2].height != 11)) {
+        LOG_ERROR() << "unexpected solutions found: " << found.size();
+        ++nErrors;
+    }
+
+    server->stop();
+    return nErrors;
+}
+
 } //namespace
 
 int main() {
@@ -116,6 +298,7 @@ int main() {
     auto logger = Logger::create(logLevel, logLevel);
     auto res = json_creation_test();
     gen_examples();
+    res += live_jobs_test();
     return res;
 }
 
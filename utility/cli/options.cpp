@@ -144,6 +144,9 @@ namespace beam
         const char* MINING_THREADS = "mining_threads";
         const char* POW_SOLVE_TIME = "pow_solve_time";
         const char* VERIFICATION_THREADS = "verification_threads";
+        const char* HDR_SYNC_PACKS = "hdr_sync_packs";
+        const char* COMPACT_BLOCKS = "compact_blocks";
+        const char* LISTEN_THREADS = "listen_threads";
         const char* NONCEPREFIX_DIGITS = "nonceprefix_digits";
         const char* NODE_PEER = "peer";
         const char* NODE_PEERS_PERSISTENT = "peers_persistent";
@@ -344,6 +347,7 @@ namespace beam
         const char* PUBLIC_OFFLINE      = "public_offline";
         const char* ENABLE_LELANTUS     = "enable_lelantus";
         const char* SEND_OFFLINE        = "offline";
+        const char* PROOF_THREADS       = "proof_threads";
 
         // shaders
         const char* SHADER_INVOKE       = "shader";
@@ -399,6 +403,9 @@ namespace beam
             (cli::POW_SOLVE_TIME, po::value<uint32_t>()->default_value(15 * 1000), "pow solve time. It works if FakePoW is enabled")
 
             (cli::VERIFICATION_THREADS, po::value<int>()->default_value(-1), "number of threads for cryptographic verifications (0 = single thread, -1 = auto)")
+            (cli::HDR_SYNC_PACKS, po::value<uint32_t>()->default_value(1), "max header packs downloaded concurrently from different peers (1 = sequential download)")
+            (cli::COMPACT_BLOCKS, po::value<bool>()->default_value(false), "request new blocks in a compact form, restore them from the transaction pool")
+            (cli::LISTEN_THREADS, po::value<uint32_t>()->default_value(0), "number of threads that accept and handle the inbound connections (0 = main thread only)")
             (cli::NONCEPREFIX_DIGITS, po::value<unsigned>()->default_value(0), "number of hex digits for nonce prefix for stratum client (0..6)")
             (cli::NODE_PEER, po::value<vector<string>>()->multitoken(), "nodes to connect to")
             (cli::NODE_PEERS_PERSISTENT, po::value<bool>()->default_value(false), "Keep persistent connection to the specified peers, regardless to ratings")
@@ -474,7 +481,8 @@ namespace beam
             (cli::OFFLINE_COUNT, po::value<Positive<uint32_t>>(), "generate offline transaction address with given number of payments")
             (cli::PUBLIC_OFFLINE, po::bool_switch()->default_value(false), "generate an offline public address for donates (less secure, but more convenient)")
             (cli::SEND_OFFLINE, po::bool_switch()->default_value(false), "send an offline payment (offline transaction)")
-            (cli::BLOCK_HEIGHT, po::value<Nonnegative<Height>>(), "block height");
+            (cli::BLOCK_HEIGHT, po::value<Nonnegative<Height>>(), "block height")
+            (cli::PROOF_THREADS, po::value<uint32_t>()->default_value(0), "number of threads for the proofs generation (0 - number of cores, 1 - no extra threads)");
 
         po::options_description wallet_treasury_options("Wallet treasury options");
         wallet_treasury_options.add_options()
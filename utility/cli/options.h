@@ -42,6 +42,9 @@ namespace beam
         extern const char* MINING_THREADS;
         extern const char* POW_SOLVE_TIME;
         extern const char* VERIFICATION_THREADS;
+        extern const char* HDR_SYNC_PACKS;
+        extern const char* COMPACT_BLOCKS;
+        extern const char* LISTEN_THREADS;
         extern const char* NONCEPREFIX_DIGITS;
         extern const char* NODE_PEER;
         extern const char* NODE_PEERS_PERSISTENT;
@@ -245,6 +248,7 @@ namespace beam
         extern const char* PUBLIC_OFFLINE;
         extern const char* ENABLE_LELANTUS;
         extern const char* SEND_OFFLINE;
+        extern const char* PROOF_THREADS;
 
         // shaders
         extern const char* SHADER_INVOKE;
@@ -63,6 +63,11 @@ public:
 		return _stream->state().unsent;
 	}
 
+	/// Calls back (once) when the unsent data size drops to the given mark
+	void notify_drained(size_t mark, io::TcpStream::DrainCallback&& callback) {
+		_stream->notify_drained(mark, std::move(callback));
+	}
+
 protected:
     /// Ctor. Attaches connected tcp stream
     BaseConnection(Direction d, io::TcpStream::Ptr&& stream) :
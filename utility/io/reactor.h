@@ -161,7 +161,7 @@ private:
     ErrorCode start_timer(Object* o, unsigned intervalMsec, bool isPeriodic, uv_timer_cb cb);
     void cancel_timer(Object* o);
 
-    ErrorCode init_tcpserver(Object* o, Address bindAddress, uv_connection_cb cb);
+    ErrorCode init_tcpserver(Object* o, Address bindAddress, uv_connection_cb cb, bool reusePort = false);
     ErrorCode init_tcpstream(Object* o);
     ErrorCode accept_tcpstream(Object* acceptor, Object* newConnection);
     TcpStream* stream_connected(TcpStream* stream, uv_handle_t* h);
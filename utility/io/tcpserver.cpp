@@ -17,14 +17,22 @@
 
 namespace beam { namespace io {
 
-TcpServer::Ptr TcpServer::create(Reactor& reactor, Address bindAddress, Callback&& callback) {
+TcpServer::Ptr TcpServer::create(Reactor& reactor, Address bindAddress, Callback&& callback, bool reusePort) {
     assert(callback);
     if (!callback)
         IO_EXCEPTION(EC_EINVAL);
-    return Ptr(new TcpServer(std::move(callback), reactor, bindAddress));
+    return Ptr(new TcpServer(std::move(callback), reactor, bindAddress, reusePort));
 }
 
-TcpServer::TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress) :
+bool TcpServer::is_reuse_port_supported() {
+#ifdef SO_REUSEPORT
+    return true;
+#else
+    return false;
+#endif
+}
+
+TcpServer::TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress, bool reusePort) :
     _callback(std::move(callback))
 {
     ErrorCode errorCode = reactor.init_tcpserver(
@@ -34,7 +42,8 @@ TcpServer::TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress)
             assert(handle);
             TcpServer* s = reinterpret_cast<TcpServer*>(handle->data);
             if (s) s->on_accept(ErrorCode(errorCode));
-        }
+        },
+        reusePort
     );
     IO_EXCEPTION_IF(errorCode);
 }
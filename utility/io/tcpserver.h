@@ -25,13 +25,18 @@ public:
     /// Either newStream is accepted or status != 0
     using Callback = std::function<void(TcpStream::Ptr&& newStream, ErrorCode status)>;
 
-    /// Creates the server and starts listening
-    static Ptr create(Reactor& reactor, Address bindAddress, Callback&& callback);
+    /// Creates the server and starts listening.
+    /// If reusePort is set - several servers (typically on different reactors) may listen on the same address,
+    /// the kernel distributes the incoming connections between them (SO_REUSEPORT, not supported on Windows)
+    static Ptr create(Reactor& reactor, Address bindAddress, Callback&& callback, bool reusePort = false);
+
+    /// True if the platform supports reusePort
+    static bool is_reuse_port_supported();
 
     virtual ~TcpServer() = default;
 
 protected:
-    TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress);
+    TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress, bool reusePort = false);
 
     virtual void on_accept(ErrorCode errorCode);
 
@@ -55,17 +55,6 @@ Result TcpStream::enable_read(const TcpStream::Callback& callback) {
 
     alloc_read_buffer();
 
-    static uv_alloc_cb read_alloc_cb = [](
-        uv_handle_t* handle,
-        size_t /*suggested_size*/,
-        uv_buf_t* buf
-    ) {
-        TcpStream* self = reinterpret_cast<TcpStream*>(handle->data);
-        if (self) {
-            *buf = self->_readBuffer;
-        }
-    };
-
     ErrorCode errorCode = (ErrorCode)uv_read_start((uv_stream_t*)_handle, read_alloc_cb, read_cb);
     if (errorCode != 0) {
         _callback = Callback();
@@ -88,6 +77,21 @@ void TcpStream::disable_read() {
     free_read_buffer();
 }
 
+void TcpStream::pause_read(bool pause) {
+    if (!is_connected() || !_callback) return;
+    int errorCode = pause ?
+        uv_read_stop((uv_stream_t*)_handle) :
+        uv_read_start((uv_stream_t*)_handle, read_alloc_cb, read_cb);
+    if (errorCode) {
+        LOG_DEBUG() << "pause_read failed,code=" << errorCode;
+    }
+}
+
+void TcpStream::notify_drained(size_t mark, DrainCallback&& callback) {
+    _drainMark = mark;
+    _onDrained = std::move(callback);
+}
+
 Result TcpStream::write(const SharedBuffer& buf, bool flush) {
     if (!is_connected()) return make_unexpected(EC_ENOTCONN);
     _writeBuffer.append(buf);
@@ -148,6 +152,13 @@ void TcpStream::on_data_written(ErrorCode errorCode, size_t n) {
         _state.sent += n;
         assert(_state.unsent >= n);
         _state.unsent -= n;
+
+        if (_onDrained && (_state.unsent <= _drainMark)) {
+            DrainCallback cb;
+            cb.swap(_onDrained);
+            cb(); // may delete this
+            return;
+        }
     }
     LOG_DEBUG() << __FUNCTION__ << TRACE(n) << TRACE(_state.unsent) << TRACE(_state.sent) << TRACE(_state.received);
 }
@@ -172,6 +183,13 @@ Address TcpStream::peer_address() const {
     return Address(sa);
 }
 
+void TcpStream::read_alloc_cb(uv_handle_t* handle, size_t /*suggested_size*/, uv_buf_t* buf) {
+    TcpStream* self = reinterpret_cast<TcpStream*>(handle->data);
+    if (self) {
+        *buf = self->_readBuffer;
+    }
+}
+
 void TcpStream::read_cb(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf) {
     TcpStream* self = reinterpret_cast<TcpStream*>(handle->data);
 
@@ -48,6 +48,14 @@ public:
     /// Disables listening to data and events
     void disable_read();
 
+    /// Temporarily stops/resumes reading. Unlike disable_read() the callback is retained, so that write errors are still reported
+    void pause_read(bool pause);
+
+    using DrainCallback = std::function<void()>;
+
+    /// Calls back (once) when the unsent data size drops to the given mark
+    void notify_drained(size_t mark, DrainCallback&& callback);
+
     /// Writes raw data, returns status code
     Result write(const void* data, size_t size, bool flush=true) {
         return write(SharedBuffer(data, size), flush);
@@ -88,6 +96,7 @@ protected:
 
 private:
     static void read_cb(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf);
+    static void read_alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
 
     friend class TcpServer;
     friend class SslServer;
@@ -106,6 +115,8 @@ private:
     uv_buf_t _readBuffer={0, 0};
     BufferChain _writeBuffer;
     Callback _callback;
+    DrainCallback _onDrained;
+    size_t _drainMark=0;
     State _state;
     Reactor::OnDataWritten _onDataWritten;
 };
@@ -249,6 +249,13 @@ namespace
 
         auto walletDB = WalletDB::open(walletPath, pass);
 
+        if (vm.count(cli::PROOF_THREADS))
+        {
+            auto pKeyKeeper = std::dynamic_pointer_cast<LocalPrivateKeyKeeper2>(walletDB->get_KeyKeeper());
+            if (pKeyKeeper)
+                pKeyKeeper->set_ProofThreads(vm[cli::PROOF_THREADS].as<uint32_t>());
+        }
+
         auto assetsSICreator = [] (const TxParameters& txParams) {
             return std::make_shared<AssetTxStatusInterpreter>(txParams);
         };
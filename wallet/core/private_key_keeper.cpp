@@ -174,11 +174,94 @@ namespace beam::wallet
 
 	////////////////////////////////
 	// PrivateKeyKeeper_AsyncNotify
+	template <typename TMethod>
+	void PrivateKeyKeeper_AsyncNotify::InvokeAsyncInternal(TMethod& m, const Handler::Ptr& pHandler)
+	{
+		ParallelJob job;
+		Executor* pExec = get_ParallelJobAny(m, job);
+		if (pExec)
+		{
+			InvokeParallel(*pExec, std::move(job), pHandler);
+			return;
+		}
+
+		// executed right now, but the completion is reported after the preceding ones
+		Status::Type res = InvokeSync(m);
+
+		{
+			std::unique_lock<std::mutex> scope(m_MutexOut);
+			if (!m_quePending.empty())
+			{
+				Task::Ptr pTask = std::make_unique<TaskPending>();
+				pTask->m_pHandler = pHandler;
+				Cast::Up<TaskPending>(*pTask).m_Status = res;
+				Cast::Up<TaskPending>(*pTask).m_Done = true;
+				m_quePending.Push(pTask);
+				return;
+			}
+		}
+
+		PushOut(res, pHandler);
+	}
+
+	void PrivateKeyKeeper_AsyncNotify::InvokeParallel(Executor& exec, ParallelJob&& job, const Handler::Ptr& pHandler)
+	{
+		EnsureEvtOut(); // would be posted from the executor thread
+
+		Task::Ptr pTask = std::make_unique<TaskPending>();
+		pTask->m_pHandler = pHandler;
+		TaskPending& tp = Cast::Up<TaskPending>(*pTask);
+
+		{
+			std::unique_lock<std::mutex> scope(m_MutexOut);
+			m_quePending.Push(pTask);
+		}
+
+		struct MyTask :public Executor::TaskAsync
+		{
+			PrivateKeyKeeper_AsyncNotify* m_pThis; // only the members of this base are accessed
+			ParallelJob m_Job;
+			TaskPending* m_pPending;
+
+			virtual void Exec(Executor::Context&) override
+			{
+				Status::Type res = m_Job();
+				m_pThis->OnPendingDone(*m_pPending, res);
+			}
+		};
+
+		auto pExecTask = std::make_unique<MyTask>();
+		pExecTask->m_pThis = this;
+		pExecTask->m_Job = std::move(job);
+		pExecTask->m_pPending = &tp;
+
+		exec.Push(std::move(pExecTask));
+	}
+
+	void PrivateKeyKeeper_AsyncNotify::OnPendingDone(TaskPending& tp, Status::Type res)
+	{
+		std::unique_lock<std::mutex> scope(m_MutexOut);
+
+		tp.m_Status = res;
+		tp.m_Done = true;
+
+		bool bPost = false;
+		while (!m_quePending.empty() && Cast::Up<TaskPending>(m_quePending.front()).m_Done)
+		{
+			Task::Ptr pTask;
+			m_quePending.Pop(pTask);
+			if (m_queOut.Push(pTask))
+				bPost = true;
+		}
+
+		if (bPost)
+			m_pNewOut->post();
+	}
+
 #define THE_MACRO(method) \
 	void PrivateKeyKeeper_AsyncNotify::InvokeAsync(Method::method& m, const Handler::Ptr& p) \
 	{ \
-		Status::Type res = InvokeSync(m); \
-		PushOut(res, p); \
+		InvokeAsyncInternal(m, p); \
 	}
 
 	KEY_KEEPER_METHODS(THE_MACRO)
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "common.h"
+#include "utility/executor.h"
 #include <boost/intrusive/list.hpp>
 
 namespace beam::wallet
@@ -253,6 +254,31 @@ namespace beam::wallet
 		KEY_KEEPER_METHODS(THE_MACRO)
 #undef THE_MACRO
 
+	protected:
+		// Outputs may be created in parallel (their bulletproofs are the most expensive part), on the executor owned by the keeper.
+		// The job runs on the executor thread, and must not access the keeper, which may be already partially destroyed by then.
+		// The keeper must stop its executor before this base is destroyed. The completion is reported in the invocation order anyway.
+		typedef std::function<Status::Type()> ParallelJob;
+		virtual Executor* get_ParallelJob(Method::CreateOutput&, ParallelJob&) { return nullptr; }
+
+	private:
+		struct TaskPending
+			:public TaskFin
+		{
+			bool m_Done = false;
+		};
+
+		TaskList m_quePending; // completion not reported yet, in order. Protected by m_MutexOut
+
+		template <typename TMethod>
+		Executor* get_ParallelJobAny(TMethod&, ParallelJob&) { return nullptr; }
+		Executor* get_ParallelJobAny(Method::CreateOutput& m, ParallelJob& job) { return get_ParallelJob(m, job); }
+
+		template <typename TMethod>
+		void InvokeAsyncInternal(TMethod& m, const Handler::Ptr& pHandler);
+		void InvokeParallel(Executor&, ParallelJob&&, const Handler::Ptr& pHandler);
+
+		void OnPendingDone(TaskPending&, Status::Type);
 	};
 
 	class ThreadedPrivateKeyKeeper
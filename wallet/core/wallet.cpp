@@ -635,16 +635,157 @@ namespace beam::wallet
         MyRequestShieldedList::Ptr pVal(new MyRequestShieldedList);
         pVal->m_callback = std::move(callback);
         pVal->m_TxID = txId;
+        pVal->m_Wnd0 = startIndex;
+        pVal->m_WndCount = count;
 
-        pVal->m_Msg.m_Id0 = startIndex;
-        pVal->m_Msg.m_Count = count;
-
-        if (PostReqUnique(*pVal))
+        if (PostShieldedListReq(*pVal, false))
         {
             LOG_INFO() << txId << " Get shielded list, start_index = " << startIndex << ", count = " << count;
         }
     }
 
+    bool Wallet::PostShieldedListReq(MyRequestShieldedList& r, bool bDirect)
+    {
+        typedef MyRequestShieldedList::Stage Stage;
+
+        r.m_Stage = Stage::Direct;
+        r.m_Msg.m_Id0 = r.m_Wnd0;
+        r.m_Msg.m_Count = r.m_WndCount;
+
+        if (!bDirect && r.m_WndCount)
+        {
+            auto& c = m_ShieldedListCache;
+            c.Load(*m_WalletDB);
+
+            TxoID nWndEnd = r.m_Wnd0 + r.m_WndCount;
+
+            if ((r.m_Wnd0 < c.m_Id0) || (r.m_Wnd0 > c.get_End()))
+            {
+                if (r.m_Wnd0)
+                {
+                    // the cached run is unrelated. Start a new one, get the state right before the window first
+                    r.m_Stage = Stage::Anchor;
+                    r.m_Msg.m_Id0 = r.m_Wnd0 - 1;
+                    r.m_Msg.m_Count = 1;
+
+                    return PostReqUnique(r);
+                }
+
+                c.Reset(*m_WalletDB, 0, Zero);
+            }
+
+            TxoID nEnd = c.get_End();
+            if (nWndEnd > nEnd)
+            {
+                r.m_Stage = Stage::Tail;
+                r.m_Msg.m_Id0 = nEnd;
+                r.m_Msg.m_Count = static_cast<uint32_t>(nWndEnd - nEnd);
+            }
+            else
+            {
+                // the window is already cached, just make sure the node agrees on its state
+                r.m_Stage = Stage::Probe;
+                r.m_Msg.m_Id0 = nWndEnd - 1;
+                r.m_Msg.m_Count = 1;
+            }
+        }
+
+        return PostReqUnique(r);
+    }
+
+    void Wallet::OnShieldedListReady(MyRequestShieldedList& r)
+    {
+        const auto& c = m_ShieldedListCache;
+        assert((c.m_Id0 <= r.m_Wnd0) && (r.m_Wnd0 < c.get_End()));
+
+        TxoID nEnd = std::min(r.m_Wnd0 + r.m_WndCount, c.get_End());
+
+        proto::ShieldedList msg;
+        msg.m_Items.assign(
+            c.m_vItems.begin() + static_cast<size_t>(r.m_Wnd0 - c.m_Id0),
+            c.m_vItems.begin() + static_cast<size_t>(nEnd - c.m_Id0));
+
+        c.get_State(msg.m_State1, nEnd);
+
+        r.m_callback(r.m_Wnd0, r.m_WndCount, msg);
+    }
+
+    const char Wallet::ShieldedListCache::s_szDbName[] = "ShieldedListCache";
+
+    void Wallet::ShieldedListCache::get_State(ECC::Hash::Value& hv, TxoID nEnd) const
+    {
+        assert((nEnd >= m_Id0) && (nEnd <= get_End()));
+
+        hv = m_State0;
+        for (size_t i = 0; i < nEnd - m_Id0; i++)
+            ShieldedTxo::UpdateState(hv, m_vItems[i]);
+    }
+
+    void Wallet::ShieldedListCache::Reset(IWalletDB& db, TxoID id0, const ECC::Hash::Value& hvState0)
+    {
+        m_Id0 = id0;
+        m_State0 = hvState0;
+        m_vItems.clear();
+
+        db.deleteShieldedListFrom(0);
+        storage::setBlobVar(db, s_szDbName, *this);
+    }
+
+    void Wallet::ShieldedListCache::Append(IWalletDB& db, const ECC::Point::Storage* pItems, size_t nCount)
+    {
+        if (!nCount)
+            return;
+
+        db.insertShieldedList(get_End(), pItems, nCount);
+        m_vItems.insert(m_vItems.end(), pItems, pItems + nCount);
+    }
+
+    void Wallet::ShieldedListCache::Truncate(IWalletDB& db, TxoID nEnd)
+    {
+        assert(nEnd >= m_Id0);
+        if (nEnd >= get_End())
+            return;
+
+        db.deleteShieldedListFrom(nEnd);
+        m_vItems.resize(static_cast<size_t>(nEnd - m_Id0));
+    }
+
+    void Wallet::ShieldedListCache::Trim(IWalletDB& db, TxoID nKeep0)
+    {
+        // no need to keep more than the node would send at once
+        size_t nMax = static_cast<size_t>(Rules::get().Shielded.m_ProofMax.get_N()) * 2;
+        if (m_vItems.size() <= nMax)
+            return;
+
+        size_t n = std::min(m_vItems.size() - nMax, static_cast<size_t>(nKeep0 - m_Id0));
+        if (!n)
+            return;
+
+        for (size_t i = 0; i < n; i++)
+            ShieldedTxo::UpdateState(m_State0, m_vItems[i]);
+
+        m_vItems.erase(m_vItems.begin(), m_vItems.begin() + n);
+        m_Id0 += n;
+
+        db.deleteShieldedListBelow(m_Id0);
+        storage::setBlobVar(db, s_szDbName, *this);
+    }
+
+    void Wallet::ShieldedListCache::Load(const IWalletDB& db)
+    {
+        if (m_Loaded)
+            return;
+
+        m_Loaded = true;
+        if (storage::getBlobVar(db, s_szDbName, *this))
+            db.loadShieldedList(m_Id0, m_vItems);
+        else
+        {
+            m_Id0 = 0;
+            m_State0 = Zero;
+        }
+    }
+
     void Wallet::get_proof_shielded_output(const TxID& txId, const ECC::Point& serialPublic, ProofShildedOutputCallback&& callback)
     {
         MyRequestProofShieldedOutp::Ptr pVal(new MyRequestProofShieldedOutp);
@@ -1147,7 +1288,134 @@ namespace beam::wallet
 
     void Wallet::OnRequestComplete(MyRequestShieldedList& r)
     {
-        r.m_callback(r.m_Msg.m_Id0, r.m_Msg.m_Count, r.m_Res);
+        typedef MyRequestShieldedList::Stage Stage;
+
+        auto& c = m_ShieldedListCache;
+        const auto& msg = r.m_Res;
+        Stage::Enum eNext = Stage::Direct;
+
+        switch (r.m_Stage)
+        {
+        case Stage::Direct:
+            r.m_callback(r.m_Wnd0, r.m_WndCount, r.m_Res);
+            return;
+
+        case Stage::Resync:
+            OnShieldedListResync(r);
+            r.m_callback(r.m_Wnd0, r.m_WndCount, r.m_Res);
+            return;
+
+        case Stage::Anchor:
+            if (1 == msg.m_Items.size())
+            {
+                c.Reset(*m_WalletDB, r.m_Wnd0, msg.m_State1);
+                eNext = Stage::Tail;
+            }
+            break;
+
+        case Stage::Tail:
+            // the cache may have been modified meanwhile by other txs, in this case don't bother
+            if (!msg.m_Items.empty() && (c.get_End() == r.m_Msg.m_Id0) && (c.m_Id0 <= r.m_Wnd0))
+            {
+                ECC::Hash::Value hv;
+                c.get_State(hv, r.m_Msg.m_Id0);
+
+                for (const auto& x : msg.m_Items)
+                    ShieldedTxo::UpdateState(hv, x);
+
+                if (hv == msg.m_State1)
+                {
+                    c.Append(*m_WalletDB, &msg.m_Items.front(), msg.m_Items.size());
+                    c.Trim(*m_WalletDB, r.m_Wnd0);
+
+                    OnShieldedListReady(r);
+                    return;
+                }
+
+                eNext = Stage::Resync;
+            }
+            break;
+
+        case Stage::Probe:
+            if ((1 == msg.m_Items.size()) && (c.m_Id0 <= r.m_Wnd0) && (r.m_Msg.m_Id0 < c.get_End()))
+            {
+                ECC::Hash::Value hv;
+                c.get_State(hv, r.m_Msg.m_Id0 + 1);
+
+                if (hv == msg.m_State1)
+                {
+                    OnShieldedListReady(r);
+                    return;
+                }
+
+                eNext = Stage::Resync;
+            }
+            break;
+
+        default:
+            assert(false);
+        }
+
+        MyRequestShieldedList::Ptr pVal(new MyRequestShieldedList);
+        pVal->m_callback = std::move(r.m_callback);
+        pVal->m_TxID = r.m_TxID;
+        pVal->m_Wnd0 = r.m_Wnd0;
+        pVal->m_WndCount = r.m_WndCount;
+
+        if (Stage::Resync == eNext)
+        {
+            // the cache disagrees with the node. Get the whole window, it'll be compared with the cached elements
+            pVal->m_Stage = Stage::Resync;
+            pVal->m_Msg.m_Id0 = r.m_Wnd0;
+            pVal->m_Msg.m_Count = r.m_WndCount;
+
+            PostReqUnique(*pVal);
+        }
+        else
+            PostShieldedListReq(*pVal, Stage::Direct == eNext);
+    }
+
+    void Wallet::OnShieldedListResync(MyRequestShieldedList& r)
+    {
+        auto& c = m_ShieldedListCache;
+        const auto& v = r.m_Res.m_Items;
+
+        if (!v.empty() && (c.m_Id0 <= r.m_Wnd0) && (r.m_Wnd0 <= c.get_End()))
+        {
+            ECC::Hash::Value hv;
+            c.get_State(hv, r.m_Wnd0);
+
+            for (const auto& x : v)
+                ShieldedTxo::UpdateState(hv, x);
+
+            if (hv == r.m_Res.m_State1)
+            {
+                // the cached elements below the window are consistent with the node. Keep them, and those in the window that match
+                TxoID nEnd = std::min(c.get_End(), r.m_Wnd0 + v.size());
+                TxoID id = r.m_Wnd0;
+
+                for (; id < nEnd; id++)
+                {
+                    const ECC::Point::Storage& a = c.m_vItems[static_cast<size_t>(id - c.m_Id0)];
+                    const ECC::Point::Storage& b = v[static_cast<size_t>(id - r.m_Wnd0)];
+                    if ((a.m_X != b.m_X) || (a.m_Y != b.m_Y))
+                        break;
+                }
+
+                if (id < c.get_End())
+                    LOG_WARNING() << r.m_TxID << " Shielded list cache diverged from the node at " << id << ", " << (c.get_End() - id) << " elements dropped";
+
+                size_t nSkip = static_cast<size_t>(id - r.m_Wnd0);
+
+                c.Truncate(*m_WalletDB, id);
+                c.Append(*m_WalletDB, v.data() + nSkip, v.size() - nSkip);
+                c.Trim(*m_WalletDB, r.m_Wnd0);
+                return;
+            }
+        }
+
+        LOG_WARNING() << r.m_TxID << " Shielded list cache is inconsistent with the node, dropped";
+        c.Reset(*m_WalletDB, 0, Zero);
     }
 
     void Wallet::OnRequestComplete(MyRequestProofShieldedOutp& r)
@@ -1372,7 +1640,18 @@ namespace beam::wallet
         der.reset(b.m_Eternal);
         der& Cast::Down<TxVectors::Eternal>(block);
         PreprocessBlock(block);
-        recognizer.Recognize(block, h, 0, false);
+
+        if (Executor::s_pInstance || (block.m_vOutputs.size() <= 1))
+            recognizer.Recognize(block, h, 0, false);
+        else
+        {
+            if (!m_pRecognizeExecutor)
+                m_pRecognizeExecutor = std::make_unique<ExecutorMT_R>();
+
+            Executor::Scope scope(*m_pRecognizeExecutor);
+            recognizer.Recognize(block, h, 0, false);
+        }
+
         SetEventsHeight(h);
     }
 
@@ -1541,11 +1820,34 @@ namespace beam::wallet
 
     void Wallet::OnRequestComplete(MyRequestEvents& r)
     {
+        // 1st pass: filter-out false positive UTXOs, all at once
+        struct MyVerifier
+            :public proto::Event::IGroupParser
+        {
+            std::vector<CoinID> m_vCid;
+            std::vector<ECC::Point> m_vComm;
+
+            virtual void OnEventType(proto::Event::Utxo& evt) override
+            {
+                m_vCid.push_back(evt.m_Cid);
+                m_vComm.push_back(evt.m_Commitment);
+            }
+
+        } v;
+
+        v.Proceed(r.m_Res.m_Events);
+
+        uint32_t nUtxos = static_cast<uint32_t>(v.m_vCid.size());
+        std::unique_ptr<bool[]> pMatch(new bool[nUtxos]);
+        if (nUtxos)
+            m_WalletDB->IsRecoveredMatchBatch(&v.m_vCid.front(), &v.m_vComm.front(), nUtxos, pMatch.get());
+
         struct MyParser
             :public proto::Event::IGroupParser
         {
             Wallet& m_This;
-            MyParser(Wallet& x) :m_This(x) {}
+            const bool* m_pMatch;
+            MyParser(Wallet& x, const bool* pMatch) :m_This(x), m_pMatch(pMatch) {}
 
             virtual void OnEventType(proto::Event::Shielded& evt) override
             {
@@ -1559,10 +1861,11 @@ namespace beam::wallet
 
             virtual void OnEventType(proto::Event::Utxo& evt) override
             {
-                m_This.ProcessEventUtxo(evt, m_Height);
+                if (*m_pMatch++)
+                    m_This.ProcessEventUtxoMatched(evt, m_Height);
             }
 
-        } p(*this);
+        } p(*this, pMatch.get());
 
         uint32_t nCount = p.Proceed(r.m_Res.m_Events);
 
@@ -1599,6 +1902,11 @@ namespace beam::wallet
         if (!m_WalletDB->IsRecoveredMatch(cid, evt.m_Commitment))
             return;
 
+        ProcessEventUtxoMatched(evt, h);
+    }
+
+    void Wallet::ProcessEventUtxoMatched(const proto::Event::Utxo& evt, Height h)
+    {
         bool bAdd = 0 != (proto::Event::Flags::Add & evt.m_Flags);
         CacheCommitment(evt.m_Commitment, evt.m_Maturity, bAdd);
         ProcessEventUtxo(evt.m_Cid, h, evt.m_Maturity, bAdd, evt.m_User);
@@ -241,6 +241,7 @@ namespace beam::wallet
         void RequestEvents();
         void AbortEvents();
         void ProcessEventUtxo(const proto::Event::Utxo& utxoEvt, Height h);
+        void ProcessEventUtxoMatched(const proto::Event::Utxo& utxoEvt, Height h);
         void ProcessEventUtxo(const CoinID&, Height h, Height hMaturity, bool bAdd, const Output::User& user);
         void ProcessEventAsset(const proto::Event::AssetCtl& assetCtl, Height h);
         void SetEventsHeight(Height);
@@ -327,6 +328,20 @@ namespace beam::wallet
             {
                 TxID m_TxID = { 0 };
                 ShieldedListCallback m_callback;
+                TxoID m_Wnd0 = 0; // the window requested by the tx, the message may cover only a part of it
+                uint32_t m_WndCount = 0;
+
+                struct Stage {
+                    enum Enum {
+                        Direct, // the whole window, bypassing the cache
+                        Anchor, // the element before the window, to get the shielded state the cache starts from
+                        Tail, // elements beyond the cached run
+                        Probe, // the last element of the window, to verify the cached state
+                        Resync, // the whole window, after the cache disagreed with the node. Used to find the divergence point
+                    };
+                };
+
+                Stage::Enum m_Stage = Stage::Direct;
             };
             struct ShieldedOutputsAt
             {
@@ -405,6 +420,9 @@ namespace beam::wallet
 #undef REQUEST_Cmp_less_Single
 #undef REQUEST_Cmp_less_Multiple
 
+        bool PostShieldedListReq(MyRequestShieldedList&, bool bDirect);
+        void OnShieldedListReady(MyRequestShieldedList&);
+        void OnShieldedListResync(MyRequestShieldedList&);
 
         IWalletDB::Ptr m_WalletDB; 
         
@@ -475,5 +493,36 @@ namespace beam::wallet
         bool m_IsTreasuryHandled = false;
         std::map<ECC::Point, Height> m_Commitments;
         bool m_IsCommitmentsCached = false;
+        std::unique_ptr<ExecutorMT_R> m_pRecognizeExecutor; // created on demand, for parallel outputs recovery
+
+        // Shielded elements fetched for the spend proofs, a contiguous run starting at m_Id0.
+        // Kept in the wallet db (the elements are rows keyed by TxoID, only the changes are written),
+        // and checked against the shielded state reported by the node, so that consecutive spends only download the elements that were not seen yet.
+        struct ShieldedListCache
+        {
+            static const char s_szDbName[];
+
+            TxoID m_Id0 = 0;
+            ECC::Hash::Value m_State0 = Zero; // shielded state right before m_Id0
+            std::vector<ECC::Point::Storage> m_vItems;
+            bool m_Loaded = false;
+
+            template <typename Archive>
+            void serialize(Archive& ar)
+            {
+                ar
+                    & m_Id0
+                    & m_State0;
+            }
+
+            TxoID get_End() const { return m_Id0 + m_vItems.size(); }
+            void get_State(ECC::Hash::Value&, TxoID nEnd) const; // state after the element nEnd-1
+            void Reset(IWalletDB&, TxoID id0, const ECC::Hash::Value& hvState0);
+            void Append(IWalletDB&, const ECC::Point::Storage*, size_t nCount);
+            void Truncate(IWalletDB&, TxoID nEnd); // drop the elements starting from nEnd
+            void Trim(IWalletDB&, TxoID nKeep0); // drop the oldest elements above the limit, but not those starting from nKeep0
+            void Load(const IWalletDB&);
+
+        } m_ShieldedListCache;
     };
 }
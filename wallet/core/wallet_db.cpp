@@ -152,6 +152,10 @@ namespace fs = std::filesystem;
 #define TblStates_Height     "Height"
 #define TblStates_Hdr        "State"
 
+#define TblShieldedList         "ShieldedList"
+#define TblShieldedList_ID      "ID"
+#define TblShieldedList_Value   "Value"
+
 #define ENUM_LASER_CHANNEL_FIELDS(each, sep, obj) \
     each(chID,             chID,             BLOB NOT NULL PRIMARY KEY, obj) sep \
     each(myWID,            myWID,            BLOB NOT NULL, obj) sep \
@@ -992,7 +996,8 @@ namespace beam::wallet
         const uint8_t kDefaultMaxPrivacyLockTimeLimitHours = 72;
         const int BusyTimeoutMs = 5000;
 
-        const int DbVersion   = 32;
+        const int DbVersion   = 33;
+        const int DbVersion32 = 32;
         const int DbVersion31 = 31;
         const int DbVersion30 = 30;
         const int DbVersion29 = 29;
@@ -1259,6 +1264,15 @@ namespace beam::wallet
             throwIfError(ret, db);
         }
 
+        void CreateShieldedListTable(sqlite3* db)
+        {
+            const char* req = "CREATE TABLE [" TblShieldedList "] ("
+                "[" TblShieldedList_ID     "] INTEGER NOT NULL PRIMARY KEY,"
+                "[" TblShieldedList_Value  "] BLOB NOT NULL)";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
         void CreateLaserTables(sqlite3* db)
         {
             const char* req = "CREATE TABLE " LASER_CHANNELS_NAME " (" ENUM_LASER_CHANNEL_FIELDS(LIST_WITH_TYPES, COMMA, ) ") WITHOUT ROWID;";
@@ -1705,6 +1719,14 @@ namespace beam::wallet
             }
         }
 
+        void MigrateFrom32(WalletDB* walletDB, sqlite3* db)
+        {
+            if (!IsTableCreated(walletDB, TblShieldedList))
+            {
+                CreateShieldedListTable(db);
+            }
+        }
+
         void OpenAndMigrateIfNeeded(const string& path, sqlite3** db, const SecString& password)
         {
             int ret = sqlite3_open_v2(path.c_str(), db, SQLITE_OPEN_READWRITE, nullptr);
@@ -1812,6 +1834,7 @@ namespace beam::wallet
         CreateAddressesTable(db, ADDRESSES_NAME);
         CreateTxParamsTable(db);
         CreateStatesTable(db);
+        CreateShieldedListTable(db);
         CreateLaserTables(db);
         CreateAssetsTable(db);
         CreateShieldedCoinsTable(db);
@@ -2343,6 +2366,11 @@ namespace beam::wallet
                     LOG_INFO() << "Converting DB from format 31...";
                     MigrateFrom31(walletDB.get(), walletDB->_db);
                     // no break
+
+                case DbVersion32:
+                    LOG_INFO() << "Converting DB from format 32...";
+                    MigrateFrom32(walletDB.get(), walletDB->_db);
+                    // no break
                     storage::setVar(*walletDB, Version, DbVersion);
 
                 case DbVersion:
@@ -2644,6 +2672,49 @@ namespace beam::wallet
         return (comm2 == comm);
     }
 
+    void IWalletDB::IsRecoveredMatchBatch(CoinID* pCid, const ECC::Point* pComm, uint32_t nCount, bool* pRes)
+    {
+        Key::IPKdf::Ptr pOwner = get_OwnerKdf();
+        assert(pOwner); // must always be available
+
+        const uint32_t nChunk = 64;
+        ECC::Hash::Value pHv[nChunk];
+        ECC::Point::Native pPkG[nChunk], pPkJ[nChunk];
+        uint32_t pIdx[nChunk];
+
+        for (uint32_t i0 = 0; i0 < nCount; )
+        {
+            uint32_t n = 0;
+            for ( ; (i0 < nCount) && (n < nChunk); i0++)
+            {
+                Key::Index idx;
+                if (pCid[i0].get_ChildKdfIndex(idx))
+                    pRes[i0] = IsRecoveredMatch(pCid[i0], pComm[i0]); // child kdf is required
+                else
+                {
+                    pCid[i0].get_Hash(pHv[n]);
+                    pIdx[n++] = i0;
+                }
+            }
+
+            if (!n)
+                continue;
+
+            pOwner->DerivePKeyJBatch(pPkJ, pHv, n);
+            pOwner->DerivePKeyGBatch(pPkG, pHv, n);
+
+            for (uint32_t j = 0; j < n; j++)
+            {
+                uint32_t i = pIdx[j];
+                CoinID::Worker(pCid[i]).Recover(pPkG[j], pPkJ[j]);
+
+                ECC::Point comm2 = pPkG[j];
+                // mismatch is rare (false positive, or Bb21 workaround). Re-check it the regular way
+                pRes[i] = (comm2 == pComm[i]) || IsRecoveredMatch(pCid[i], pComm[i]);
+            }
+        }
+    }
+
 	void IWalletDB::ImportRecovery(const std::string& path, INegotiatorGateway& gateway)
 	{
 		IRecoveryProgress prog;
@@ -5377,6 +5448,56 @@ namespace beam::wallet
         }
     }
 
+    void WalletDB::insertShieldedList(TxoID id0, const ECC::Point::Storage* pItems, size_t nCount)
+    {
+        const char* req = "INSERT OR REPLACE INTO " TblShieldedList " (" TblShieldedList_ID "," TblShieldedList_Value ") VALUES(?,?)";
+        sqlite::Statement stm(this, req);
+
+        for (size_t i = 0; i < nCount; i++)
+        {
+            if (i)
+                stm.Reset();
+
+            stm.bind(1, id0 + i);
+            stm.bind(2, pItems + i, sizeof(*pItems));
+            stm.step();
+        }
+    }
+
+    void WalletDB::loadShieldedList(TxoID id0, std::vector<ECC::Point::Storage>& v) const
+    {
+        const char* req = "SELECT " TblShieldedList_ID "," TblShieldedList_Value " FROM " TblShieldedList " WHERE " TblShieldedList_ID ">=? ORDER BY " TblShieldedList_ID;
+        sqlite::Statement stm(this, req);
+        stm.bind(1, id0);
+
+        v.clear();
+        while (stm.step())
+        {
+            TxoID id;
+            stm.get(0, id);
+            if (id != id0 + v.size())
+                break; // must be contiguous
+
+            stm.getBlobStrict(1, &v.emplace_back(), sizeof(ECC::Point::Storage));
+        }
+    }
+
+    void WalletDB::deleteShieldedListFrom(TxoID id)
+    {
+        const char* req = "DELETE FROM " TblShieldedList " WHERE " TblShieldedList_ID ">=?";
+        sqlite::Statement stm(this, req);
+        stm.bind(1, id);
+        stm.step();
+    }
+
+    void WalletDB::deleteShieldedListBelow(TxoID id)
+    {
+        const char* req = "DELETE FROM " TblShieldedList " WHERE " TblShieldedList_ID "<?";
+        sqlite::Statement stm(this, req);
+        stm.bind(1, id);
+        stm.step();
+    }
+
     std::vector<OutgoingWalletMessage> WalletDB::getWalletMessages() const
     {
         std::vector<OutgoingWalletMessage> messages;
@@ -439,6 +439,7 @@ namespace beam::wallet
 		void ImportRecovery(const std::string& path, INegotiatorGateway& gateway);
 
         bool IsRecoveredMatch(CoinID&, const ECC::Point& comm);
+        void IsRecoveredMatchBatch(CoinID*, const ECC::Point* pComm, uint32_t nCount, bool* pRes); // root kdf coins are verified in a batch
         bool get_CommitmentSafe(ECC::Point& comm, const CoinID&);
 
         void get_SbbsPeerID(ECC::Scalar::Native&, PeerID&, uint64_t ownID);
@@ -567,6 +568,12 @@ namespace beam::wallet
         virtual Block::SystemState::IHistory& get_History() = 0;
         virtual void ShrinkHistory() = 0;
 
+        // Shielded elements cached for the spend proofs, keyed by their TxoID
+        virtual void insertShieldedList(TxoID id0, const ECC::Point::Storage*, size_t nCount) = 0;
+        virtual void loadShieldedList(TxoID id0, std::vector<ECC::Point::Storage>&) const = 0; // contiguous run, starting from id0
+        virtual void deleteShieldedListFrom(TxoID) = 0; // this and above
+        virtual void deleteShieldedListBelow(TxoID) = 0;
+
         // ///////////////////////////////
         // Message management
         virtual std::vector<OutgoingWalletMessage> getWalletMessages() const = 0;
@@ -734,6 +741,11 @@ namespace beam::wallet
         Block::SystemState::IHistory& get_History() override;
         void ShrinkHistory() override;
 
+        void insertShieldedList(TxoID id0, const ECC::Point::Storage*, size_t nCount) override;
+        void loadShieldedList(TxoID id0, std::vector<ECC::Point::Storage>&) const override;
+        void deleteShieldedListFrom(TxoID) override;
+        void deleteShieldedListBelow(TxoID) override;
+
         std::vector<OutgoingWalletMessage> getWalletMessages() const override;
         uint64_t saveWalletMessage(const WalletID&, const Blob&) override;
         void deleteWalletMessage(uint64_t id) override;
@@ -2456,6 +2456,120 @@ namespace
         WALLET_CHECK(txHistory[0].m_status == wallet::TxStatus::Completed);
     }
 
+    void TestShieldedListCache()
+    {
+        cout << "\nTesting shielded list cache...\n";
+
+        io::Reactor::Ptr mainReactor{ io::Reactor::create() };
+        io::Reactor::Scope scope(*mainReactor);
+
+        TestNode node;
+
+        auto fnRandomize = [&node](size_t i0)
+        {
+            for (size_t i = i0; i < node.m_vShieldedPool.size(); i++)
+            {
+                ECC::Scalar::Native k;
+                k.GenRandomNnz();
+                ECC::Point::Native pt = ECC::Context::get().G * k;
+                pt.Export(node.m_vShieldedPool[i]);
+            }
+        };
+
+        node.m_vShieldedPool.resize(60);
+        fnRandomize(0);
+
+        auto pRig = std::make_unique<TestWalletRig>(createSenderWalletDB());
+        IWalletDB::Ptr pDB = pRig->m_WalletDB;
+
+        uint32_t nReqs = 0;
+        uint64_t nItems = 0;
+
+        auto fnFetch = [&](TxoID id0, uint32_t nCount, uint32_t nReqsExpected, uint64_t nItemsExpected)
+        {
+            bool bDone = false;
+
+            INegotiatorGateway& gw = *pRig->m_Wallet;
+            gw.get_shielded_list(TxID{}, id0, nCount, [&](TxoID id0Res, uint32_t nCountRes, proto::ShieldedList& msg)
+            {
+                WALLET_CHECK((id0Res == id0) && (nCountRes == nCount));
+                WALLET_CHECK(msg.m_Items.size() == nCount);
+
+                ECC::Hash::Value hv = Zero;
+                for (size_t i = 0; i < id0 + msg.m_Items.size(); i++)
+                {
+                    const ECC::Point::Storage& pt = node.m_vShieldedPool[i];
+                    ShieldedTxo::UpdateState(hv, pt);
+
+                    if (i >= id0)
+                    {
+                        const ECC::Point::Storage& ptRes = msg.m_Items[i - id0];
+                        WALLET_CHECK((ptRes.m_X == pt.m_X) && (ptRes.m_Y == pt.m_Y));
+                    }
+                }
+                WALLET_CHECK(hv == msg.m_State1);
+
+                bDone = true;
+                mainReactor->stop();
+            });
+
+            mainReactor->run();
+            WALLET_CHECK(bDone);
+
+            WALLET_CHECK(node.m_ShieldedListRequests - nReqs == nReqsExpected);
+            WALLET_CHECK(node.m_ShieldedListItemsSent - nItems == nItemsExpected);
+            nReqs = node.m_ShieldedListRequests;
+            nItems = node.m_ShieldedListItemsSent;
+        };
+
+        auto fnCheckDB = [&](TxoID id0, TxoID nEnd)
+        {
+            std::vector<ECC::Point::Storage> v;
+            if (id0)
+            {
+                pDB->loadShieldedList(id0 - 1, v);
+                WALLET_CHECK(v.empty()); // nothing below the anchor
+            }
+
+            pDB->loadShieldedList(id0, v);
+            WALLET_CHECK(v.size() == nEnd - id0);
+
+            for (size_t i = 0; i < v.size(); i++)
+            {
+                const ECC::Point::Storage& pt = node.m_vShieldedPool[id0 + i];
+                WALLET_CHECK((v[i].m_X == pt.m_X) && (v[i].m_Y == pt.m_Y));
+            }
+        };
+
+        fnFetch(10, 20, 2, 21); // anchor + the window
+        fnCheckDB(10, 30);
+
+        fnFetch(15, 20, 1, 5); // only the tail
+        fnCheckDB(10, 35);
+
+        fnFetch(12, 10, 1, 1); // cached, probe only
+
+        // the cache is reloaded from the db
+        pRig = std::make_unique<TestWalletRig>(pDB);
+        fnFetch(12, 10, 1, 1);
+
+        // reorg: the elements starting from 32 are changed. Only those are dropped
+        fnRandomize(32);
+        fnFetch(20, 20, 2, 25); // tail mismatch, the whole window to find the divergence point
+        fnCheckDB(10, 40);
+
+        fnFetch(20, 20, 1, 1);
+
+        // deep reorg, below the window. The cache can't be trusted, it's dropped
+        fnRandomize(11);
+        fnFetch(20, 5, 2, 6); // probe mismatch, the window
+        fnCheckDB(0, 0);
+        fnCheckDB(10, 10);
+
+        fnFetch(20, 5, 2, 6); // a new run
+        fnCheckDB(20, 25);
+    }
+
     void TestCalculateCoinsSelection()
     {
         cout << "\nTesting coins selection...\n";
@@ -3231,6 +3345,134 @@ void TestKeyKeeper(IPrivateKeyKeeper2::Ptr externalKeyKeeper = {}, size_t index
     WALLET_CHECK(tx.IsValid(ctx));
 }
 
+void TestKeyKeeperParallelOutputs()
+{
+    cout << "\nTesting key keeper parallel outputs creation...\n";
+
+    io::Reactor::Ptr mainReactor{ io::Reactor::create() };
+    io::Reactor::Scope scope(*mainReactor);
+
+    Key::IKdf::Ptr pKdf;
+    HKdf::Create(pKdf, 7788U);
+
+    auto pKk = std::make_shared<LocalPrivateKeyKeeperStd>(pKdf);
+    pKk->set_ProofThreads(4);
+
+    struct MyHandler
+        :public IPrivateKeyKeeper2::Handler
+    {
+        std::vector<uint32_t>* m_pOrder;
+        uint32_t m_Idx;
+        uint32_t m_Total;
+
+        void OnDone(IPrivateKeyKeeper2::Status::Type n) override
+        {
+            WALLET_CHECK(IPrivateKeyKeeper2::Status::Success == n);
+            m_pOrder->push_back(m_Idx);
+            if (m_pOrder->size() == m_Total)
+                io::Reactor::get_Current().stop();
+        }
+    };
+
+    const uint32_t nOutputs = 8;
+    std::vector<IPrivateKeyKeeper2::Method::CreateOutput> vOuts(nOutputs);
+    IPrivateKeyKeeper2::Method::get_Kdf mKdf;
+    mKdf.m_Root = true;
+
+    std::vector<uint32_t> vOrder;
+
+    auto fnHandler = [&vOrder](uint32_t iIdx)
+    {
+        auto p = std::make_shared<MyHandler>();
+        p->m_pOrder = &vOrder;
+        p->m_Idx = iIdx;
+        p->m_Total = nOutputs + 1;
+        return p;
+    };
+
+    for (uint32_t i = 0; i < nOutputs; i++)
+    {
+        auto& m = vOuts[i];
+        m.m_hScheme = Rules::get().pForks[1].m_Height;
+        m.m_Cid = CoinID(100 + i, 15 + i, Key::Type::Regular);
+        pKk->InvokeAsync(m, fnHandler(i));
+
+        if (nOutputs / 2 == i)
+            pKk->InvokeAsync(mKdf, fnHandler(nOutputs)); // synchronous method in the middle
+    }
+
+    mainReactor->run();
+
+    // completion is reported in the invocation order
+    WALLET_CHECK(vOrder.size() == nOutputs + 1);
+    for (uint32_t i = 0; i < vOrder.size(); i++)
+        WALLET_CHECK(vOrder[i] == ((i <= nOutputs / 2) ? i : (i == nOutputs / 2 + 1) ? nOutputs : i - 1));
+
+    for (uint32_t i = 0; i < nOutputs; i++)
+    {
+        const auto& m = vOuts[i];
+        WALLET_CHECK(m.m_pResult);
+
+        Point::Native comm;
+        CoinID::Worker(m.m_Cid).Recover(comm, *pKdf);
+        WALLET_CHECK(comm == m.m_pResult->m_Commitment);
+
+        ECC::Point::Native pt;
+        WALLET_CHECK(m.m_pResult->IsValid(m.m_hScheme, pt));
+    }
+
+    {
+        // destroy the keeper while the outputs are still being created
+        struct MyKeeper
+            :public LocalPrivateKeyKeeperStd
+        {
+            using LocalPrivateKeyKeeperStd::LocalPrivateKeyKeeperStd;
+
+            std::unique_ptr<bool> m_pTrustless = std::make_unique<bool>(false); // destroyed before the base
+            bool IsTrustless() override { return *m_pTrustless; }
+        };
+
+        struct MyHandler2
+            :public IPrivateKeyKeeper2::Handler
+        {
+            uint32_t* m_pDone;
+            void OnDone(IPrivateKeyKeeper2::Status::Type) override { (*m_pDone)++; }
+        };
+
+        auto pKk2 = std::make_shared<MyKeeper>(pKdf);
+        pKk2->set_ProofThreads(2);
+
+        uint32_t nDone = 0;
+        std::vector<IPrivateKeyKeeper2::Method::CreateOutput> vOuts2(nOutputs * 2);
+
+        for (uint32_t i = 0; i < vOuts2.size(); i++)
+        {
+            auto& m = vOuts2[i];
+            m.m_hScheme = Rules::get().pForks[1].m_Height;
+            m.m_Cid = CoinID(200 + i, 15 + i, Key::Type::Regular);
+
+            auto pHandler = std::make_shared<MyHandler2>();
+            pHandler->m_pDone = &nDone;
+            pKk2->InvokeAsync(m, pHandler);
+        }
+
+        pKk2.reset();
+        WALLET_CHECK(!nDone); // not reported after destruction
+
+        // those that were already running are complete
+        for (uint32_t i = 0; i < vOuts2.size(); i++)
+        {
+            const auto& m = vOuts2[i];
+            if (m.m_pResult)
+            {
+                Point::Native comm;
+                CoinID::Worker(m.m_Cid).Recover(comm, *pKdf);
+                WALLET_CHECK(comm == m.m_pResult->m_Commitment);
+            }
+        }
+    }
+}
+
 void TestVouchers()
 {
     cout << "\nTesting wallets vouchers exchange...\n";
@@ -3821,6 +4063,7 @@ int main()
     //GenerateTreasury(100, 100, 100000000);
     TestTxList();
     TestKeyKeeper();
+    TestKeyKeeperParallelOutputs();
 
     TestVouchers();
 
@@ -3886,6 +4129,7 @@ int main()
     Rules::get().UpdateChecksum();
 
     TestSendingShielded();
+    TestShieldedListCache();
     TestCalculateCoinsSelection();
     TestCalculateAssetCoinsSelection();
 
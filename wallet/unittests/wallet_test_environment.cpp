@@ -194,6 +194,11 @@ public:
     Block::SystemState::IHistory& get_History() override { return m_Hist; }
     void ShrinkHistory() override {}
 
+    void insertShieldedList(TxoID, const ECC::Point::Storage*, size_t) override {}
+    void loadShieldedList(TxoID, std::vector<ECC::Point::Storage>& v) const override { v.clear(); }
+    void deleteShieldedListFrom(TxoID) override {}
+    void deleteShieldedListBelow(TxoID) override {}
+
 protected:
     std::vector<Coin> m_coins;
     std::map<wallet::TxParameterID, ByteBuffer> m_params;
@@ -1040,6 +1045,8 @@ public:
 
     TestBlockchain m_Blockchain;
     std::vector<ECC::Point::Storage> m_vShieldedPool;
+    uint32_t m_ShieldedListRequests = 0;
+    uint64_t m_ShieldedListItemsSent = 0;
 
     void AddBlock()
     {
@@ -1209,8 +1216,15 @@ private:
 
                 msgOut.m_Items.resize(n);
                 std::copy(v.begin() + msg.m_Id0, v.begin() + msg.m_Id0 + n, msgOut.m_Items.begin());
+
+                msgOut.m_State1 = Zero;
+                for (size_t i = 0; i < msg.m_Id0 + n; i++)
+                    ShieldedTxo::UpdateState(msgOut.m_State1, v[i]);
+
+                m_This.m_ShieldedListItemsSent += n;
             }
 
+            m_This.m_ShieldedListRequests++;
             Send(msgOut);
         }
 